@@ -0,0 +1,43 @@
+#include <algorithm>
+#include <benchmark/compat.h>
+#include <map>
+#include <string>
+#include <vector>
+
+static void BM_Copy(benchmark::State &state) {
+    std::vector<char> from((size_t)state.range(0), 'x'), to((size_t)state.range(0));
+    for (auto _ : state) {
+        std::copy(from.begin(), from.end(), to.begin());
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Copy)->RangeMultiplier(8)->Range(64, 64 << 10);
+
+template<typename Map>
+static void BM_MapLookup(benchmark::State &state) {
+    Map map;
+    for (int64_t i = 0; i < state.range(0); i++)
+        map[(int)i] = (int)i;
+    int key = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(map.find(key));
+        key = (key + 7) % (int)state.range(0);
+    }
+}
+BENCHMARK_TEMPLATE(BM_MapLookup, std::map<int, int>)->Arg(16)->Arg(4096);
+
+static void BM_StringAppend(benchmark::State &state, const std::string &piece) {
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::string s;
+        state.ResumeTiming();
+        for (int i = 0; i < 16; i++)
+            s += piece;
+        benchmark::DoNotOptimize(s);
+    }
+}
+BENCHMARK_CAPTURE(BM_StringAppend, short, std::string("ab"));
+BENCHMARK_CAPTURE(BM_StringAppend, long, std::string(40, 'a'));
+
+BENCHMARK_MAIN();
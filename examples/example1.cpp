@@ -1,7 +1,9 @@
+#include <algorithm>
 #include <atomic>
 #include <benchmark/benchmark.h>
 #include <mutex>
 #include <list>
+#include <unordered_set>
 #include <vector>
 
 #ifdef WIN32
@@ -37,37 +39,122 @@ BENCHMARK(SSO)
     )
 }
 
-BENCHMARK(ListTraversal)
+BENCHMARK_TEMPLATE(Traversal, std::list<int>, std::vector<int>)
 {
     ADD_ARG_RANGE(8, 1024);
-    std::list<int> l;
-    for (int i = 0; i < ARG1; i++)
-        l.push_back(i % 16);
+    T container;
+    for (uint64_t value : state.dataset(benchmark::data::Uniform(ARG1, 0, 15)))
+        container.push_back((int)value);
 
     MEASURE(
-        for (auto it = l.begin(), iend = l.end(); it != iend; ++it) {
+        for (auto it = container.begin(), iend = container.end(); it != iend; ++it) {
             int n = *it;
             benchmark::DoNotOptimize(n);
         }
     )
 }
 
-BENCHMARK(VectorTraversal)
+BENCHMARK(ListBuild)
 {
-    ADD_ARG_RANGE(8, 1024);
-    std::vector<int> v;
-    for (int i = 0; i < ARG1; i++)
-        v.push_back(i % 16);
+    ALLOCATORS(benchmark::AllocatorSystem, benchmark::AllocatorArena, benchmark::AllocatorPool)
+    ADD_ARG_RANGE(64, 4096);
+    using List = std::list<int, benchmark::Allocator<int>>;
+    MEASURE(
+        List list(state.allocator<int>());
+        for (int i = 0; i < ARG1; i++)
+            list.push_back(i);
+        benchmark::DoNotOptimize(list.back());
+    )
+}
+
+BENCHMARK(HashLookup)
+{
+    ADD_ARG_RANGE(1024, 65536);
+    auto &data = state.dataset(benchmark::data::KeySet(ARG1, 4096, 0.9));
+    auto &hot = state.dataset(benchmark::data::Zipf(4096, 1.1, ARG1));
+    std::unordered_set<uint64_t> set(data.keys.begin(), data.keys.end());
+    set.insert(hot.begin(), hot.end());
 
+    size_t found = 0;
     MEASURE(
-        for (auto it = v.begin(), iend = v.end(); it != iend; ++it) {
-            int n = *it;
-            benchmark::DoNotOptimize(n);
-        }
+        for (uint64_t key : data.lookups)
+            found += set.count(key);
+        for (uint64_t key : hot)
+            found += set.count(key);
+    )
+    benchmark::DoNotOptimize(found);
+}
+
+BENCHMARK(MultiplyLatency)
+{
+    MEASURE_LATENCY(64, 1ull, [](unsigned long long x) { return x * 0x9E3779B97F4A7C15ull; })
+}
+
+BENCHMARK(MultiplyThroughput)
+{
+    MEASURE_THROUGHPUT(64, 1ull, [](unsigned long long x) { return x * 0x9E3779B97F4A7C15ull; })
+}
+
+BENCHMARK(TableLookup)
+{
+    NUMA_PLACEMENTS(benchmark::PlaceLocal, benchmark::PlaceRemote, benchmark::PlaceInterleave)
+    std::vector<unsigned, benchmark::Allocator<unsigned>> table(1 << 21, 1u, state.allocator<unsigned>());
+
+    unsigned index = 0;
+    MEASURE(
+        REPEAT(1024) { index = (index * 1103515245u + 12345u + table[index & (table.size() - 1)]) & 0x7fffffff; }
     )
+    benchmark::DoNotOptimize(index);
 }
 
-#ifdef UNIX
+BENCHMARK(PageWalk)
+{
+    PAGE_BACKINGS(benchmark::Backing4K, benchmark::BackingTHP, benchmark::BackingHuge2M)
+    std::vector<unsigned, benchmark::Allocator<unsigned>> table(1 << 22, 1u, state.allocator<unsigned>());
+
+    // a new 4K page for nearly every load, so the TLB misses dominate
+    unsigned index = 0;
+    MEASURE(
+        REPEAT(1024) { index = (index * 1103515245u + 12345u + table[(index << 10) & (table.size() - 1)]) & 0x7fffffff; }
+    )
+    benchmark::DoNotOptimize(index);
+}
+
+BENCHMARK(SearchLinear)
+{
+    ADD_ARG_RANGE(16, 256);
+    auto &values = state.dataset(benchmark::data::Ordered(ARG1, benchmark::data::OrderSorted));
+    auto &keys = state.dataset(benchmark::data::Uniform(1024, 0, ARG1 - 1));
+
+    size_t found = 0;
+    MEASURE(
+        for (uint64_t key : keys)
+            found += (size_t)(std::find_if(values.begin(), values.end(), [&](uint64_t v) { return v >= values[key]; }) - values.begin());
+    )
+    benchmark::DoNotOptimize(found);
+}
+
+BENCHMARK(SearchBinary)
+{
+    ADD_ARG_RANGE(16, 256);
+    auto &values = state.dataset(benchmark::data::Ordered(ARG1, benchmark::data::OrderSorted));
+    auto &keys = state.dataset(benchmark::data::Uniform(1024, 0, ARG1 - 1));
+
+    size_t found = 0;
+    MEASURE(
+        for (uint64_t key : keys)
+            found += (size_t)(std::lower_bound(values.begin(), values.end(), values[key]) - values.begin());
+    )
+    benchmark::DoNotOptimize(found);
+}
+
+// interleaved, so that the verdict doesn't depend on which of them ran while the machine was busier
+BENCHMARK_COMPARE(SearchLinear, SearchBinary)
+
+// and side by side at the end, with the speedup of the binary search for every size
+BENCHMARK_GROUP(Search, SearchLinear, SearchBinary)
+
+#ifndef WIN32
 BENCHMARK(SyscallGetTime)
 {
     timespec ts;
@@ -76,7 +163,4 @@ BENCHMARK(SyscallGetTime)
 }
 #endif
 
-int main()
-{
-    RUN_BENCHMARKS
-}
+BENCHMARK_MAIN
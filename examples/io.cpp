@@ -0,0 +1,109 @@
+#include <benchmark/benchmark.h>
+#include <benchmark/detail/file_io.h>
+#include <cstdint>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+
+// a file on disk, large enough that random blocks don't stay in the CPU caches
+static const size_t FileSize = 256 << 20;
+
+BENCHMARK(ReadSequential)
+{
+    ADD_ARG_RANGE(4096, 1 << 20);
+    auto &file = state.dataset(benchmark::data::File(FileSize));
+    benchmark::IoJob job(benchmark::IoPread, benchmark::IoSequential, ARG1, 16);
+    MEASURE_IO(job, file)
+}
+
+BENCHMARK(ReadRandomWarm)
+{
+    auto &file = state.dataset(benchmark::data::File(FileSize));
+    benchmark::IoJob job(benchmark::IoPread, benchmark::IoRandom, 4096, 256);
+    MEASURE_IO(job, file)
+}
+
+// the page cache dropped before every sample, every read goes to the device
+BENCHMARK(ReadRandomCold)
+{
+    auto &file = state.dataset(benchmark::data::File(FileSize));
+    benchmark::IoJob job(benchmark::IoPread, benchmark::IoRandom, 4096, 256);
+    file.dropCache();
+    MEASURE_IO(job, file)
+}
+
+BENCHMARK(ReadRandomMmapCold)
+{
+    auto &file = state.dataset(benchmark::data::File(FileSize));
+    benchmark::IoJob job(benchmark::IoMmap, benchmark::IoRandom, 4096, 256);
+    file.dropCache();
+    MEASURE_IO(job, file)
+}
+
+// queue depth 1 to 32, nothing is read where the file system doesn't support O_DIRECT
+BENCHMARK(ReadRandomDirect)
+{
+    ADD_ARG_RANGE(1, 32);
+    auto &file = state.dataset(benchmark::data::File(FileSize));
+    benchmark::IoJob job(benchmark::IoDirect, benchmark::IoRandom, 4096, 256, ARG1);
+    MEASURE_IO(job, file)
+}
+
+BENCHMARK(WriteSequentialTmpfs)
+{
+    auto &file = state.dataset(benchmark::data::File(FileSize, benchmark::FileOnTmpfs));
+    benchmark::IoJob job(benchmark::IoPread, benchmark::IoSequential, 65536, 16, 1, benchmark::IoWrite);
+    MEASURE_IO(job, file)
+}
+
+// one write and fdatasync per sample, the distribution is the commit latency: run with --percentiles 50,90,99
+BENCHMARK(FsyncLatency)
+{
+    auto &file = state.dataset(benchmark::data::File(16 << 20));
+    benchmark::IoJob job(benchmark::IoPread, benchmark::IoRandom, 4096, 1, 1, benchmark::IoWriteSync);
+    MEASURE_IO(job, file)
+}
+
+// vDSO, no switch to the kernel
+BENCHMARK(ClockGetTimeMonotonic)
+{
+    timespec ts;
+    MEASURE(REPEAT(100) { clock_gettime(CLOCK_MONOTONIC, &ts); benchmark::DoNotOptimize(ts); })
+    state.setOperations(100);
+}
+
+BENCHMARK(GetTimeOfDay)
+{
+    timeval tv;
+    MEASURE(REPEAT(100) { gettimeofday(&tv, nullptr); benchmark::DoNotOptimize(tv); })
+    state.setOperations(100);
+}
+
+// a real system call, the CPU time of the process isn't in the vDSO
+BENCHMARK(ClockGetTimeProcessCpu)
+{
+    timespec ts;
+    MEASURE(REPEAT(100) { clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts); benchmark::DoNotOptimize(ts); })
+    state.setOperations(100);
+}
+
+// the cheapest round trip to the kernel, syscall() bypasses any caching of the C library
+BENCHMARK(SyscallGetPid)
+{
+    MEASURE(REPEAT(100) { long pid = syscall(SYS_getpid); benchmark::DoNotOptimize(pid); })
+    state.setOperations(100);
+}
+
+BENCHMARK(ReadDevZero)
+{
+    static int fd = open("/dev/zero", O_RDONLY);
+    char byte;
+    MEASURE(REPEAT(100) { ssize_t ret = read(fd, &byte, 1); benchmark::DoNotOptimize(ret); })
+    state.setOperations(100);
+}
+
+BENCHMARK_MAIN
@@ -0,0 +1,62 @@
+#include <benchmark/zone.h>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// a stand-in for production code, instrumented with zones
+
+static std::vector<std::string> tokenize(const std::string &text)
+{
+    BENCHMARK_ZONE("tokenize");
+    std::vector<std::string> tokens;
+    std::string current;
+    for (char c : text) {
+        if (c == ' ') {
+            tokens.push_back(current);
+            current.clear();
+        } else {
+            current += c;
+        }
+    }
+    tokens.push_back(current);
+    return tokens;
+}
+
+static size_t handleRequest(const std::string &request)
+{
+    BENCHMARK_ZONE("request");
+    size_t total = 0;
+    for (auto &token : tokenize(request))
+        total += token.size();
+
+    if (std::rand() % 10 == 0) { // a slow path
+        BENCHMARK_ZONE("slow path");
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+    return total;
+}
+
+int main()
+{
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 4; t++) {
+        workers.emplace_back([]() {
+            std::string request = "GET /index.html HTTP/1.1 Host: example.com";
+            size_t total = 0;
+            for (int i = 0; i < 1000; i++)
+                total += handleRequest(request);
+            std::cout << (total ? "" : "\n");
+        });
+    }
+    for (auto &worker : workers)
+        worker.join();
+
+#ifdef BENCHMARK_ENABLE_ZONES
+    benchmark::zones::Collector collector;
+    collector.collect();
+    collector.print(std::cout);
+#endif
+    return 0;
+}
@@ -1,23 +1,42 @@
 #pragma once
 
-#include <algorithm>
 #include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <type_traits>
 #include <vector>
-#include <cmath>
-#include <mutex>
-#include <thread>
-#include <iostream>
-#include <iomanip>
 #include "detail/config.h"
 #include "detail/dont_optimize.h"
+#include "detail/arena.h"
 #include "detail/benchmark_setup.h"
+#include "detail/calibration.h"
+#include "detail/chrono_utils.h"
+#include "detail/comparison_table.h"
+#include "detail/dataset.h"
+#include "detail/layout.h"
+#include "detail/memory_resource.h"
+#include "detail/paired_comparison.h"
+#include "detail/results.h"
 #include "detail/state.h"
 #include "detail/statistics.h"
-#include "detail/cpu_info.h"
-#include "detail/colorization.h"
-#include "detail/chrono_utils.h"
+#include "detail/steady_state.h"
+#include "detail/topology.h"
+#include "detail/unroll.h"
+
+namespace benchmark {
+namespace detail {
 
-#include <sys/resource.h>
+class Antagonists;
+class EnergyMeter;
+class PageResource;
+class SampleDump;
+class TraceWriter;
+struct CoreLatencyMatrix;
+struct CPUStats;
+
+}} //namespaces
 
 /*
 Usage:
@@ -41,146 +60,207 @@ class Benchmark {
     std::string _name;
     BenchmarkSetup _setup;
 
+    // benchmarks of the same group are printed side by side in a table, under their labels, with the speedups over
+    // the baseline
+    std::string _group;
+    std::string _groupLabel;
+    bool _groupBaseline{false};
+    std::vector<benchmark::detail::BenchmarkResult> _results;
+
     TimeStatistics _stats;
     unsigned _totalIterations;
 
     unsigned Iterations;
 
-    benchmark::duration_t _noopTime{0};
+    uint64_t _operationsPerSample{0};
+    uint64_t _bytesPerSample{0};
+
+    // state.setCounter() values of the block, averaged over the samples that set them
+    struct CounterSum {
+        std::string name;
+        double sum;
+        unsigned samples;
+    };
+    std::vector<CounterSum> _counterSums;
+
+    benchmark::detail::TraceWriter *_trace{nullptr};
+    benchmark::detail::SampleDump *_dump{nullptr};
+
+    std::unique_ptr<benchmark::detail::PageResource> _pages;
+    std::unique_ptr<benchmark::MemoryResource> _strategy; // the heap or a pool on top of _pages, none for the arena
+    benchmark::MemoryResource *_memory{nullptr};          // what state.memory() returns
+    std::string _memoryLabel; // shown in the title when the memory isn't configured the default way
+    std::string _pagesLabel;  // placement and pages, whatever the allocation strategy
+    std::vector<int> _unpinnedAffinity; // of the thread before the block pinned it, empty if it isn't pinned
+
+    benchmark::detail::DatasetCache _datasets;
+    std::unique_ptr<benchmark::detail::EnergyMeter> _energy; // with --energy only
+    std::unique_ptr<benchmark::detail::Antagonists> _antagonists; // for the block of samples under an antagonist
+    std::string _antagonistLabel;
+    bool _antagonistIdle{false}; // a kind with no cpu to run on, the block is as quiet as the baseline
+
+    // the block of samples under a randomized memory layout, with --layouts or LAYOUTS
+    benchmark::detail::MemoryLayout _layout{0, 0, 0, 0};
+    std::unique_ptr<char[]> _heapGap;
+    std::unique_ptr<benchmark::MemoryResource> _offsetMemory; // state.memory() moved by the data offset
+    std::string _layoutLabel;
+
+    std::ostream *_out;
+    std::string _partition; // cores it runs on in the parallel mode
+    bool _exclusive{false};
+
+    benchmark::detail::SteadyStateDetector _steadyState;
+    unsigned _warmupSamples{0};
+    benchmark::duration_t _warmupTime{0};
+    bool _steadyStateMissed{false};
+
+    benchmark::detail::TimerCalibration _calibration{};
+
+    // the block of samples run() is in
+    std::chrono::steady_clock::time_point _blockStartTime{};
+    unsigned _sampleIndex{0};
+    uint32_t _dumpBlock{0};
+    std::unique_ptr<benchmark::detail::CPUStats> _cpuStatsBefore; // with a trace only
+    benchmark::time_point_t _traceBlockStart{};
+    size_t _allocationsBefore{0}; // of state.memory() when the sample started, with a trace only
+    size_t _allocatedBytesBefore{0};
 
 public:
     Benchmark(const char *name_ = "")
             : Benchmark(BenchmarkSetup(), name_) {
     }
 
-    Benchmark(const BenchmarkSetup &setup_, const char *name_ = "")
-            : _name(name_), _setup(setup_), _totalIterations(0), Iterations(200) {
-        // clock's now() takes longer when called first time
-        auto init_timer = benchmark::clock_t::now();
-        benchmark::DoNotOptimize(init_timer);
+    Benchmark(const BenchmarkSetup &setup_, const char *name_ = "");
 
-        static bool onlyOnce = false;
-        if (!onlyOnce) {
-            onlyOnce = true;
-            printCPULoad();
-        }
-    }
+    virtual ~Benchmark();
 
-    ~Benchmark() {
-    }
+    void setSetup(const BenchmarkSetup &setup_);
 
-    void warmupCpu() {
-        static bool onlyOnce = false;
-        if (onlyOnce) // not supposed to be thread-safe, that's fine
-            return;
-        onlyOnce = true;
+    void configureStatistics();
 
-        std::cout << benchmark::detail::ColorLightRed
-                  << "Warning: CPU power-safe mode enabled. Will try to warm up before the benchmark."
-                  << benchmark::detail::ColorReset
-                  << std::endl;
+    void warmupCpu();
 
-        static const auto WarmupTime = std::chrono::seconds(4);
+    void calibrateTimer() {
+        _calibration = benchmark::detail::calibrateTimer();
+    }
 
-        auto start = benchmark::clock_t::now(); // do nothing serious for N seconds cycle
-        while (true) {
-            unsigned p = rand();
-            benchmark::DoNotOptimize(p);
-            if (benchmark::clock_t::now() - start > WarmupTime)
-                break;
-        }
+    virtual void vrun() {
     }
 
-    void findNoopTime() {
-        _noopTime = std::chrono::nanoseconds(9999);
-        for (int i = 0; i < 20; i++) {
-            auto d = benchmark::clock_t::now() - benchmark::clock_t::now();
-            if (d < _noopTime) {
-                _noopTime = d;
-            }
-        }
+    // one sample of the body, for runners which interleave the samples of several benchmarks
+    virtual void vsample(benchmark::detail::RunState &) {
     }
 
-    virtual void vrun() {
+    // a variant of this BENCHMARK_COMPARE, which doesn't run on its own then
+    virtual bool compares(const std::string &) const {
+        return false;
     }
 
+    // a result of a block in a dimension compared to its first value, ALLOCATORS or the antagonists, or one of the
+    // layouts
+    struct StrategyResult {
+        std::string strategy;
+        std::string row;
+        benchmark::detail::BenchmarkResult result;
+        benchmark::detail::ListKind dimension;
+        bool measured; // false for an antagonist with no cpu to run on, n/a in the table
+    };
+
     template<typename F>
     void run(F &&func) {
 #ifdef _DEBUG
 #pragma message("Warning: Benchmark library is being compiled in a Debug configuration.")
-        static std::once_flag warnDebugMode;
-        std::call_once(warnDebugMode, [](){ std::cout << "Warning: Running in a Debug configuration" << std::endl; });
 #endif
-        if (!_setup.skipWarmup) {
-            if (benchmark::detail::isCPUScalingEnabled()) {
-                warmupCpu(); // TODO: check if it really works
-            }
-        }
+        benchmark::detail::BenchmarkState bs;
+        beginRun(bs);
+
+        std::vector<StrategyResult> strategyResults;
+
+        while (bs.running()) {
+            beginBlock(bs);
 
-        int ret = setpriority(PRIO_PROCESS, 0, -20);
-        if (ret == -1) {
-            std::cout << "Couldn't to set priority (code " << errno << "), try to run with administrator privileges" << std::endl;
+            benchmark::detail::withStackOffset(_layout.stack, [&]() {
+                for (unsigned i = 0; i < Iterations;) {
+                    benchmark::detail::RunState state(bs, _calibration.overhead);
+                    beginSample(state);
+
+                    state.start();
+                    func(state);
+                    state.stop();
+
+                    if (!endSample(state, bs, i))
+                        break;
+                }
+            });
+
+            endBlock(bs, strategyResults);
         }
+        endRun(strategyResults);
+    }
 
-        findNoopTime();
+    // everything of run() but the samples themselves, out of line so that the loop above stays small
+    void beginRun(benchmark::detail::BenchmarkState &bs);
+    void beginBlock(benchmark::detail::BenchmarkState &bs);
+    void beginSample(benchmark::detail::RunState &state);
+    // false when the block is over; 'counted' goes up for samples past the warm-up
+    bool endSample(const benchmark::detail::RunState &state, benchmark::detail::BenchmarkState &bs, unsigned &counted);
+    void endBlock(benchmark::detail::BenchmarkState &bs, std::vector<StrategyResult> &strategyResults);
+    void endRun(const std::vector<StrategyResult> &strategyResults);
 
-        if (_setup.outputStyle == BenchmarkSetup::OutputStyle::Full)
-            std::cout << "[Benchmark '" << _name << "'] started" << std::endl;
+    void discardWarmup();
 
-        benchmark::detail::BenchmarkState bs;
+    std::string sampleLabel(benchmark::detail::BenchmarkState &bs);
 
-        while (bs.running()) {
-            bool firstRun = true;
-            _totalIterations = 0;
-            auto startTime = std::chrono::steady_clock::now();
+    // a new resource for every argument block, so that nothing is left from the previous one
+    void configureMemory(benchmark::detail::BenchmarkState &bs);
 
-            if (bs.variableArgsMode()) {
-                bs.pickNextArgument();
-            }
-            _stats.clear();
+    // pins the thread to the cpus for the block, intersected with the ones it may run on already
+    void pinBlock(const std::vector<int> &cpus);
 
-            for (unsigned i = 0; i < Iterations;) {
-                benchmark::detail::RunState state(bs, _noopTime);
+    // gives the thread back the affinity it had before pinBlock()
+    void unpinBlock();
 
-                state.start();
-                func(state);
-                state.stop();
+    // after every sample, so that the next one allocates the same memory again
+    void resetMemory();
+
+    benchmark::MemoryResource *memory() {
+        return _memory;
+    }
 
-                if (bs.needRestart()) // needed for ADD_ARG_RANGE functionality
-                    break;
+    benchmark::detail::DatasetCache &datasets() {
+        return _datasets;
+    }
 
-                benchmark::duration_t sample = state.getSample();
+    static bool allocatorSwept(const benchmark::detail::BenchmarkState &bs) {
+        return bs.listValue(benchmark::detail::ListAllocator, -1) >= 0;
+    }
 
-                _totalIterations++;
-                firstRun = false;
-                _stats.addSample(sample);
-                i++;
+    // starts the antagonist of the block, if the benchmark runs under any
+    void configureAntagonist(benchmark::detail::BenchmarkState &bs);
 
-                // give other processes chance to do their job, so that the scheduler is less willing to suspend ours
-                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    // moves the heap and state.memory() of the block by its layout, after configureMemory()
+    void configureLayout(benchmark::detail::BenchmarkState &bs);
 
-                if (std::chrono::steady_clock::now() - startTime > std::chrono::seconds(2))
-                    break;
+    /*
+    Median of every allocation strategy next to the first one of ALLOCATORS, with the difference to it;
+    green or red when the confidence intervals of the medians don't overlap. The same for the antagonists,
+    where the difference is the slowdown against the quiet baseline.
 
-                std::cout << (i % 5 ? "" : ".");
-                std::cout.flush();
-            }
+    ListBuild  system          arena           pool
+    $1=64      1.21 μs  264 ns (-78.2%)  610 ns (-49.6%)
+    */
+    void printStrategyDifference(const std::vector<StrategyResult> &results);
 
-            if (!_stats.empty()) {
-                calculateTimings();
+    /*
+    How much of the variation of the medians across the layouts is the layouts' rather than the samples' noise,
+    relative to the median:
 
-                std::cout << "\r";
-                std::cout.flush();
+    Traversal layouts  median  fastest  slowest  sample σ  layout σ  layout share
+    $1=64              219 ns   208 ns   241 ns      4.1%      4.6%           93%
+    */
+    void printLayoutVariance(const std::vector<StrategyResult> &results);
 
-                if (bs.variableArgsMode()) {
-                    int varg1 = bs.getArg();
-                    printResults(&varg1);
-                } else {
-                    printResults(nullptr);
-                }
-            }
-        }
-    }
+    void traceSample(const benchmark::detail::RunState &state, benchmark::detail::BenchmarkState &bs, unsigned index);
 
     void debugAddSample(std::chrono::steady_clock::duration sample) {
         _stats.addSample(sample);
@@ -191,87 +271,32 @@ public:
         return _stats.calculate();
     }
 
-    void printResults(const int *varg1 = nullptr) {
-        auto oldPrecision = std::cout.precision();
-        std::cout << std::fixed; // disable scientific notation
-
-        if (_setup.outputStyle == BenchmarkSetup::OutputStyle::Full) {
-            if (!varg1) {
-                std::cout << "[Benchmark '" << _name << "'] done ";
-            } else {
-                std::cout << "[Benchmark '" << _name << "' $1=" << *varg1 << "] done ";
-            }
-
-            std::cout << benchmark::io::Iterations{_totalIterations} << " iters";
-            std::cout << ", total spent " << _stats.totalTimeRun() << "\n";
-
-            std::cout << "Avg    : " << _stats.averageTime();
-            if (_stats.averageTime() > std::chrono::milliseconds(1)) {
-                std::cout << " (" << std::setprecision(3)
-                          << 1000000.0f /
-                             std::chrono::duration_cast<std::chrono::microseconds>(_stats.averageTime()).count()
-                          << " fps)\n";
-            } else {
-                std::cout << "\n";
-            }
-
-            std::cout << "StdDev : " << benchmark::io::ColoredDuration{_stats.standardDeviation(),
-                                                                       _stats.highDeviation()
-                                                                       ? benchmark::detail::ColorRed
-                                                                       : benchmark::detail::ColorLightGreen};
-
-            if (_stats.standardDeviationLevel() >= 0.01f) {
-                std::cout << " (" << (int) (_stats.standardDeviationLevel() * 100.0) << "%)";
-            } else {
-                std::cout << std::setprecision(1)
-                          << " (" << (float) (_stats.standardDeviationLevel() * 100.0) << "%)";
-            }
-            std::cout << "\n";
-            std::cout << "Median : " << _stats.medianTime() << "\n";
-            std::cout << "90th   : " << _stats.percentile(90) << "\n";
-            std::cout << "Min    : " << _stats.minimalTime() << "\n";
-            std::cout << "Max    : " << _stats.maximalTime() << std::endl;
-
-        } else if (_setup.outputStyle == BenchmarkSetup::OutputStyle::OneLine) {
-            if (!varg1) {
-                std::cout << "[Benchmark '" << _name << "'] ";
-            } else {
-                std::cout << "[Benchmark '" << _name << "' $1=" << *varg1 << "] ";
-            }
-
-            std::cout << benchmark::io::Iterations{_totalIterations} << " iters";
-
-            std::cout << ", avg: " << _stats.averageTime();
-            if (_stats.averageTime() > std::chrono::milliseconds(1)) {
-                std::cout << " (" << std::setprecision(3)
-                          << (1000000.0f /
-                              std::chrono::duration_cast<std::chrono::microseconds>(_stats.averageTime()).count())
-                          << " fps)";
-            }
-
-            std::cout << ", 90th: " << _stats.percentile(90);
-
-            std::cout << ", stddev: " << benchmark::io::ColoredDuration{_stats.standardDeviation(),
-                                                                        _stats.highDeviation()
-                                                                        ? benchmark::detail::ColorRed
-                                                                        : benchmark::detail::ColorReset};
-            if (_stats.standardDeviationLevel() >= 0.01f) {
-                std::cout << " (" << (int) (_stats.standardDeviationLevel() * 100.0) << "%)";
-            } else {
-                std::cout << " (" << std::setprecision(1) << (float) (_stats.standardDeviationLevel() * 100.0) << "%)";
-            }
-
-            std::cout << ", min: " << _stats.minimalTime() << std::endl;
-        }
-        std::cout << std::setprecision(oldPrecision);
-    }
+    void storeResult(const int *varg1 = nullptr);
 
-    void printCPULoad() {
-        std::cout << "CPU usage:\n";
-        auto cpuLoad = benchmark::detail::getCPULoad();
-        std::cout << cpuLoad;
-        std::cout << "\n\n";
-    }
+    void printResults(const int *varg1 = nullptr);
+
+    // e.g. "[Benchmark 'Name' $1=8 on P1 [cpus 2,10, L3 0, node 0]]"
+    void printTitle(const int *varg1);
+
+    // median time of a sample divided between its operations, e.g. "0.251 ns, 1.02 cycles (6400 ops/sample)"
+    void printPerOperation();
+
+    // operations and bytes of a sample over its median time, e.g. "41.2 kops/s, 161 MB/s"
+    void printRate();
+
+    // e.g. "3 of 200 (1 low severe, 2 high mild)"
+    void printOutliers();
+
+    // e.g. "package-0 1.25 mJ/iter 14.2 W, package-0/dram 80.1 μJ/iter 0.91 W"
+    void printEnergy();
+
+    // mean per sample, e.g. "values=64, items_per_second=1.21e+09"
+    void printCounters();
+
+    // e.g. "412 ns (63%, 390 ns..450 ns) | 1.21 μs (37%, 1.10 μs..1.42 μs)"
+    void printModes();
+
+    void printCPULoad();
 
     unsigned totalIterations() const {
         return _totalIterations;
@@ -280,43 +305,161 @@ public:
     const TimeStatistics & statistics() const {
         return _stats;
     }
+
+    const benchmark::detail::TimerCalibration &timerCalibration() const {
+        return _calibration;
+    }
+
+    const std::string &name() const {
+        return _name;
+    }
+
+    const BenchmarkSetup &setup() const {
+        return _setup;
+    }
+
+    void setTrace(benchmark::detail::TraceWriter *trace) {
+        _trace = trace;
+    }
+
+    void setDump(benchmark::detail::SampleDump *dump) {
+        _dump = dump;
+    }
+
+    // where the results go, std::cout unless buffered by the parallel mode
+    void setOutput(std::ostream *out) {
+        _out = out;
+    }
+
+    std::ostream &out() {
+        return *_out;
+    }
+
+    void setPartition(const std::string &partition) {
+        _partition = partition;
+    }
+
+    // bandwidth-sensitive, runs alone in the parallel mode
+    void setExclusive(bool exclusive) {
+        _exclusive = exclusive;
+    }
+
+    bool exclusive() const {
+        return _exclusive;
+    }
+
+    void setGroup(const std::string &group, const std::string &label, bool baseline = false) {
+        _group = group;
+        _groupLabel = label;
+        _groupBaseline = baseline;
+    }
+
+    const std::string &group() const {
+        return _group;
+    }
+
+    const std::string &groupLabel() const {
+        return _groupLabel;
+    }
+
+    bool groupBaseline() const {
+        return _groupBaseline;
+    }
+
+    // one per argument value, of all run() calls so far
+    const std::vector<benchmark::detail::BenchmarkResult> &results() const {
+        return _results;
+    }
+
+    // for benchmarks which measure in their own way rather than with run()
+    void addResult(const benchmark::detail::BenchmarkResult &result) {
+        _results.push_back(result);
+    }
+};
+
+/*
+Built-in benchmark of --coreLatency: the one-way latency of a cache line between every pair of cpus the process
+may run on, as a matrix, per topological relation and as clusters of the measured values alone. Every pair is
+a result of its own, "CoreLatency cpu0-cpu1", for the history and the other reporters.
+*/
+class CoreLatencyBenchmark: public Benchmark {
+    static benchmark::duration_t fromNs(double ns);
+
+    static std::string formatNs(double ns);
+
+public:
+    static const unsigned Rounds = 20;
+    static const unsigned RoundTrips = 1000;
+
+    CoreLatencyBenchmark()
+            : Benchmark("CoreLatency") {
+        setExclusive(true); // the other benchmarks would be in the way of every pair
+    }
+
+    void vrun() override;
+
+    void measure(const std::vector<benchmark::detail::LogicalCpu> &cpus);
+
+    void print(const benchmark::detail::CoreLatencyMatrix &matrix);
 };
 
 class BenchmarkSilo {
     using BenchmarkCont = std::vector<Benchmark *>;
     static BenchmarkCont *benchmarks;
 
+    // group and member names of BENCHMARK_GROUP, looked up once the benchmarks are all registered
+    using GroupCont = std::vector<std::pair<std::string, std::string>>;
+    static GroupCont *groupDefinitions;
+
 public:
-    static void registerBenchmark(Benchmark *pb) {
-        if (!benchmarks) {
-            benchmarks = new BenchmarkCont();
-        }
-        benchmarks->push_back(pb);
-    }
+    static void registerBenchmark(Benchmark *pb);
 
-    static int runAll() {
-        for (auto benchmark : *benchmarks) {
-            benchmark->vrun();
-        }
-        return 0;
-    }
+    static Benchmark *find(const std::string &name);
 
-    static void deleteAll() {
-        for (auto benchmark : *benchmarks) {
-            delete benchmark;
-        }
-        delete benchmarks;
-    }
+    // variants of a BENCHMARK_COMPARE run interleaved with each other there, not on their own
+    static bool compared(const Benchmark *benchmark);
+
+    static int runAll();
+
+    /*
+    Runs the benchmarks at the same time, one per partition of whole physical cores, every worker thread pinned
+    to the first cpu of its partition. The output of a benchmark is buffered and printed once it's done.
+    Exclusive benchmarks run afterwards, one by one, with the rest of the machine idle.
+    */
+    static int runParallel(benchmark::detail::PartitionGranularity granularity);
+
+    // "Traversal", "ListTraversal, VectorTraversal": the benchmarks of BENCHMARK_GROUP, the first is the baseline
+    static void registerGroup(const char *group, const char *members);
+
+    // every group with its members' results, the baseline first (the first member if none is marked)
+    static std::vector<benchmark::detail::BenchmarkGroup> groups();
+
+    // a side by side table for every group of benchmarks
+    static void printGroups();
+
+    // all results of this run and the tables of the groups, as JSON
+    static bool writeJson(const std::string &path);
+
+    static int runAll(const BenchmarkSetup &setup);
+
+    // all results of this run, under one revision and one timestamp
+    static void appendHistory(const std::string &path);
+
+    static void deleteAll();
 };
 
-#define BENCHMARK(Name) \
+#define BENCHMARK_IMPL(Name, exclusive) \
     struct Benchmark##Name: public Benchmark { \
         Benchmark##Name(const char *name) : Benchmark(name) { \
+            setExclusive(exclusive); \
         } \
         \
         void vrun() override { \
             run(&Benchmark##Name::testedFunc); \
         } \
+        void vsample(benchmark::detail::RunState &state) override { \
+            testedFunc(state); \
+        } \
         static BENCHMARK_ALWAYS_INLINE void testedFunc(benchmark::detail::RunState &); \
     }; \
     struct RegisterBenchmark##Name { \
@@ -327,6 +470,131 @@ public:
     \
     void BENCHMARK_ALWAYS_INLINE Benchmark##Name::testedFunc(benchmark::detail::RunState &state)
 
+#define BENCHMARK(Name) BENCHMARK_IMPL(Name, false)
+
+// bandwidth-sensitive benchmark, with --parallel it runs alone once the others are done
+#define BENCHMARK_EXCLUSIVE(Name) BENCHMARK_IMPL(Name, true)
+
+namespace benchmark {
+namespace detail {
+
+// "std::vector<int>, std::map<int, int>" -> {"std::vector<int>", "std::map<int, int>"}
+std::vector<std::string> splitTypeList(const char *types);
+
+// registers BenchmarkClass<T> for each of Types, named after the type
+template<template<typename> class BenchmarkClass, typename... Types>
+struct TemplateRegistrar {
+    TemplateRegistrar(const char *name, const char *types) {
+        registerTypes<Types...>(name, splitTypeList(types), 0);
+    }
+
+private:
+    template<typename T, typename... Rest>
+    typename std::enable_if<(sizeof...(Rest) > 0)>::type
+    registerTypes(const char *name, const std::vector<std::string> &typeNames, size_t index) {
+        registerTypes<T>(name, typeNames, index);
+        registerTypes<Rest...>(name, typeNames, index + 1);
+    }
+
+    template<typename T>
+    void registerTypes(const char *name, const std::vector<std::string> &typeNames, size_t index) {
+        std::string typeName = index < typeNames.size() ? typeNames[index] : std::to_string(index);
+        std::string fullName = std::string(name) + "<" + typeName + ">";
+
+        Benchmark *benchmark = new BenchmarkClass<T>(fullName.c_str());
+        benchmark->setGroup(name, typeName, index == 0);
+        BenchmarkSilo::registerBenchmark(benchmark);
+    }
+};
+
+}} // namespaces
+
+// Instantiates the benchmark for every type of the list, the type is available in the body as T; they are compared
+// in a table with the first type as the baseline:
+// BENCHMARK_TEMPLATE(Traversal, std::list<int>, std::vector<int>) { T container; ... }
+#define BENCHMARK_TEMPLATE(Name, ...) \
+    template<typename T> \
+    struct BenchmarkTemplate##Name: public Benchmark { \
+        BenchmarkTemplate##Name(const char *name) : Benchmark(name) { \
+        } \
+        \
+        void vrun() override { \
+            run(&BenchmarkTemplate##Name::testedFunc); \
+        } \
+        void vsample(benchmark::detail::RunState &state) override { \
+            testedFunc(state); \
+        } \
+        static BENCHMARK_ALWAYS_INLINE void testedFunc(benchmark::detail::RunState &); \
+    }; \
+    static benchmark::detail::TemplateRegistrar<BenchmarkTemplate##Name, __VA_ARGS__> \
+        __registerBenchmarkTemplate##Name(#Name, #__VA_ARGS__); \
+    \
+    template<typename T> \
+    void BENCHMARK_ALWAYS_INLINE BenchmarkTemplate##Name<T>::testedFunc(benchmark::detail::RunState &state)
+
+/*
+Variants measured in alternation rather than one after another: every round runs a block of samples of each of
+them in a random order, so that frequency, thermal and background drift fall on all of them alike instead of on
+whichever ran last. The i-th samples of two variants in a round are a pair; the verdict is the ratio of their
+medians with a bootstrap interval over the pairs and a Wilcoxon signed-rank test of the pair differences. The
+variants beyond the second are compared to the first one too.
+
+The variants are benchmarks of their own, which don't run separately any more. Their results are stored under
+their names as usual, with the verdict against the first variant.
+*/
+class CompareBenchmark: public Benchmark {
+    std::vector<std::string> _variants;
+
+    static std::string title(const std::vector<std::string> &variants);
+
+    benchmark::duration_t sample(Benchmark *variant, benchmark::detail::BenchmarkState &bs, uint64_t &operations);
+
+    // moves the variant to its next combination of arguments and lists, false after the last one
+    bool nextCombination(Benchmark *variant, benchmark::detail::BenchmarkState &bs);
+
+public:
+    static const unsigned Rounds = 40;
+    static const unsigned BlockSize = 5;
+
+    explicit CompareBenchmark(const char *variants);
+
+    bool compares(const std::string &name) const override;
+
+    const std::vector<std::string> &variants() const {
+        return _variants;
+    }
+
+    void vrun() override;
+
+    void measure(const std::vector<Benchmark *> &variants, std::vector<benchmark::detail::BenchmarkState> &states,
+                 uint64_t combination);
+
+    /*
+    [Benchmark 'A vs B' $1=64] 40 rounds of 5 samples each, in random order
+        A $1=64: median 1.21 μs [1.19 μs, 1.22 μs]
+        B $1=64: median 1.02 μs [1.01 μs, 1.03 μs]
+        B is 1.18x faster ±0.02 (p < 0.001)
+    */
+    void print(const std::vector<Benchmark *> &variants, std::vector<benchmark::detail::BenchmarkState> &states,
+               const std::vector<benchmark::detail::BenchmarkResult> &results,
+               const std::vector<benchmark::detail::PairedComparison> &comparisons,
+               const std::vector<std::string> &verdicts);
+};
+
+// Runs registered benchmarks interleaved and tells if the second one (and every further one) differs from the first:
+// BENCHMARK_COMPARE(SortStd, SortRadix)
+#define BENCHMARK_CONCAT_IMPL(a, b) a##b
+#define BENCHMARK_CONCAT(a, b) BENCHMARK_CONCAT_IMPL(a, b)
+#define BENCHMARK_COMPARE(...) \
+    static const bool BENCHMARK_CONCAT(__registerCompare, __LINE__) = \
+        (BenchmarkSilo::registerBenchmark(new CompareBenchmark(#__VA_ARGS__)), true);
+
+// Prints registered benchmarks side by side, a row per argument value, with their speedups over the first one:
+// BENCHMARK_GROUP(Traversal, ListTraversal, VectorTraversal)
+#define BENCHMARK_GROUP(Group, ...) \
+    static const bool BENCHMARK_CONCAT(__registerGroup, __LINE__) = \
+        (BenchmarkSilo::registerGroup(#Group, #__VA_ARGS__), true);
+
 #define MEASURE_START state.start();
 #define MEASURE_STOP state.stop();
 
@@ -334,10 +602,26 @@ public:
 
 #define REPEAT(n) for (unsigned i = 0; i < n; ++i)
 
+// instruction-level measurements, n copies of op unrolled at compile time, results are per op:
+// MEASURE_LATENCY(64, 1ull, [](unsigned long long x) { return x * 3; })
+#define MEASURE_LATENCY(n, init, ...) benchmark::measureLatency<n>(state, init, __VA_ARGS__);
+#define MEASURE_THROUGHPUT(n, init, ...) benchmark::measureThroughput<n>(state, init, __VA_ARGS__);
+
 #define ADD_ARG_RANGE(from, to) if (state.addArgument(from, to)) return; MEASURE_START
 #define ARG1 state.arg1()
 
+// runs the benchmark with state.memory() placed each way: NUMA_PLACEMENTS(benchmark::PlaceLocal, benchmark::PlaceRemote)
+#define NUMA_PLACEMENTS(...) if (state.addList(benchmark::detail::ListPlacement, {__VA_ARGS__})) return;
+// and backed by each kind of pages: PAGE_BACKINGS(benchmark::Backing4K, benchmark::BackingTHP, benchmark::BackingHuge2M)
+#define PAGE_BACKINGS(...) if (state.addList(benchmark::detail::ListBacking, {__VA_ARGS__})) return;
+// and allocating with each strategy, compared to the first one: ALLOCATORS(benchmark::AllocatorSystem, benchmark::AllocatorArena)
+#define ALLOCATORS(...) if (state.addList(benchmark::detail::ListAllocator, {__VA_ARGS__})) return;
+
 #define RUN_BENCHMARKS BenchmarkSilo::runAll();
-#define BENCHMARK_MAIN int main(int argc, char **argv) { int ret = RUN_BENCHMARKS; BenchmarkSilo::deleteAll(); return ret; }
+#define BENCHMARK_MAIN int main(int argc, char **argv) { \
+        int ret = BenchmarkSilo::runAll(BenchmarkSetup(argc, (const char **)argv)); \
+        BenchmarkSilo::deleteAll(); \
+        return ret; \
+    }
 
 #define BENCHMARK_STATE benchmark::detail::RunState &state
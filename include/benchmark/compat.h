@@ -0,0 +1,514 @@
+#pragma once
+
+/*
+Opt-in compatibility with suites written for Google Benchmark, instead of benchmark.h's own BENCHMARK:
+
+#include <benchmark/compat.h>
+
+static void BM_Copy(benchmark::State &state) {
+    std::vector<char> from(state.range(0)), to(state.range(0));
+    for (auto _ : state)
+        std::copy(from.begin(), from.end(), to.begin());
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Copy)->RangeMultiplier(4)->Range(64, 64 << 10);
+
+BENCHMARK_MAIN();
+
+Every argument tuple is a benchmark of its own, named the Google way ("BM_Copy/1024"), run by this library's
+runner: warm-up, steady state detection, statistics, and the command line options stay the same. A sample is
+one call of the function, the loop running as many iterations as fill about a millisecond (or Iterations(n)),
+so the results are per sample with the time per iteration (per item with SetItemsProcessed) on the "Per op"
+line. Bytes processed give the "Rate" line; counters, items and bytes per second are printed with the results,
+stored in them and become the tracks of --trace. The registration macros replace those of benchmark.h, so the
+two styles don't mix in one translation unit.
+*/
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "benchmark.h"
+
+namespace benchmark {
+
+using IterationCount = int64_t;
+
+// accepted for compatibility, the output picks the unit by the magnitude anyway
+enum TimeUnit {
+    kNanosecond,
+    kMicrosecond,
+    kMillisecond,
+    kSecond
+};
+
+class Counter {
+public:
+    enum Flags {
+        kDefaults = 0,
+        kIsRate = 1 << 0,                // divided by the measured time of the sample
+        kAvgThreads = 1 << 1,            // one thread here, so nothing to divide
+        kAvgThreadsRate = kIsRate | kAvgThreads,
+        kIsIterationInvariant = 1 << 2,  // multiplied by the iterations of the sample
+        kIsIterationInvariantRate = kIsRate | kIsIterationInvariant,
+        kAvgIterations = 1 << 3,         // divided by the iterations of the sample
+        kAvgIterationsRate = kIsRate | kAvgIterations,
+        kInvert = 1 << 4                 // 1 / the value, e.g. seconds per item out of a rate
+    };
+
+    double value;
+    Flags flags;
+
+    Counter(double value_ = 0., Flags flags_ = kDefaults)
+        : value(value_), flags(flags_) {
+    }
+
+    operator double const &() const {
+        return value;
+    }
+
+    operator double &() {
+        return value;
+    }
+
+    // what the sample reports, given its iterations and seconds
+    double finalValue(IterationCount iterations, double seconds) const {
+        double result = value;
+        if ((flags & kIsIterationInvariant) != 0)
+            result *= (double)iterations;
+        if ((flags & kAvgIterations) != 0 && iterations > 0)
+            result /= (double)iterations;
+        if ((flags & kIsRate) != 0 && seconds > 0)
+            result /= seconds;
+        if ((flags & kInvert) != 0 && result != 0)
+            result = 1 / result;
+        return result;
+    }
+};
+
+inline Counter::Flags operator|(Counter::Flags a, Counter::Flags b) {
+    return (Counter::Flags)((int)a | (int)b);
+}
+
+using UserCounters = std::map<std::string, Counter>;
+
+/*
+What the benchmark function gets. The timer of the sample runs from the first iteration to the end of the loop,
+minus the paused parts, so the setup before the loop isn't measured.
+*/
+class State {
+    detail::RunState *_run;
+    std::vector<int64_t> _range;
+    IterationCount _remaining;
+    IterationCount _completed{0};
+    bool _started{false};
+    bool _finished{false};
+    bool _skipped{false};
+    std::string _message;
+    std::string _label;
+    int64_t _bytesProcessed{0};
+    int64_t _itemsProcessed{0};
+
+    void startRunning() {
+        _started = true;
+        _run->start();
+    }
+
+    void finishRunning() {
+        if (!_finished && _started)
+            _run->stop();
+        _finished = true;
+    }
+
+public:
+    const IterationCount max_iterations;
+    UserCounters counters;
+
+    struct BENCHMARK_UNUSED Value {};
+
+    class Iterator {
+        State *_parent;
+        IterationCount _remaining;
+
+    public:
+        Iterator(State *parent, IterationCount remaining)
+            : _parent(parent), _remaining(remaining) {
+        }
+
+        BENCHMARK_ALWAYS_INLINE Value operator*() const {
+            return Value();
+        }
+
+        BENCHMARK_ALWAYS_INLINE Iterator &operator++() {
+            --_remaining;
+            return *this;
+        }
+
+        BENCHMARK_ALWAYS_INLINE bool operator!=(const Iterator &) const {
+            if (_remaining > 0)
+                return true;
+            _parent->_completed = _parent->max_iterations;
+            _parent->finishRunning();
+            return false;
+        }
+    };
+
+    State(detail::RunState *run, const std::vector<int64_t> &range, IterationCount iterations)
+        : _run(run), _range(range), _remaining(iterations), max_iterations(iterations) {
+    }
+
+    BENCHMARK_ALWAYS_INLINE Iterator begin() {
+        startRunning();
+        return Iterator(this, _skipped ? 0 : max_iterations);
+    }
+
+    BENCHMARK_ALWAYS_INLINE Iterator end() {
+        return Iterator(this, 0);
+    }
+
+    BENCHMARK_ALWAYS_INLINE bool KeepRunning() {
+        return KeepRunningBatch(1);
+    }
+
+    BENCHMARK_ALWAYS_INLINE bool KeepRunningBatch(IterationCount n) {
+        if (!_started)
+            startRunning();
+        if (!_skipped && _remaining >= n) {
+            _remaining -= n;
+            _completed += n;
+            return true;
+        }
+        finishRunning();
+        return false;
+    }
+
+    void PauseTiming() {
+        _run->stop();
+    }
+
+    void ResumeTiming() {
+        _run->start();
+    }
+
+    // the rest of the loop doesn't run, the benchmark is reported as skipped and not measured
+    void SkipWithError(const std::string &message) {
+        _skipped = true;
+        _message = message;
+        _remaining = 0;
+    }
+
+    void SkipWithMessage(const std::string &message) {
+        SkipWithError(message);
+    }
+
+    bool error_occurred() const {
+        return _skipped;
+    }
+
+    bool skipped() const {
+        return _skipped;
+    }
+
+    const std::string &message() const {
+        return _message;
+    }
+
+    int64_t range(size_t pos = 0) const {
+        return pos < _range.size() ? _range[pos] : 0;
+    }
+
+    int64_t range_x() const {
+        return range(0);
+    }
+
+    int64_t range_y() const {
+        return range(1);
+    }
+
+    // iterations done so far, all of them once the loop is over
+    IterationCount iterations() const {
+        return _completed;
+    }
+
+    void SetBytesProcessed(int64_t bytes) {
+        _bytesProcessed = bytes;
+    }
+
+    int64_t bytes_processed() const {
+        return _bytesProcessed;
+    }
+
+    void SetItemsProcessed(int64_t items) {
+        _itemsProcessed = items;
+    }
+
+    int64_t items_processed() const {
+        return _itemsProcessed;
+    }
+
+    void SetLabel(const std::string &label) {
+        _label = label;
+    }
+
+    const std::string &label() const {
+        return _label;
+    }
+
+    int threads() const {
+        return 1;
+    }
+
+    int thread_index() const {
+        return 0;
+    }
+};
+
+namespace internal {
+
+using Function = std::function<void(State &)>;
+
+// lo, the powers of the multiplier in between, hi
+std::vector<int64_t> rangeValues(int64_t lo, int64_t hi, int multiplier);
+
+/*
+A registration: the function and the argument tuples it runs with, built up by the chained calls.
+*/
+class Benchmark {
+    std::string _name;
+    Function _function;
+    std::vector<std::vector<int64_t>> _args;
+    std::vector<std::string> _argNames;
+    int _rangeMultiplier{8};
+    IterationCount _iterations{0};
+
+public:
+    Benchmark(const std::string &name, Function function)
+        : _name(name), _function(std::move(function)) {
+    }
+
+    Benchmark *Name(const std::string &name) {
+        _name = name;
+        return this;
+    }
+
+    Benchmark *Arg(int64_t x) {
+        _args.push_back({x});
+        return this;
+    }
+
+    Benchmark *Args(const std::vector<int64_t> &args) {
+        _args.push_back(args);
+        return this;
+    }
+
+    Benchmark *ArgPair(int64_t x, int64_t y) {
+        return Args({x, y});
+    }
+
+    Benchmark *ArgsProduct(const std::vector<std::vector<int64_t>> &lists) {
+        std::vector<std::vector<int64_t>> product{{}};
+        for (auto &list : lists) {
+            std::vector<std::vector<int64_t>> next;
+            for (auto &prefix : product) {
+                for (int64_t value : list) {
+                    next.push_back(prefix);
+                    next.back().push_back(value);
+                }
+            }
+            product.swap(next);
+        }
+        _args.insert(_args.end(), product.begin(), product.end());
+        return this;
+    }
+
+    Benchmark *RangeMultiplier(int multiplier) {
+        _rangeMultiplier = multiplier;
+        return this;
+    }
+
+    Benchmark *Range(int64_t start, int64_t limit) {
+        return ArgsProduct({rangeValues(start, limit, _rangeMultiplier)});
+    }
+
+    Benchmark *RangePair(int64_t lo1, int64_t hi1, int64_t lo2, int64_t hi2) {
+        return Ranges({{lo1, hi1}, {lo2, hi2}});
+    }
+
+    Benchmark *Ranges(const std::vector<std::pair<int64_t, int64_t>> &ranges) {
+        std::vector<std::vector<int64_t>> lists;
+        for (auto &range : ranges)
+            lists.push_back(rangeValues(range.first, range.second, _rangeMultiplier));
+        return ArgsProduct(lists);
+    }
+
+    Benchmark *DenseRange(int64_t start, int64_t limit, int step = 1) {
+        for (int64_t value = start; value <= limit; value += step)
+            _args.push_back({value});
+        return this;
+    }
+
+    Benchmark *ArgName(const std::string &name) {
+        _argNames = {name};
+        return this;
+    }
+
+    Benchmark *ArgNames(const std::vector<std::string> &names) {
+        _argNames = names;
+        return this;
+    }
+
+    Benchmark *Apply(void (*apply)(Benchmark *)) {
+        apply(this);
+        return this;
+    }
+
+    // fixed iterations per sample instead of about a millisecond's worth
+    Benchmark *Iterations(IterationCount iterations) {
+        _iterations = iterations;
+        return this;
+    }
+
+    // the runner decides on these: how long to measure, how often, which clock
+    Benchmark *Unit(TimeUnit) {
+        return this;
+    }
+
+    Benchmark *MinTime(double) {
+        return this;
+    }
+
+    Benchmark *MinWarmUpTime(double) {
+        return this;
+    }
+
+    Benchmark *Repetitions(int) {
+        return this;
+    }
+
+    Benchmark *UseRealTime() {
+        return this;
+    }
+
+    Benchmark *MeasureProcessCPUTime() {
+        return this;
+    }
+
+    const std::string &name() const {
+        return _name;
+    }
+
+    const Function &function() const {
+        return _function;
+    }
+
+    IterationCount iterations() const {
+        return _iterations;
+    }
+
+    // at least one tuple, the empty one if there were no arguments
+    std::vector<std::vector<int64_t>> args() const {
+        return _args.empty() ? std::vector<std::vector<int64_t>>{{}} : _args;
+    }
+
+    // "BM_Copy/1024", "BM_Copy/size:1024/step:8"
+    std::string instanceName(const std::vector<int64_t> &args) const;
+};
+
+std::vector<std::unique_ptr<Benchmark>> &registrations();
+
+Benchmark *registerBenchmark(const std::string &name, Function function);
+
+/*
+One argument tuple of a registration, measured by run(). Skipping with an error in the calibrating call means the
+benchmark isn't measured at all.
+*/
+class CompatBenchmark: public ::Benchmark {
+    Function _function;
+    std::vector<int64_t> _args;
+    IterationCount _iterations;
+    std::string _message;
+    std::string _label;
+
+    // the function once with the iterations, outside of run(): the time of the loop, zero if it skipped
+    duration_t measureOnce(IterationCount iterations);
+
+    // iterations that take about SampleTime, growing at most tenfold between the tries
+    IterationCount calibrate();
+
+public:
+    CompatBenchmark(const std::string &name, Function function, std::vector<int64_t> args, IterationCount iterations);
+
+    void vrun() override;
+
+    const std::vector<int64_t> &args() const {
+        return _args;
+    }
+
+    IterationCount iterations() const {
+        return _iterations;
+    }
+};
+
+// the flags of the command line, set by Initialize()
+BenchmarkSetup &compatSetup();
+
+std::string &compatFilter();
+
+} // namespace internal
+
+template<typename Function, typename... Args>
+internal::Benchmark *RegisterBenchmark(const std::string &name, Function &&function, Args &&...args) {
+    typename std::decay<Function>::type call = function;
+    return internal::registerBenchmark(name, [=](State &state) { call(state, args...); });
+}
+
+/*
+Reads --benchmark_filter=<regex> and drops the other --benchmark_* flags of Google Benchmark, which have their
+own counterparts here or don't apply; the rest is this library's command line.
+*/
+void Initialize(int *argc, char **argv);
+
+bool ReportUnrecognizedArguments(int, char **);
+
+// registers an instance per argument tuple of every registration matching the filter and runs them
+size_t RunSpecifiedBenchmarks();
+
+void Shutdown();
+
+} // namespace benchmark
+
+#undef BENCHMARK
+#undef BENCHMARK_TEMPLATE
+#undef BENCHMARK_MAIN
+
+#define BENCHMARK(...) \
+    static ::benchmark::internal::Benchmark *BENCHMARK_CONCAT(__compatBenchmark, __LINE__) BENCHMARK_UNUSED = \
+        ::benchmark::internal::registerBenchmark(#__VA_ARGS__, __VA_ARGS__)
+
+// BENCHMARK_CAPTURE(BM_Parse, json, std::string("{}")) runs BM_Parse(state, std::string("{}")) as "BM_Parse/json"
+#define BENCHMARK_CAPTURE(function, caseName, ...) \
+    static ::benchmark::internal::Benchmark *BENCHMARK_CONCAT(__compatBenchmark, __LINE__) BENCHMARK_UNUSED = \
+        ::benchmark::internal::registerBenchmark(#function "/" #caseName, \
+            [](::benchmark::State &state) { function(state, __VA_ARGS__); })
+
+#define BENCHMARK_TEMPLATE(function, ...) \
+    static ::benchmark::internal::Benchmark *BENCHMARK_CONCAT(__compatBenchmark, __LINE__) BENCHMARK_UNUSED = \
+        ::benchmark::internal::registerBenchmark(#function "<" #__VA_ARGS__ ">", function<__VA_ARGS__>)
+
+#define BENCHMARK_TEMPLATE1(function, a) BENCHMARK_TEMPLATE(function, a)
+#define BENCHMARK_TEMPLATE2(function, a, b) BENCHMARK_TEMPLATE(function, a, b)
+
+#define BENCHMARK_MAIN() \
+    int main(int argc, char **argv) { \
+        ::benchmark::Initialize(&argc, argv); \
+        if (::benchmark::ReportUnrecognizedArguments(argc, argv)) \
+            return 1; \
+        ::benchmark::RunSpecifiedBenchmarks(); \
+        ::benchmark::Shutdown(); \
+        return 0; \
+    } \
+    int main(int, char **)
@@ -0,0 +1,78 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <thread>
+#include <vector>
+#include "state.h"
+#include "topology.h"
+
+namespace benchmark {
+
+// background load next to the benchmark thread, see ANTAGONISTS and --antagonists
+enum AntagonistKind {
+    AntagonistNone,      // the quiet baseline the others are compared to
+    AntagonistLLC,       // writes every line of a buffer twice the last level cache, evicting the benchmark's lines
+    AntagonistBandwidth, // copies between buffers far beyond the caches, saturating the memory bandwidth
+    AntagonistBranch,    // jumps through hundreds of functions on random conditions, flushing the branch predictors
+                         // and the instruction cache; shared only by SMT siblings, so it runs on the sibling
+    AntagonistSMT        // independent integer arithmetic on the SMT sibling, competing for the execution ports
+};
+
+namespace detail {
+
+// "llc", "bandwidth", "branch" or "smt", -1 if it's none of them
+int parseAntagonist(const std::string &text);
+
+const char *antagonistName(int kind);
+
+// the kinds with the quiet baseline in front, once
+std::vector<int> withQuietBaseline(std::vector<int> kinds);
+
+// size of the last level cache of the cpu in bytes, 32 MiB if sysfs doesn't tell
+size_t lastLevelCacheSize(int cpu);
+
+/*
+Where the antagonist of the kind runs for a benchmark thread on 'cpu'. Branch and SMT load goes to the SMT siblings
+of the cpu, the cache and bandwidth load to the other cores sharing its last level cache (or all other cpus for
+the bandwidth). 'configured' overrides the choice; empty if there is no suitable cpu.
+*/
+std::vector<int> antagonistCpus(int kind, int cpu, const std::vector<LogicalCpu> &topology,
+                                const std::vector<int> &configured);
+
+/*
+Threads of one antagonist pinned to the cpus, running from the constructor to the destructor: for a block of
+samples, so that the load is there for all of them and gone for the printing.
+*/
+class Antagonists {
+    int _kind;
+    std::vector<int> _cpus;
+    std::atomic<bool> _stop;
+    std::vector<std::thread> _threads;
+    std::vector<char> _buffer; // lines the LLC and bandwidth threads go through, a slice for each thread
+    std::vector<char> _target; // where the bandwidth threads copy their slice
+
+    void loop(int cpu, size_t index);
+
+public:
+    Antagonists(int kind, const std::vector<int> &cpus);
+
+    Antagonists(const Antagonists &) = delete;
+    Antagonists &operator=(const Antagonists &) = delete;
+
+    ~Antagonists();
+
+    bool running() const {
+        return !_threads.empty();
+    }
+
+    // e.g. "llc on cpus 2-7", "smt (no cpu for it)"
+    std::string description() const;
+};
+
+}} //namespaces
+
+// runs the benchmark quietly and with each antagonist next to it, the slowdowns in a table at the end:
+// ANTAGONISTS(benchmark::AntagonistLLC, benchmark::AntagonistSMT)
+#define ANTAGONISTS(...) \
+    if (state.addList(benchmark::detail::ListAntagonist, benchmark::detail::withQuietBaseline({__VA_ARGS__}))) return;
@@ -0,0 +1,205 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "memory_resource.h"
+
+namespace benchmark {
+
+// what state.memory() allocates with, to take allocator noise out of a benchmark or to compare strategies
+enum AllocatorStrategy {
+    AllocatorArena,  // bump pointer over the configured pages, rewound after every sample
+    AllocatorSystem, // the global heap, what a container gets without an allocator
+    AllocatorPool    // free list per size class on top of the arena, freed blocks are reused within a sample
+};
+
+/*
+Bump-pointer arena on top of another resource, for data a benchmark body manages itself:
+deallocation does nothing, reset() rewinds to the first chunk and release() gives the chunks back.
+Chunks double in size from the initial one.
+*/
+class ArenaResource: public MemoryResource {
+    struct Chunk {
+        char *data;
+        size_t size;
+    };
+
+    MemoryResource *_upstream;
+    size_t _nextSize;
+    std::vector<Chunk> _chunks;
+    size_t _current{0};
+    size_t _offset{0};
+
+public:
+    explicit ArenaResource(MemoryResource *upstream, size_t initialSize = 64 << 10)
+        : _upstream(upstream)
+        , _nextSize(std::max(initialSize, (size_t)64)) {
+    }
+
+    ~ArenaResource() override {
+        release();
+    }
+
+    ArenaResource(const ArenaResource &) = delete;
+    ArenaResource &operator=(const ArenaResource &) = delete;
+
+    std::string description() const override {
+        return "arena over " + _upstream->description();
+    }
+
+    void reset() override {
+        _current = 0;
+        _offset = 0;
+    }
+
+    void release() {
+        for (auto &chunk : _chunks) {
+            _upstream->deallocate(chunk.data, chunk.size, alignof(std::max_align_t));
+        }
+        _chunks.clear();
+        reset();
+    }
+
+    // bytes of all chunks, used or not
+    size_t capacity() const {
+        size_t result = 0;
+        for (auto &chunk : _chunks)
+            result += chunk.size;
+        return result;
+    }
+
+protected:
+    void *doAllocate(size_t bytes, size_t alignment) override {
+        for (; _current < _chunks.size(); _current++, _offset = 0) {
+            Chunk &chunk = _chunks[_current];
+            uintptr_t base = (uintptr_t)chunk.data;
+            size_t start = (size_t)(((base + _offset + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base);
+            if (start + bytes <= chunk.size) {
+                _offset = start + bytes;
+                return chunk.data + start;
+            }
+        }
+
+        size_t size = std::max(_nextSize, bytes + alignment);
+        _nextSize = size * 2;
+        _chunks.push_back(Chunk{(char *)_upstream->allocate(size, alignof(std::max_align_t)), size});
+        _current = _chunks.size() - 1;
+        _offset = 0;
+        return doAllocate(bytes, alignment);
+    }
+
+    void doDeallocate(void *, size_t, size_t) override {
+    }
+};
+
+/*
+Free list for every power of two size class from 8 bytes to 4 KiB, the blocks carved from slabs of the
+upstream resource and aligned to their size. Larger blocks go straight to the upstream one.
+reset() forgets the free lists and gives the slabs back.
+*/
+class PoolResource: public MemoryResource {
+    static const unsigned MinShift = 3;
+    static const unsigned MaxShift = 12;
+    static const size_t SlabSize = 64 << 10;
+
+    struct FreeBlock {
+        FreeBlock *next;
+    };
+
+    struct Slab {
+        void *data;
+        size_t size;
+        size_t alignment;
+    };
+
+    // blocks are carved from the current slab of the class only when there's none on the free list
+    struct SizeClass {
+        FreeBlock *free;
+        char *next;
+        char *end;
+    };
+
+    MemoryResource *_upstream;
+    SizeClass _classes[MaxShift - MinShift + 1] = {};
+    std::vector<Slab> _slabs;
+
+    static unsigned classShift(size_t bytes) {
+        unsigned shift = MinShift;
+        while (((size_t)1 << shift) < bytes)
+            shift++;
+        return shift;
+    }
+
+public:
+    explicit PoolResource(MemoryResource *upstream)
+        : _upstream(upstream) {
+    }
+
+    ~PoolResource() override {
+        reset();
+    }
+
+    PoolResource(const PoolResource &) = delete;
+    PoolResource &operator=(const PoolResource &) = delete;
+
+    std::string description() const override {
+        return "pool over " + _upstream->description();
+    }
+
+    void reset() override {
+        for (auto &slab : _slabs) {
+            _upstream->deallocate(slab.data, slab.size, slab.alignment);
+        }
+        _slabs.clear();
+        for (auto &sizeClass : _classes)
+            sizeClass = SizeClass{nullptr, nullptr, nullptr};
+    }
+
+protected:
+    void *doAllocate(size_t bytes, size_t alignment) override {
+        unsigned shift = classShift(std::max(bytes, alignment));
+        if (shift > MaxShift)
+            return _upstream->allocate(bytes, alignment);
+
+        SizeClass &sizeClass = _classes[shift - MinShift];
+        if (sizeClass.free) {
+            FreeBlock *block = sizeClass.free;
+            sizeClass.free = block->next;
+            return block;
+        }
+
+        size_t blockSize = (size_t)1 << shift;
+        if (sizeClass.next == sizeClass.end) {
+            size_t slabSize = SlabSize;
+            slabSize = std::max(slabSize, blockSize * 8);
+            sizeClass.next = (char *)_upstream->allocate(slabSize, blockSize);
+            sizeClass.end = sizeClass.next + slabSize;
+            _slabs.push_back(Slab{sizeClass.next, slabSize, blockSize});
+        }
+        void *block = sizeClass.next;
+        sizeClass.next += blockSize;
+        return block;
+    }
+
+    void doDeallocate(void *p, size_t bytes, size_t alignment) override {
+        unsigned shift = classShift(std::max(bytes, alignment));
+        if (shift > MaxShift) {
+            _upstream->deallocate(p, bytes, alignment);
+            return;
+        }
+        FreeBlock *block = (FreeBlock *)p;
+        block->next = _classes[shift - MinShift].free;
+        _classes[shift - MinShift].free = block;
+    }
+};
+
+namespace detail {
+
+// "arena", "system" or "pool", -1 if it's none of them
+int parseAllocatorStrategy(const std::string &text);
+
+const char *allocatorStrategyName(int strategy);
+
+}} //namespaces
@@ -1,7 +1,14 @@
 #pragma once
-#include <iostream>
+#include <string>
+#include <vector>
+#include "arena.h"
+#include "bootstrap.h"
+#include "numa.h"
+#include "page_resource.h"
 #include "config.h"
 #include "program_arguments.h"
+#include "statistics.h"
+#include "topology.h"
 
 struct BenchmarkSetup {
     enum OutputStyle {
@@ -14,33 +21,50 @@ struct BenchmarkSetup {
     BenchmarkSetup():
         outputStyle(OutputStyle::OneLine),
         verbose(false),
-        skipWarmup(false)
+        skipWarmup(false),
+        skipSteadyState(false),
+        outlierMethod(TimeStatistics::OutliersTukey),
+        bootstrap{benchmark::detail::BootstrapBCa, 1000, 0.95, 42},
+        percentiles{90},
+        dumpCapacity(1000000),
+        parallel(false),
+        partitionGranularity(benchmark::detail::PartitionCore),
+        placement(benchmark::PlaceDefault),
+        backing(benchmark::BackingDefault),
+        allocator(benchmark::AllocatorArena),
+        coreLatency(false),
+        energy(false),
+        layouts(0),
+        historyQuery(false),
+        historyLast(10)
     {
     }
 
-    BenchmarkSetup(int argc, const char **argv):
-        BenchmarkSetup()
-    {
-        ProgramArguments args(argc, argv);
-
-        std::string outputStyle_ = args.after("output");
-        if (outputStyle_ == "full") {
-            outputStyle = OutputStyle::Full;
-        } else if (outputStyle_ == "oneline") {
-            outputStyle = OutputStyle::OneLine;
-        } else if (outputStyle_ == "table") {
-            outputStyle = OutputStyle::Table;
-        } else if (outputStyle_ == "nothing") {
-            outputStyle = OutputStyle::Nothing;
-        } else {
-            std::cerr << "Unexpected value of 'output' argument: " << outputStyle_ << std::endl;
-        }
-
-        verbose = args.contains("verbose");
-        skipWarmup = args.contains("skipWarmup");
-    }
+    BenchmarkSetup(int argc, const char **argv);
 
     OutputStyle outputStyle;
     bool verbose;
     bool skipWarmup;
+    bool skipSteadyState; // keep the samples taken before the timings settle
+    TimeStatistics::OutlierMethod outlierMethod;
+    benchmark::detail::Bootstrap::Settings bootstrap;
+    std::vector<int> percentiles;
+    std::string traceFile; // Chrome trace-event JSON of all samples, if not empty
+    std::string jsonFile; // results and group tables as JSON, if not empty
+    std::string dumpFile; // raw samples in the binary columnar format, if not empty
+    uint64_t dumpCapacity; // samples the dump file is preallocated for
+    bool parallel; // independent benchmarks at the same time on disjoint cores
+    benchmark::detail::PartitionGranularity partitionGranularity;
+    int placement; // benchmark::NumaPlacement of state.memory() unless the benchmark sweeps over NUMA_PLACEMENTS
+    int backing; // benchmark::PageBacking of state.memory() unless the benchmark sweeps over PAGE_BACKINGS
+    int allocator; // benchmark::AllocatorStrategy of state.memory() unless the benchmark sweeps over ALLOCATORS
+    bool coreLatency; // also run the built-in core-to-core latency benchmark
+    bool energy; // RAPL energy per sample next to the timings
+    std::vector<int> antagonists; // benchmark::AntagonistKind every benchmark runs under too, after the quiet baseline
+    std::vector<int> antagonistCpus; // where the antagonists run, chosen by the kind if empty
+    unsigned layouts; // every benchmark runs under the default and layouts - 1 randomized memory layouts if above 1
+    std::string historyFile; // binary log the results are appended to, if not empty
+    bool historyQuery; // print the trends from historyFile instead of running
+    std::string historyFilter; // part of the benchmark names to query
+    unsigned historyLast; // runs to look for trends and step changes in
 };
\ No newline at end of file
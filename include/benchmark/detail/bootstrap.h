@@ -0,0 +1,110 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "config.h"
+
+namespace benchmark {
+namespace detail {
+
+enum BootstrapMethod {
+    BootstrapNone,
+    BootstrapPercentile,
+    BootstrapBCa // bias-corrected and accelerated
+};
+
+struct ConfidenceInterval {
+    double lower;
+    double upper;
+    bool valid;
+};
+
+// xorshift128+, way cheaper than std::mt19937 and good enough for resampling
+class FastRandom {
+    uint64_t _s0, _s1;
+
+    static uint64_t splitmix(uint64_t &x) {
+        uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+public:
+    explicit FastRandom(uint64_t seed) {
+        _s0 = splitmix(seed);
+        _s1 = splitmix(seed);
+    }
+
+    BENCHMARK_ALWAYS_INLINE uint64_t next() {
+        uint64_t s1 = _s0;
+        const uint64_t s0 = _s1;
+        _s0 = s0;
+        s1 ^= s1 << 23;
+        _s1 = s1 ^ s0 ^ (s1 >> 17) ^ (s0 >> 26);
+        return _s1 + s0;
+    }
+
+    // uniform in [0, bound), multiply-shift instead of a division
+    BENCHMARK_ALWAYS_INLINE uint32_t below(uint32_t bound) {
+        return (uint32_t)(((next() >> 32) * (uint64_t)bound) >> 32);
+    }
+
+    double uniform() {
+        return (double)(next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+};
+
+double normalCdf(double x);
+
+// Acklam's rational approximation, relative error is below 1.2e-9
+double normalQuantile(double p);
+
+/*
+Confidence intervals for the mean and any number of quantiles of a sample set.
+
+A resample of sorted data is fully described by how many times every element has been drawn, so a resample is
+a tight loop filling a counts array, and all estimators come out of one pass over it: the mean as a weighted sum,
+quantiles as the elements where the running count crosses their ranks. No resample is ever sorted or copied.
+Resamples are split between the cores.
+*/
+class Bootstrap {
+public:
+    struct Settings {
+        BootstrapMethod method;
+        unsigned resamples;
+        double confidence;
+        uint64_t seed;
+    };
+
+private:
+    const std::vector<double> &_sorted;
+    const std::vector<double> &_quantiles;
+    Settings _settings;
+
+    // quantile of a set given as sorted values, same interpolation as used for the point estimates
+    static double quantileOfSorted(const std::vector<double> &sorted, double q);
+
+    size_t estimatorsCount() const {
+        return 1 + _quantiles.size();
+    }
+
+    // estimator values of the resamples [from, to), written to out[estimator * resamples + resample]
+    void resampleRange(unsigned from, unsigned to, std::vector<double> &out) const;
+
+    // leave-one-out estimates for the BCa acceleration, O(1) each thanks to the sorted data
+    std::vector<double> jackknife(size_t estimator) const;
+
+    ConfidenceInterval interval(size_t estimator, double estimate, double *boot) const;
+
+public:
+    Bootstrap(const std::vector<double> &sorted, const std::vector<double> &quantiles, const Settings &settings)
+        : _sorted(sorted)
+        , _quantiles(quantiles)
+        , _settings(settings) {
+    }
+
+    // intervals for the mean followed by one per quantile
+    std::vector<ConfidenceInterval> run() const;
+};
+
+}} //namespaces
@@ -0,0 +1,33 @@
+#pragma once
+#include "config.h"
+
+namespace benchmark {
+namespace detail {
+
+/*
+What the harness itself adds to every sample of a MEASURE: two clock reads, the branch in RunState::stop() and a
+DoNotOptimize; the call of the tested function is outside the window of its start() and stop(). Its median is
+subtracted from the samples, its spread is the uncertainty which the subtraction adds to them.
+*/
+struct TimerCalibration {
+    duration_t resolution;     // smallest step the clock is observed to make
+    duration_t overhead;       // median of empty MEASURE samples
+    duration_t overheadSpread; // scaled MAD of empty MEASURE samples
+    duration_t overheadMin;
+    duration_t overheadMax;
+
+    // timings at this level are mostly the harness and the clock granularity
+    duration_t floor() const {
+        return overhead + overheadSpread + resolution;
+    }
+
+    // the measured value is within a few floors, or the uncertainty is a noticeable part of it
+    bool nearFloor(duration_t value) const {
+        return value < floor() * 5 || (overheadSpread + resolution) * 20 > value;
+    }
+};
+
+// timer resolution and the overhead of a sample, measured the way Benchmark::run() takes one
+TimerCalibration calibrateTimer();
+
+}} //namespaces
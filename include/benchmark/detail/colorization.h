@@ -5,20 +5,20 @@ namespace benchmark {
         using ColorTag = const char *;
 
 #ifndef WIN32
-        static ColorTag ColorLightGreen = "\x1B[92m";
-        static ColorTag ColorLightYellow = "\x1B[33m";
-        static ColorTag ColorLightRed = "\x1B[91m";
-        static ColorTag ColorRed = "\x1B[31m";
-        static ColorTag ColorReset = "\x1B[0m";
+        const ColorTag ColorLightGreen = "\x1B[92m";
+        const ColorTag ColorLightYellow = "\x1B[33m";
+        const ColorTag ColorLightRed = "\x1B[91m";
+        const ColorTag ColorRed = "\x1B[31m";
+        const ColorTag ColorReset = "\x1B[0m";
 #else
-        static ColorTag ColorLightGreen = "";
-        static ColorTag ColorLightYellow = "";
-        static ColorTag ColorLightGray = "";
-        static ColorTag ColorRed = "";
-        static ColorTag ColorReset = "";
+        const ColorTag ColorLightGreen = "";
+        const ColorTag ColorLightYellow = "";
+        const ColorTag ColorLightRed = "";
+        const ColorTag ColorRed = "";
+        const ColorTag ColorReset = "";
 #endif
 
-        static ColorTag selectColorForCPULoad(float relValue) { // value is in [0.0, 1.0] range
+        inline ColorTag selectColorForCPULoad(float relValue) { // value is in [0.0, 1.0] range
             if (relValue > 0.6f) {
                 return ColorLightRed;
             } else if (relValue > 0.2f) {
@@ -27,7 +27,7 @@ namespace benchmark {
             return ColorLightGreen;
         }
 
-        static ColorTag selectColorForCPUFreq(float relValue) { // value is in [0.0, 1.0] range
+        inline ColorTag selectColorForCPUFreq(float relValue) { // value is in [0.0, 1.0] range
             if (relValue < 0.6f) {
                 return ColorLightRed;
             } else if (relValue < 0.8f) {
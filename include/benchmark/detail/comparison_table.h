@@ -0,0 +1,88 @@
+#pragma once
+#include <iosfwd>
+#include <string>
+#include <vector>
+#include "results.h"
+
+namespace benchmark {
+namespace detail {
+
+// width of a string in a terminal: escape sequences take no space, UTF-8 continuation bytes aren't characters
+size_t visibleLength(const std::string &text);
+
+// row of a result in the tables, "$1=64" or "-", with the antagonist and the layout of the block if there were any
+std::string rowName(const BenchmarkResult &result);
+
+// median of the baseline over the median of the result, how many times faster the result is; 0 if unknown
+double speedup(const BenchmarkResult &baseline, const BenchmarkResult &result);
+
+// 1 if the result is faster than the baseline, -1 if slower, 0 while the intervals of the medians overlap
+int significance(const BenchmarkResult &baseline, const BenchmarkResult &result);
+
+// a benchmark of a group, a column of its table
+struct GroupMember {
+    std::string label;
+    std::string name;
+    std::vector<BenchmarkResult> results;
+};
+
+// benchmarks tagged into one group, compared to the baseline, which is the first member
+struct BenchmarkGroup {
+    std::string name;
+    std::vector<GroupMember> members;
+
+    // rows of the members' results, in the order they first appear
+    std::vector<std::string> rows() const;
+
+    // the result of the member in the row, nullptr if it has none
+    const BenchmarkResult *find(size_t member, const std::string &row) const;
+};
+
+/*
+Side by side results of benchmarks which differ in one thing only (e.g. instances of a BENCHMARK_TEMPLATE):
+a row per argument value, a column per benchmark.
+
+Traversal  std::list<int>  std::vector<int>
+$1=8               120 ns             35 ns
+$1=16              230 ns             41 ns
+*/
+class ComparisonTable {
+    std::string _title;
+    std::vector<std::string> _columns;
+    std::vector<std::string> _rows;
+    std::vector<std::vector<std::string>> _cells; // [row][column]
+
+    size_t rowIndex(const std::string &row);
+
+public:
+    explicit ComparisonTable(const std::string &title)
+        : _title(title) {
+    }
+
+    size_t addColumn(const std::string &column);
+
+    // the column with the name, added if there is none yet
+    size_t column(const std::string &name);
+
+    void addResult(size_t column, const BenchmarkResult &result);
+
+    void addCell(size_t column, const std::string &row, const std::string &text);
+
+    bool empty() const {
+        return _rows.empty();
+    }
+
+    void print(std::ostream &os) const;
+};
+
+/*
+The table of a group: the median of every member and its speedup over the baseline, green or red where the
+intervals of the medians don't overlap.
+
+Traversal  std::list<int> (baseline)  std::vector<int>
+$1=8                          120 ns    35 ns (3.43x)
+$1=16                         230 ns    41 ns (5.61x)
+*/
+ComparisonTable groupTable(const BenchmarkGroup &group);
+
+}} //namespaces
@@ -4,12 +4,15 @@
 #if defined(__GNUC__)
 #define BENCHMARK_UNUSED __attribute__((unused))
 #define BENCHMARK_ALWAYS_INLINE __attribute__((always_inline))
+#define BENCHMARK_NOINLINE __attribute__((noinline))
 #elif defined(_MSC_VER) && !defined(__clang__)
 #define BENCHMARK_UNUSED
 #define BENCHMARK_ALWAYS_INLINE __forceinline
+#define BENCHMARK_NOINLINE __declspec(noinline)
 #else
 #define BENCHMARK_UNUSED
 #define BENCHMARK_ALWAYS_INLINE
+#define BENCHMARK_NOINLINE
 #endif
 
 #if (!defined(__GNUC__) && !defined(__clang__)) || defined(__pnacl__) || defined(__EMSCRIPTEN__)
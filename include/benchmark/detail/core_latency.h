@@ -0,0 +1,70 @@
+#pragma once
+#include <vector>
+#include "config.h"
+#include "topology.h"
+
+namespace benchmark {
+namespace detail {
+
+// one-way latency of a cache line bounced between two cpus, from repeated ping-pong rounds
+struct CoreLatencySample {
+    double median; // ns
+    double minimum;
+    double maximum;
+    double average;
+    double stdDev;
+};
+
+/*
+Pins two threads to the cpus and bounces a cache line between them through an atomic counter: the first thread
+writes odd values and waits for the next even one, the second waits for odd values and answers. A round of
+'roundTrips' exchanges divided by twice their number is one one-way latency sample. Returns false if a thread
+couldn't be pinned.
+*/
+bool pingPong(int cpuA, int cpuB, unsigned rounds, unsigned roundTrips, std::vector<double> &oneWay);
+
+CoreLatencySample summarize(std::vector<double> values);
+
+enum CoreRelation {
+    RelationSMT,    // hardware threads of one core
+    RelationL3,     // cores sharing the last level cache
+    RelationSocket, // cores of one package with separate last level caches
+    RelationRemote  // cores of different packages
+};
+
+CoreRelation coreRelation(const LogicalCpu &a, const LogicalCpu &b);
+
+const char *relationName(int relation);
+
+// cpus connected by latencies up to a threshold, one level of the measured hierarchy
+struct LatencyLevel {
+    double threshold; // ns
+    std::vector<std::vector<int>> clusters;
+};
+
+/*
+One-way latencies between every pair of the cpus, the diagonal NaN. Symmetric, each pair is measured once.
+*/
+struct CoreLatencyMatrix {
+    std::vector<LogicalCpu> cpus;
+    std::vector<std::vector<CoreLatencySample>> samples;
+
+    double at(size_t a, size_t b) const {
+        return samples[a][b].median;
+    }
+
+    /*
+    Clusters of the measured latencies alone: the sorted pair latencies are split where one is more than 'gap'
+    times the previous one, and for each split the cpus connected by latencies below it form the clusters.
+    On a two-socket machine with SMT it's typically siblings, then sockets.
+    */
+    std::vector<LatencyLevel> levels(double gap = 1.3) const;
+
+    // latencies of the pairs in each topological relation, NaN for the relations there are no pairs in
+    std::vector<CoreLatencySample> byRelation() const;
+};
+
+CoreLatencyMatrix measureCoreLatency(const std::vector<LogicalCpu> &cpus, unsigned rounds = 20,
+                                      unsigned roundTrips = 1000);
+
+}} //namespaces
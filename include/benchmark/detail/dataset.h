@@ -0,0 +1,225 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace benchmark {
+
+/*
+Seeded inputs for benchmark bodies. Every generator is a small description of the data, state.dataset() makes
+the data once per description (so once per argument value when the size is ARG1) and keeps it for all samples:
+
+    auto &keys = state.dataset(benchmark::data::Zipf(ARG1, 1.1));
+
+The same description gives the same data on every platform: the random numbers come from splitmix64 and the
+distributions are computed here rather than with <random>, which differs between standard libraries.
+*/
+namespace data {
+
+class SplitMix64 {
+    uint64_t _state;
+
+public:
+    explicit SplitMix64(uint64_t seed)
+        : _state(seed) {
+    }
+
+    uint64_t next() {
+        uint64_t z = (_state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    // [0, 1)
+    double nextDouble() {
+        return (double)(next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    // [0, n)
+    uint64_t nextBelow(uint64_t n) {
+        return n == 0 ? 0 : (uint64_t)(nextDouble() * (double)n);
+    }
+};
+
+// bijection of 64-bit values, so that distinct inputs stay distinct keys
+inline uint64_t scramble(uint64_t x) {
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+std::string formatParameter(double value);
+
+// n values uniform in [min, max]
+struct Uniform {
+    using result_type = std::vector<uint64_t>;
+
+    size_t n;
+    uint64_t min, max;
+    uint64_t seed;
+
+    Uniform(size_t n_, uint64_t min_ = 0, uint64_t max_ = UINT64_MAX, uint64_t seed_ = 42)
+        : n(n_), min(min_), max(max_), seed(seed_) {
+    }
+
+    std::string description() const;
+
+    result_type generate() const;
+};
+
+/*
+n values of a universe of keys drawn with the frequency of the k-th most popular one proportional to 1/k^s,
+the skew of real key accesses. Ranks map to fixed pseudo-random keys, so popular keys aren't neighbours.
+*/
+struct Zipf {
+    using result_type = std::vector<uint64_t>;
+
+    size_t n;
+    double s;
+    size_t universe; // distinct keys, n if 0
+    uint64_t seed;
+
+    Zipf(size_t n_, double s_ = 1.0, size_t universe_ = 0, uint64_t seed_ = 42)
+        : n(n_), s(s_), universe(universe_ ? universe_ : n_), seed(seed_) {
+    }
+
+    std::string description() const;
+
+    result_type generate() const;
+};
+
+enum Order {
+    OrderSorted,
+    OrderReversed,
+    OrderNearlySorted // sorted with a fraction of the elements swapped with random others
+};
+
+// n uniform values in the order, e.g. to see what a sort or a branch predictor makes of it
+struct Ordered {
+    using result_type = std::vector<uint64_t>;
+
+    size_t n;
+    Order order;
+    double swapped; // fraction of the elements out of place for OrderNearlySorted
+    uint64_t seed;
+
+    Ordered(size_t n_, Order order_, double swapped_ = 0.01, uint64_t seed_ = 42)
+        : n(n_), order(order_), swapped(swapped_), seed(seed_) {
+    }
+
+    std::string description() const;
+
+    result_type generate() const;
+};
+
+enum LengthDistribution {
+    LengthUniform,  // every length in [minLength, maxLength] equally likely
+    LengthGeometric // short strings common, long ones rare, averaging (minLength + maxLength) / 2 before the cut at maxLength
+};
+
+// n strings of lowercase letters with lengths in [minLength, maxLength]
+struct Strings {
+    using result_type = std::vector<std::string>;
+
+    size_t n;
+    size_t minLength, maxLength;
+    LengthDistribution lengths;
+    uint64_t seed;
+
+    Strings(size_t n_, size_t minLength_, size_t maxLength_, LengthDistribution lengths_ = LengthUniform,
+            uint64_t seed_ = 42)
+        : n(n_), minLength(minLength_), maxLength(std::max(minLength_, maxLength_)), lengths(lengths_), seed(seed_) {
+    }
+
+    std::string description() const;
+
+    result_type generate() const;
+};
+
+// distinct keys to insert and lookups of which hitRatio are among them, the rest guaranteed misses
+struct KeySetData {
+    std::vector<uint64_t> keys;
+    std::vector<uint64_t> lookups;
+};
+
+struct KeySet {
+    using result_type = KeySetData;
+
+    size_t n;
+    size_t lookups;
+    double hitRatio;
+    uint64_t seed;
+
+    KeySet(size_t n_, size_t lookups_, double hitRatio_, uint64_t seed_ = 42)
+        : n(n_), lookups(lookups_), hitRatio(hitRatio_), seed(seed_) {
+    }
+
+    std::string description() const;
+
+    result_type generate() const;
+};
+
+} // namespace data
+
+namespace detail {
+
+/*
+Data of a benchmark by generator description, made on first use and kept over samples and argument values
+until the end of the run. Remembers which descriptions the current block of samples used, for the results.
+*/
+class DatasetCache {
+    struct Entry {
+        virtual ~Entry() {
+        }
+    };
+
+    template<typename T>
+    struct TypedEntry: Entry {
+        T data;
+
+        explicit TypedEntry(T &&data_)
+            : data(std::move(data_)) {
+        }
+    };
+
+    std::map<std::string, std::unique_ptr<Entry>> _entries;
+    std::vector<std::string> _used;
+
+public:
+    template<typename Generator>
+    const typename Generator::result_type &get(const Generator &generator) {
+        using Data = typename Generator::result_type;
+        std::string description = generator.description();
+        if (std::find(_used.begin(), _used.end(), description) == _used.end())
+            _used.push_back(description);
+
+        auto i = _entries.find(description);
+        if (i == _entries.end())
+            i = _entries.emplace(description, std::unique_ptr<Entry>(new TypedEntry<Data>(generator.generate()))).first;
+        return static_cast<TypedEntry<Data> *>(i->second.get())->data;
+    }
+
+    // e.g. "zipf(n=1024, s=1.1, universe=1024, seed=42); uniform(...)"
+    std::string used() const {
+        std::string result;
+        for (auto &description : _used)
+            result += (result.empty() ? "" : "; ") + description;
+        return result;
+    }
+
+    void beginBlock() {
+        _used.clear();
+    }
+
+    void clear() {
+        _entries.clear();
+        _used.clear();
+    }
+};
+
+}} //namespaces
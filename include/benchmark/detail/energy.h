@@ -0,0 +1,65 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "config.h"
+#include "cpu_info.h"
+
+namespace benchmark {
+namespace detail {
+
+// energy of one RAPL domain over a block of samples
+struct EnergyUsage {
+    std::string domain;
+    double joules; // per sample
+    double watts;  // average while the samples ran
+};
+
+// e.g. "1.25 mJ"
+std::string formatEnergy(double joules);
+
+/*
+Reads the RAPL counters right before and after every sample, outside the measured time, and sums up
+the differences. The counters wrap at max_energy_range_uj; a difference over one wrap is what the
+sample can't exceed (minutes at hundreds of watts), so one wrap is all that's handled. The counters
+update about every millisecond, so shorter samples only add up to the right energy over many of them.
+*/
+class EnergyMeter {
+    std::vector<RaplDomain> _domains;
+    std::vector<uint64_t> _before;
+    std::vector<double> _joules;
+    std::vector<bool> _failed;
+    time_point_t _start{};
+    duration_t _time{0};
+    unsigned _samples{0};
+
+public:
+    explicit EnergyMeter(const std::vector<RaplDomain> &domains)
+        : _domains(domains)
+        , _before(domains.size(), 0)
+        , _joules(domains.size(), 0.0)
+        , _failed(domains.size(), false) {
+    }
+
+    bool available() const {
+        return !_domains.empty();
+    }
+
+    // microjoules between two readings of a counter which may have wrapped once
+    static uint64_t difference(uint64_t before, uint64_t after, uint64_t maxRange) {
+        if (after >= before)
+            return after - before;
+        return maxRange - before + after;
+    }
+
+    void clear();
+
+    void begin();
+
+    void end();
+
+    // per domain that could be read all along, empty if there are none or nothing was measured
+    std::vector<EnergyUsage> usage() const;
+};
+
+}} //namespaces
@@ -0,0 +1,214 @@
+#pragma once
+#include <cstddef>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "state.h"
+
+namespace benchmark {
+
+enum FileLocation {
+    FileOnDisk,  // under $TMPDIR, /var/tmp if it isn't set: a real file system with a device underneath
+    FileOnTmpfs  // under /dev/shm: the page cache alone, the kernel paths without a device
+};
+
+/*
+A file of the harness, filled with seeded data and deleted with the object. Made through state.dataset() it's
+created once and kept for the whole run:
+
+    auto &file = state.dataset(benchmark::data::File(64 << 20, benchmark::FileOnDisk));
+
+Besides the usual descriptor it holds one opened with O_DIRECT and a shared mapping of the whole file, so that the
+methods of IoJob can be compared on the same data.
+*/
+class TempFile {
+    std::string _path;
+    int _fd;
+    int _directFd;
+    size_t _size;
+    char *_map;
+
+    // where the next sequential batch starts and how many random ones there were, so that consecutive batches
+    // don't read the same blocks again
+    mutable uint64_t _cursor;
+    mutable uint64_t _batches;
+
+public:
+    TempFile(size_t size, int location = FileOnDisk, uint64_t seed = 42);
+
+    TempFile(TempFile &&other);
+
+    TempFile(const TempFile &) = delete;
+    TempFile &operator=(const TempFile &) = delete;
+
+    ~TempFile();
+
+    bool valid() const {
+        return _fd >= 0;
+    }
+
+    const std::string &path() const {
+        return _path;
+    }
+
+    size_t size() const {
+        return _size;
+    }
+
+    int fd() const {
+        return _fd;
+    }
+
+    // -1 where the file system doesn't support O_DIRECT, e.g. tmpfs
+    int directFd() const {
+        return _directFd;
+    }
+
+    // nullptr if the file couldn't be mapped
+    char *map() const {
+        return _map;
+    }
+
+    // Writes the dirty pages back, unmaps them from the shared mapping with madvise(MADV_DONTNEED) (mapped pages
+    // aren't evicted) and evicts the file from the page cache with posix_fadvise(POSIX_FADV_DONTNEED), the next
+    // reads go to the device. Call it before MEASURE for cold-cache timings. False if mincore(2) still finds pages of
+    // the file in the page cache afterwards, as always on tmpfs.
+    bool dropCache() const;
+
+    // pages of the file in the page cache, as mincore(2) sees them through the mapping; -1 if it can't tell
+    long residentPages() const;
+
+    // offset of the next sequential batch of 'blocks' blocks, wrapping at the end of the file
+    uint64_t nextSequential(size_t blockSize, size_t blocks) const;
+
+    // a different seed for every batch of random offsets
+    uint64_t nextBatch() const {
+        return _batches++;
+    }
+};
+
+namespace data {
+
+// description of a TempFile for state.dataset(), e.g. "file(size=67108864, location=disk, seed=42)"
+struct File {
+    using result_type = TempFile;
+
+    size_t size;
+    int location;
+    uint64_t seed;
+
+    File(size_t size_, int location_ = FileOnDisk, uint64_t seed_ = 42)
+        : size(size_), location(location_), seed(seed_) {
+    }
+
+    std::string description() const;
+
+    result_type generate() const;
+};
+
+} // namespace data
+
+enum IoMethod {
+    IoPread, // pread(2) and pwrite(2) through the page cache
+    IoMmap,  // copies from and to the shared mapping, page faults included
+    IoDirect // pread(2) and pwrite(2) with O_DIRECT around the page cache, blocks must be multiples of 4 KiB
+};
+
+enum IoPattern {
+    IoSequential, // consecutive blocks, every batch continuing where the previous one on the file stopped
+    IoRandom      // block-aligned offsets uniform over the file
+};
+
+enum IoMode {
+    IoRead,
+    IoWrite,
+    IoWriteSync // every write followed by fdatasync(2) (msync(2) for IoMmap), one request at a time
+};
+
+/*
+A batch of block reads or writes over a TempFile. With a queue depth above one, that many threads of the job issue
+blocking requests at the same time (POSIX AIO of glibc serializes the requests of a descriptor, io_uring would be a
+dependency); IoMmap and IoWriteSync ignore the queue depth. Buffers and threads are made in the constructor, which
+can stay out of the sample:
+
+    benchmark::IoJob job(benchmark::IoDirect, benchmark::IoRandom, 4096, 64, 8);
+    MEASURE_IO(job, file)
+
+The sample is the whole batch, reported per block together with IOPS and bandwidth. For latency distributions of
+single requests, e.g. of fsync, make batches of one block and ask for the percentiles with --percentiles.
+*/
+class IoJob {
+    int _method;
+    int _pattern;
+    int _mode;
+    size_t _blockSize;
+    size_t _blocks;
+    unsigned _queueDepth;
+    uint64_t _seed;
+    std::vector<char *> _buffers; // one per request in flight, aligned for O_DIRECT
+    std::vector<uint64_t> _offsets;
+
+    // queue depth: the threads besides the caller, woken up for every batch
+    std::vector<std::thread> _workers;
+    std::mutex _mutex;
+    std::condition_variable _wake, _done;
+    uint64_t _generation;
+    unsigned _busy;
+    bool _stop;
+    int _fd;
+    std::atomic<size_t> _next;
+    std::atomic<uint64_t> _bytes;
+
+    // requests of the batch until there are none left, returns the bytes of those it made
+    uint64_t drain(int fd, char *buffer);
+    void work(unsigned index);
+
+    uint64_t runQueued(int fd);
+    uint64_t runMapped(char *map);
+
+public:
+    IoJob(int method, int pattern, size_t blockSize, size_t blocks = 64, unsigned queueDepth = 1, int mode = IoRead,
+          uint64_t seed = 42);
+
+    IoJob(const IoJob &) = delete;
+    IoJob &operator=(const IoJob &) = delete;
+
+    ~IoJob();
+
+    size_t blocks() const {
+        return _blocks;
+    }
+
+    // picks the offsets of the next batch on the file, the part of run() that isn't worth timing
+    void prepare(const TempFile &file);
+
+    // bytes read or written, short of blocks * blockSize if a request failed
+    uint64_t run(const TempFile &file);
+};
+
+namespace detail {
+
+// e.g. "41.2 kops/s", "161 MB/s", decimal prefixes
+std::string formatRate(double perSecond, const char *unit);
+
+} // namespace detail
+
+// one batch of the job as the sample, per block with the IOPS and the bandwidth
+inline void measureIo(detail::RunState &state, IoJob &job, const TempFile &file) {
+    job.prepare(file);
+
+    state.start();
+    uint64_t bytes = job.run(file);
+    state.stop();
+
+    state.setOperations(job.blocks());
+    state.setBytes(bytes);
+}
+
+} // namespace benchmark
+
+#define MEASURE_IO(job, file) benchmark::measureIo(state, job, file);
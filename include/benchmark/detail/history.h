@@ -0,0 +1,193 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <vector>
+#include "config.h"
+#include "results.h"
+
+namespace benchmark {
+namespace detail {
+
+/*
+Result history, one file for all runs of all benchmarks, appended to and never rewritten:
+
+[HistoryHeader, 64 bytes][HistoryRecord, 384 bytes][HistoryRecord]...
+
+Records have a fixed size, so the file is read by mapping it and indexing the records in place, and a run
+which crashed in the middle of an append leaves at most a partial record at the end, which is ignored.
+Every run appends all of its records with a single write() to a file opened with O_APPEND, so runs
+on the same machine may share a history file. Fields are in the host byte order.
+*/
+struct HistoryHeader {
+    char magic[8]; // "BMHIST\0\0"
+    uint32_t version;
+    uint32_t recordSize;
+    char reserved[48];
+};
+
+struct HistoryRecord {
+    static const unsigned MaxArgs = 4;
+
+    char name[104];    // zero terminated, truncated if longer
+    char revision[40]; // git revision of the benchmarked code
+    uint64_t machine;  // fingerprint of the machine, see machineFingerprint()
+    int64_t timestamp; // seconds since the epoch
+    uint32_t argCount;
+    uint32_t iterations;
+    int64_t args[MaxArgs];
+    // nanoseconds
+    double median;
+    double average;
+    double minimum;
+    double maximum;
+    double stdDev;
+    double medianLower; // confidence interval of the median, equal to the median if there is none
+    double medianUpper;
+    uint64_t variant; // hash of the partition, memory, antagonist and layout labels, 0 without any
+    char labels[120]; // the same labels to print, "; " between them, zero terminated, truncated if longer
+
+    bool sameSeries(const HistoryRecord &other) const {
+        return machine == other.machine && variant == other.variant && argCount == other.argCount &&
+               std::equal(args, args + argCount, other.args) && std::strncmp(name, other.name, sizeof(name)) == 0;
+    }
+
+    // of what sameSeries() compares
+    uint64_t seriesHash() const;
+};
+
+static_assert(sizeof(HistoryHeader) == 64, "history header layout");
+static_assert(sizeof(HistoryRecord) == 384, "history record layout");
+
+inline uint64_t fnv1a(const void *data, size_t size, uint64_t hash = 14695981039346656037ull) {
+    for (size_t i = 0; i < size; i++) {
+        hash ^= ((const unsigned char *)data)[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+inline uint64_t fnv1a(const std::string &text, uint64_t hash = 14695981039346656037ull) {
+    return fnv1a(text.data(), text.size(), hash);
+}
+
+// what the timings depend on besides the code: the host, the CPU model and the number of cores
+uint64_t machineFingerprint();
+
+// BENCHMARK_REVISION if set (CI knows better what is being built), otherwise the revision of the working directory
+std::string currentRevision();
+
+// the records of a history file read in place from its mapping, valid while the object lives
+class HistoryMapping {
+    friend class HistoryLog;
+
+    void *_mapped;
+    size_t _size;
+    const HistoryRecord *_records;
+    size_t _count;
+
+public:
+    HistoryMapping()
+        : _mapped(nullptr), _size(0), _records(nullptr), _count(0) {
+    }
+
+    HistoryMapping(const HistoryMapping &) = delete;
+    HistoryMapping &operator=(const HistoryMapping &) = delete;
+
+    ~HistoryMapping();
+
+    const HistoryRecord *begin() const {
+        return _records;
+    }
+
+    const HistoryRecord *end() const {
+        return _records + _count;
+    }
+
+    size_t size() const {
+        return _count;
+    }
+};
+
+class HistoryLog {
+    static const uint32_t Version = 2;
+
+    std::string _path;
+
+    static double toNs(duration_t d) {
+        return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+    }
+
+    static void copyText(char *dst, size_t size, const std::string &text) {
+        std::memset(dst, 0, size);
+        std::memcpy(dst, text.data(), std::min(text.size(), size - 1));
+    }
+
+public:
+    // the runs of one benchmark with one argument tuple and the same labels on one machine, oldest first
+    struct Series {
+        std::vector<const HistoryRecord *> runs;
+
+        const HistoryRecord &latest() const {
+            return *runs.back();
+        }
+    };
+
+    // the largest shift of the median between two consecutive segments of runs
+    struct StepChange {
+        bool found;
+        size_t index; // first run after the change
+        double before; // ns, mean of the medians of the runs before
+        double after;
+        double relative; // after / before - 1
+    };
+
+    explicit HistoryLog(const std::string &path)
+        : _path(path) {
+    }
+
+    static HistoryRecord makeRecord(const BenchmarkResult &result, const std::string &revision, uint64_t machine,
+                                    int64_t timestamp);
+
+    bool append(const std::vector<HistoryRecord> &records);
+
+    // maps the file for reading, an empty mapping if nothing was appended yet
+    bool map(HistoryMapping &mapping) const;
+
+    // calls consume(const HistoryRecord &) for every complete record, in the order of appending
+    bool read(const std::function<void(const HistoryRecord &)> &consume) const;
+
+    std::vector<HistoryRecord> records() const;
+
+    // groups the records, series appear in the order of their first run and point into the records
+    static std::vector<Series> series(const HistoryRecord *begin, const HistoryRecord *end, const std::string &filter);
+
+    static std::vector<Series> series(const std::vector<HistoryRecord> &records, const std::string &filter) {
+        return series(records.data(), records.data() + records.size(), filter);
+    }
+
+    // least squares slope of the medians, relative to their mean, per run
+    static double trend(const std::vector<const HistoryRecord *> &runs);
+
+    /*
+    Splits the runs in two segments of at least 2 runs each where the shift of the mean median is the largest
+    compared to the scatter within the segments (a two-sample t statistic). The scatter is never taken below what
+    the confidence intervals of single runs tell, so that a few identical runs don't make any shift significant.
+    */
+    static StepChange stepChange(const std::vector<const HistoryRecord *> &runs, double minRelative = 0.02,
+                                 double minScore = 4.0);
+
+    static std::string formatDate(int64_t timestamp);
+
+    static std::string percent(double fraction);
+
+    static duration_t fromNs(double ns);
+
+    // trends of the last runs of every series which name contains the filter
+    bool printQuery(std::ostream &os, const std::string &filter, size_t last) const;
+};
+
+}} //namespaces
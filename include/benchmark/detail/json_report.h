@@ -0,0 +1,23 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "comparison_table.h"
+#include "results.h"
+
+namespace benchmark {
+namespace detail {
+
+/*
+All results of a run and the tables of the benchmark groups in one JSON document, for scripts and CI rather than
+for reading. Times are in nanoseconds; a group has a row per argument value and a cell per member, null where the
+member has no result in the row, the speedup null where there is nothing to compare to:
+
+{"benchmarks": [{"name": "Traversal<std::list<int>>", "arg": 8, "median_ns": 120, ...}, ...],
+ "groups": [{"name": "Traversal", "baseline": "std::list<int>", "columns": ["std::list<int>", "std::vector<int>"],
+             "rows": [{"row": "$1=8", "arg": 8, "cells": [{"benchmark": "Traversal<std::list<int>>",
+                       "median_ns": 120, "speedup": 1, "significant": false}, ...]}, ...]}]}
+*/
+bool writeJsonReport(const std::string &path, const std::vector<BenchmarkResult> &results,
+                     const std::vector<BenchmarkGroup> &groups);
+
+}} //namespaces
@@ -0,0 +1,123 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "config.h"
+#include "memory_resource.h"
+#include "results.h"
+#include "state.h"
+
+#ifdef WIN32
+#include <malloc.h>
+#else
+#include <alloca.h>
+#endif
+
+namespace benchmark {
+namespace detail {
+
+/*
+Where a block of samples finds its memory, moved by amounts derived from the layout number; layout 0 moves nothing.
+A benchmark gains or loses several percent from where its stack frame, its heap blocks and its buffers fall
+relative to cache lines, pages and the 4 KiB aliasing of loads and stores, with no change in the code. The offsets
+are multiples of 16 below 4 KiB, so that every placement within a page is reachable:
+
+- stack: the samples run that much deeper on the stack, as with a larger environment or more program arguments
+- heap: a block of that size is held from the heap for the whole block of samples, moving where the allocations
+  of the body start
+- data: what the body allocates from state.memory() is shifted by that much, or by the same number of steps of the
+  alignment asked for if that is larger than 16, see OffsetResource
+*/
+struct MemoryLayout {
+    unsigned index;
+    size_t stack;
+    size_t heap;
+    size_t data;
+
+    // e.g. "layout 3 (stack+1536, heap+2272, data+48)", "layout 0 (default)"
+    std::string description() const;
+};
+
+MemoryLayout memoryLayout(unsigned index);
+
+// values of the layout list dimension, the default layout first
+std::vector<int> layoutList(unsigned layouts);
+
+// runs func that many bytes deeper on the stack, out of line so that func's own frame is below the gap
+template<typename F>
+BENCHMARK_NOINLINE void callDeeper(F &func) {
+    func();
+}
+
+template<typename F>
+BENCHMARK_NOINLINE void withStackOffset(size_t bytes, F &&func) {
+#ifdef WIN32
+    volatile char *gap = (volatile char *)_alloca(bytes + 1);
+#else
+    volatile char *gap = (volatile char *)alloca(bytes + 1);
+#endif
+    gap[0] = 0;
+    callDeeper(func);
+    gap[0] = 0; // keeps the gap alive until func returns
+}
+
+/*
+Allocations of another resource moved by the data offset of a layout. An offset of n steps of 16 bytes moves an
+allocation aligned to A > 16 by n steps of A instead, wrapping at a page or 16 steps, whichever is larger, so that
+64-byte aligned blocks fall at different places within a page too and page aligned ones on different pages.
+*/
+class OffsetResource: public MemoryResource {
+    MemoryResource *_resource;
+    size_t _offset;
+
+    size_t shift(size_t alignment) const;
+
+public:
+    OffsetResource(MemoryResource *resource, size_t offset)
+        : _resource(resource), _offset(offset) {
+    }
+
+    std::string description() const override {
+        return _resource->description();
+    }
+
+    void reset() override {
+        _resource->reset();
+    }
+
+protected:
+    void *doAllocate(size_t bytes, size_t alignment) override {
+        return (char *)_resource->allocate(bytes + shift(alignment), alignment) + shift(alignment);
+    }
+
+    void doDeallocate(void *p, size_t bytes, size_t alignment) override {
+        _resource->deallocate((char *)p - shift(alignment), bytes + shift(alignment), alignment);
+    }
+};
+
+/*
+How the medians of the same benchmark under different layouts vary, split into what the sampling noise of a median
+explains and what is left for the layouts. A speedup of less than about two layout deviations may be just a layout
+that happens to suit the faster variant. In nanoseconds:
+*/
+struct LayoutVariance {
+    unsigned layouts;
+    double median;       // of the medians
+    double minimum;      // the fastest layout's median
+    double maximum;      // the slowest layout's median
+    double sampleStdDev; // of the samples within a layout, pooled over the layouts
+    double medianNoise;  // standard error of a median from the samples alone, pooled
+    double layoutStdDev; // of the medians with the noise taken out, 0 if the noise explains it all
+    double layoutShare;  // of the variance of the medians, from 0 to 1
+};
+
+// the results of one argument value, one per layout
+LayoutVariance layoutVariance(const std::vector<BenchmarkResult> &results);
+
+}} //namespaces
+
+// runs the benchmark under the default memory layout and N - 1 randomized ones, their variance in a table at the end:
+// LAYOUTS(8)
+#define LAYOUTS(n) \
+    if (state.addList(benchmark::detail::ListLayout, benchmark::detail::layoutList(n))) return;
@@ -0,0 +1,170 @@
+#pragma once
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+#if __cplusplus >= 201703L && defined(__has_include)
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#define BENCHMARK_HAS_PMR 1
+#endif
+#endif
+
+namespace benchmark {
+
+/*
+Where the data of a benchmark body comes from, with the interface of std::pmr::memory_resource.
+The body gets the one the benchmark is configured with from state.memory(); what it allocates from it
+lives until the end of the sample at most.
+*/
+class MemoryResource {
+    size_t _allocations{0};
+    size_t _allocatedBytes{0};
+
+public:
+    virtual ~MemoryResource() {
+    }
+
+    void *allocate(size_t bytes, size_t alignment = alignof(std::max_align_t)) {
+        _allocations++;
+        _allocatedBytes += bytes;
+        return doAllocate(bytes, alignment);
+    }
+
+    void deallocate(void *p, size_t bytes, size_t alignment = alignof(std::max_align_t)) {
+        doDeallocate(p, bytes, alignment);
+    }
+
+    // what the memory is like, goes to the results, e.g. "local, node 0"
+    virtual std::string description() const = 0;
+
+    // called after every sample, everything allocated since the previous call may be reused
+    virtual void reset() {
+    }
+
+    // since the resource was made, reset() doesn't change them; a counter track of --trace per sample
+    size_t allocations() const {
+        return _allocations;
+    }
+
+    size_t allocatedBytes() const {
+        return _allocatedBytes;
+    }
+
+protected:
+    virtual void *doAllocate(size_t bytes, size_t alignment) = 0;
+    virtual void doDeallocate(void *p, size_t bytes, size_t alignment) = 0;
+};
+
+// the global heap
+class SystemResource: public MemoryResource {
+public:
+    std::string description() const override {
+        return "system";
+    }
+
+protected:
+    void *doAllocate(size_t bytes, size_t alignment) override {
+        if (alignment <= alignof(std::max_align_t))
+            return ::operator new(bytes);
+
+        void *p = nullptr;
+#ifdef WIN32
+        p = _aligned_malloc(bytes, alignment);
+#else
+        if (posix_memalign(&p, alignment, bytes) != 0)
+            p = nullptr;
+#endif
+        if (!p)
+            throw std::bad_alloc();
+        return p;
+    }
+
+    void doDeallocate(void *p, size_t, size_t alignment) override {
+        if (alignment <= alignof(std::max_align_t)) {
+            ::operator delete(p);
+            return;
+        }
+#ifdef WIN32
+        _aligned_free(p);
+#else
+        std::free(p);
+#endif
+    }
+};
+
+// standard allocator on top of a MemoryResource: std::vector<int, benchmark::Allocator<int>> v(state.allocator<int>());
+template<typename T>
+class Allocator {
+    template<typename U>
+    friend class Allocator;
+
+    MemoryResource *_resource;
+
+public:
+    using value_type = T;
+
+    explicit Allocator(MemoryResource *resource)
+        : _resource(resource) {
+    }
+
+    template<typename U>
+    Allocator(const Allocator<U> &other)
+        : _resource(other._resource) {
+    }
+
+    T *allocate(size_t n) {
+        return (T *)_resource->allocate(n * sizeof(T), alignof(T));
+    }
+
+    void deallocate(T *p, size_t n) {
+        _resource->deallocate(p, n * sizeof(T), alignof(T));
+    }
+
+    MemoryResource *resource() const {
+        return _resource;
+    }
+
+    template<typename U>
+    bool operator==(const Allocator<U> &other) const {
+        return _resource == other._resource;
+    }
+
+    template<typename U>
+    bool operator!=(const Allocator<U> &other) const {
+        return _resource != other._resource;
+    }
+};
+
+#ifdef BENCHMARK_HAS_PMR
+// std::pmr view of a MemoryResource: PmrAdapter pmr(&state.memory()); std::pmr::vector<int> v(&pmr);
+class PmrAdapter: public std::pmr::memory_resource {
+    MemoryResource *_resource;
+
+public:
+    explicit PmrAdapter(MemoryResource *resource)
+        : _resource(resource) {
+    }
+
+    MemoryResource *resource() const {
+        return _resource;
+    }
+
+private:
+    void *do_allocate(size_t bytes, size_t alignment) override {
+        return _resource->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override {
+        _resource->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+        auto adapter = dynamic_cast<const PmrAdapter *>(&other);
+        return adapter && adapter->_resource == _resource;
+    }
+};
+#endif
+
+} // namespace benchmark
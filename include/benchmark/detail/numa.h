@@ -0,0 +1,61 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace benchmark {
+
+// where state.memory() puts the pages, relative to the node of the benchmark thread
+enum NumaPlacement {
+    PlaceDefault,    // no policy, the kernel places pages where they are touched first
+    PlaceLocal,      // bound to the node of the benchmark thread
+    PlaceRemote,     // bound to another node
+    PlaceInterleave, // spread over all nodes page by page
+    PlaceFirstTouch = 0x10000 // touched first by a thread pinned to a cpu, see firstTouchOn()
+};
+
+inline int firstTouchOn(int cpu) {
+    return PlaceFirstTouch + cpu;
+}
+
+namespace detail {
+
+struct NumaNode {
+    int id;
+    std::vector<int> cpus;
+    uint64_t memTotal; // kB
+};
+
+// nodes of /sys/devices/system/node, a single node 0 with all cpus if there is no such thing
+std::vector<NumaNode> readNumaNodes();
+
+int nodeOfCpu(const std::vector<NumaNode> &nodes, int cpu);
+
+// "local", "remote", "interleave", "default" or "firsttouch:<cpu>", -1 if it's none of them
+int parsePlacement(const std::string &text);
+
+long mbind(void *addr, size_t len, int mode, const std::vector<int> &nodes);
+
+/*
+What a placement means on this machine for the calling thread. Pages are bound with mbind(2), called
+directly so that libnuma isn't needed.
+*/
+struct NumaPolicy {
+    int placement;
+    int mode; // MPOL_*, 0 if no policy is set
+    std::vector<int> memoryNodes;
+    int threadNode;
+    int touchCpu; // -1 unless the pages are touched first by another thread
+    std::string description;
+
+    NumaPolicy(int placement_, const std::vector<NumaNode> &nodes);
+
+    // returns false if the policy couldn't be applied
+    bool bind(void *p, size_t size) const;
+
+    // pages of the range get allocated on the node of touchCpu, if there is one
+    void touch(void *p, size_t size) const;
+};
+
+}} //namespaces
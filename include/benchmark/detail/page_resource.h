@@ -0,0 +1,113 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "memory_resource.h"
+#include "numa.h"
+
+namespace benchmark {
+
+// pages behind state.memory(), for TLB-bound working sets
+enum PageBacking {
+    BackingDefault,  // whatever the system does, THP included if it's enabled system-wide
+    Backing4K,       // base pages only, THP disabled for the range
+    BackingTHP,      // transparent huge pages requested with madvise
+    BackingHuge2M,   // MAP_HUGETLB, needs pages reserved in /proc/sys/vm/nr_hugepages
+    BackingHuge1G,   // MAP_HUGETLB, needs 1G pages reserved at boot
+    BackingPopulate  // base pages, all faulted in when mapped
+};
+
+namespace detail {
+
+// "default", "4k", "thp", "2m", "1g" or "populate", -1 if it's none of them
+int parseBacking(const std::string &text);
+
+const char *backingName(int backing);
+
+/*
+Carves allocations from chunks of pages mapped with the backing and bound with the NUMA policy the resource
+is created with; deallocation does nothing, the chunks are reused from the start after every sample and
+unmapped with the resource. Explicit huge pages which aren't reserved fall back to transparent ones, and
+the description says so.
+*/
+class PageResource: public MemoryResource {
+    static const size_t ChunkSize = 4 << 20;
+    static const size_t HugePage2M = 2 << 20;
+
+    struct Chunk {
+        char *data;
+        size_t size;
+    };
+
+    NumaPolicy _policy;
+    int _backing;
+    bool _bindFailed{false};
+    bool _fellBack{false}; // some chunks are THP instead of explicit huge pages
+
+    std::vector<Chunk> _chunks;
+    size_t _current{0};
+    size_t _offset{0};
+
+    // of the pages the next chunk is mapped with, 2M once 1G pages fell back to THP
+    size_t pageSize() const;
+
+#ifndef WIN32
+    // huge pages need an aligned range, so more is mapped and the ends are cut off
+    static void *mapAligned(size_t size, size_t alignment, int flags);
+
+    // size is of the huge pages, or of the 2M ones THP falls back to
+    void *mapHuge(size_t wanted, size_t &size);
+#endif
+
+    Chunk mapChunk(size_t size);
+
+public:
+    PageResource(int placement, int backing, const std::vector<NumaNode> &nodes);
+
+    ~PageResource() override;
+
+    // e.g. "remote, memory node 1, thread node 0, 2M pages not reserved, THP"
+    std::string description() const override;
+
+    void reset() override {
+        _current = 0;
+        _offset = 0;
+    }
+
+    const NumaPolicy &policy() const {
+        return _policy;
+    }
+
+    int backing() const {
+        return _backing;
+    }
+
+    bool fellBack() const {
+        return _fellBack;
+    }
+
+protected:
+    void *doAllocate(size_t bytes, size_t alignment) override {
+        for (; _current < _chunks.size(); _current++, _offset = 0) {
+            Chunk &chunk = _chunks[_current];
+            size_t start = (_offset + alignment - 1) / alignment * alignment;
+            if (start + bytes <= chunk.size) {
+                _offset = start + bytes;
+                return chunk.data + start;
+            }
+        }
+
+        // chunks are page aligned, which is enough for any alignment up to the page size
+        size_t chunkSize = ChunkSize;
+        _chunks.push_back(mapChunk(std::max(chunkSize, bytes + alignment)));
+        _current = _chunks.size() - 1;
+        _offset = bytes;
+        return _chunks.back().data;
+    }
+
+    void doDeallocate(void *, size_t, size_t) override {
+    }
+};
+
+}} //namespaces
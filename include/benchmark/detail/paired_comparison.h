@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "bootstrap.h"
+
+namespace benchmark {
+namespace detail {
+
+// of two variants measured in alternation, the i-th samples of both taken in the same block
+struct PairedComparison {
+    size_t pairs;
+    double ratio;                // median of A / median of B, above 1 when B is faster
+    ConfidenceInterval interval; // of the ratio
+    double pValue;               // Wilcoxon signed-rank test of the pair differences, two-sided
+};
+
+double medianOf(std::vector<double> values);
+
+/*
+Two-sided p-value of the hypothesis that the differences are symmetric around zero. Zero differences are
+dropped, tied magnitudes get their average rank, and the rank sum is compared to its normal approximation
+with the tie correction, which is close enough from about 10 pairs on.
+*/
+double wilcoxonSignedRank(const std::vector<double> &differences);
+
+/*
+Ratio of the medians with a percentile bootstrap interval: the pairs are resampled as a whole, so that whatever
+the machine did during a block affects both sides of a resample the same way.
+*/
+PairedComparison comparePaired(const std::vector<double> &a, const std::vector<double> &b,
+                               unsigned resamples, double confidence, uint64_t seed);
+
+// significant when the test rejects at 'alpha' and the interval of the ratio excludes 1
+bool significant(const PairedComparison &comparison, double alpha = 0.05);
+
+/*
+"B is 1.18x faster ±0.02 (p < 0.001)", "B is 1.05x slower ±0.01 (p = 0.003)" or
+"no significant difference between A and B (1.01x ±0.03, p = 0.41)". The speedup of a slower B is the inverted ratio.
+*/
+std::string comparisonVerdict(const std::string &a, const std::string &b, const PairedComparison &comparison);
+
+}} //namespaces
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "bootstrap.h"
+#include "config.h"
+#include "energy.h"
+
+namespace benchmark {
+namespace detail {
+
+// what is left of a benchmark run for one argument value once it's printed
+struct BenchmarkResult {
+    std::string name;
+    bool hasArg;
+    int arg;
+    unsigned iterations;
+    uint64_t operations; // per sample, 0 when a sample isn't split into operations
+    uint64_t bytes;      // per sample, 0 unless the benchmark reports a bandwidth
+    duration_t average;
+    duration_t median;
+    duration_t minimum;
+    duration_t maximum;
+    duration_t stdDev;
+    ConfidenceInterval medianInterval;
+    unsigned warmupSamples; // discarded before steady state
+    duration_t warmupTime;
+    std::string partition; // empty unless run in the parallel mode
+    std::string memory;    // placement of state.memory(), e.g. "remote, memory node 1, thread node 0"
+    std::string datasets;  // generators of state.dataset() with their parameters and seeds, e.g. "zipf(n=64, s=1.1, ...)"
+    std::string antagonist; // background load of the block with --antagonists, e.g. "llc on cpus 2-7" or "quiet"
+    std::string layout;     // memory layout of the block with --layouts, e.g. "layout 3 (stack+1536, heap+2272, data+48)"
+    std::vector<EnergyUsage> energy; // per RAPL domain with --energy, empty if unavailable
+    std::vector<std::pair<std::string, double>> counters; // state.setCounter() values, mean per sample
+    std::string comparison; // verdict against the first variant of BENCHMARK_COMPARE, e.g. "B is 1.18x faster ±0.02 (p < 0.001)"
+};
+
+}} //namespaces
@@ -0,0 +1,73 @@
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "config.h"
+#include "sample_dump_format.h"
+#include "state.h"
+
+namespace benchmark {
+namespace detail {
+
+/*
+Writes every sample into a file mapped at open, preallocated for 'capacity' samples. Recording a sample is a few
+stores into the mapping, a sched_getcpu() and a pread() of the core frequency from a file opened in advance:
+nothing is allocated or formatted. Samples beyond the capacity are counted and dropped.
+*/
+class SampleDump {
+    static const unsigned MaxCounters = DumpColumnCount - DumpCounter0;
+
+    std::string _path;
+    int _fd{-1};
+    char *_mapped{nullptr};
+    size_t _mappedSize{0};
+    SampleDumpHeader *_header{nullptr};
+    time_point_t _origin;
+
+    std::vector<std::string> _blocks;
+    std::vector<std::string> _counters;
+    std::vector<int> _freqFds; // scaling_cur_freq of every core, -1 if not available
+    std::mutex _mutex;         // benchmarks of the parallel mode share the dump
+
+    template<typename T>
+    T *column(unsigned index) {
+        return (T *)(_mapped + _header->columns[index].offset);
+    }
+
+    static void setColumn(SampleDumpColumn &column, const char *name, uint32_t type, uint64_t offset);
+
+    uint32_t readFrequency(int core) const;
+
+public:
+    SampleDump(const std::string &path, uint64_t capacity);
+
+    ~SampleDump() {
+        close();
+    }
+
+    SampleDump(const SampleDump &) = delete;
+    SampleDump &operator=(const SampleDump &) = delete;
+
+    bool isOpen() const {
+        return _header != nullptr;
+    }
+
+    // a benchmark with one argument value; the returned index goes to record()
+    uint32_t beginBlock(const std::string &name);
+
+    void record(uint32_t block, const RunState &state, duration_t sample);
+
+    uint64_t rows() const {
+        return _header ? _header->rows : 0;
+    }
+
+    uint64_t dropped() const {
+        return _header ? _header->dropped : 0;
+    }
+
+    // packs the columns, appends the names and truncates the file to what is used
+    void close();
+};
+
+}} //namespaces
@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdint>
+
+namespace benchmark {
+namespace detail {
+
+/*
+Raw sample dump, written by SampleDump and read by benchmark::SampleDumpReader:
+
+[SampleDumpHeader, 512 bytes][column 0: rows values][column 1: rows values]...[names]
+
+Each column is a plain array, the values of one sample are at the same index in all of them. While a run is in
+progress the columns are spaced by the capacity of the file and 'rows' grows with every sample; once the dump
+is closed they are packed and the names of the blocks (benchmark and argument) and of the counters are appended,
+zero terminated, blocks first. Fields are in the host byte order.
+*/
+enum SampleColumnType : uint32_t {
+    ColumnInt64,
+    ColumnInt32,
+    ColumnUInt32,
+    ColumnDouble
+};
+
+inline uint32_t columnTypeSize(uint32_t type) {
+    return (type == ColumnInt64 || type == ColumnDouble) ? 8 : 4;
+}
+
+struct SampleDumpColumn {
+    char name[24];
+    uint32_t type; // SampleColumnType
+    uint32_t reserved;
+    uint64_t offset; // from the file start
+};
+
+struct SampleDumpHeader {
+    static const unsigned MaxColumns = 11;
+
+    char magic[8]; // "BMSAMPL\0"
+    uint32_t version;
+    uint32_t columnCount;
+    uint64_t capacity;
+    uint64_t rows;
+    uint64_t dropped;   // samples which didn't fit
+    int64_t startTime;  // nanoseconds since the epoch, the timestamps are relative to it
+    uint64_t namesOffset; // 0 until the dump is closed
+    uint32_t namesSize;
+    uint32_t blockCount;
+    uint32_t counterCount;
+    uint32_t closed;
+    SampleDumpColumn columns[MaxColumns];
+};
+
+static_assert(sizeof(SampleDumpColumn) == 40, "sample dump column layout");
+static_assert(sizeof(SampleDumpHeader) == 512, "sample dump header layout");
+
+// the columns, in the order they are laid out
+enum SampleDumpColumnIndex {
+    DumpTimestamp,   // int64 ns since startTime
+    DumpDuration,    // int64 ns, timer overhead subtracted
+    DumpRawDuration, // int64 ns
+    DumpBlock,       // uint32, index of the block name
+    DumpCore,        // int32, -1 if unknown
+    DumpFrequency,   // uint32 kHz, 0 if unknown
+    DumpCounter0,    // double, NaN when the sample didn't set the counter
+    DumpColumnCount = DumpCounter0 + 4
+};
+
+}} //namespaces
@@ -1,7 +1,13 @@
 #pragma once
+#include <algorithm>
 #include <chrono>
+#include <cstdint>
+#include <string>
+#include <utility>
 #include <vector>
 #include "config.h"
+#include "dataset.h"
+#include "memory_resource.h"
 
 namespace benchmark {
     namespace detail {
@@ -40,17 +46,68 @@ namespace benchmark {
             return GrowthType::Linear;
         }
 
+        // dimensions of a benchmark swept over a list of values rather than a range
+        enum ListKind {
+            ListPlacement, // NUMA placement of state.memory()
+            ListBacking,   // pages behind state.memory()
+            ListAllocator, // allocation strategy of state.memory()
+            ListAntagonist, // background load while the samples are taken
+            ListLayout      // randomized stack, heap and state.memory() offsets
+        };
+
+        struct ListDimension {
+            ListKind kind;
+            std::vector<int> values;
+            size_t index;
+        };
+
+        // Iterates over every combination of the list dimensions and the argument range, the argument changing first
         class BenchmarkState {
             bool _firstTime;
 
             std::vector<VariableArgument> _variableArgs;
+            std::vector<ListDimension> _lists;
+            std::vector<ListKind> _ignoredLists; // kinds addList() leaves out
             int _currentArg1;
             bool _variablesDone;
+            bool _started; // the first combination has been picked since the last dimension was added
 
             bool _needRestart;
 
+            static int nextValue(const VariableArgument &varg) {
+                switch (varg.growth) {
+                    case Linear:
+                        return varg.value + (varg.growing ? 1 : -1);
+                    case Exponential2:
+                        return varg.growing ? varg.value * 2 : varg.value / 2;
+                    case Exponential10:
+                        return varg.growing ? varg.value * 10 : varg.value / 10;
+                }
+                return varg.value;
+            }
+
+            static bool inRange(const VariableArgument &varg, int value) {
+                return varg.growing ? value <= varg.range.second : value >= varg.range.second;
+            }
+
+            bool lastCombination() const {
+                if (!_variableArgs.empty() && inRange(_variableArgs[0], nextValue(_variableArgs[0])))
+                    return false;
+                for (auto &list : _lists) {
+                    if (list.index + 1 < list.values.size())
+                        return false;
+                }
+                return true;
+            }
+
+            void dimensionAdded() {
+                _variablesDone = false;
+                _started = false;
+                _needRestart = true;
+            }
+
         public:
-            BenchmarkState() :_firstTime(true), _needRestart(false), _currentArg1(0), _variablesDone(true) {
+            BenchmarkState() :_firstTime(true), _currentArg1(0), _variablesDone(true), _started(false), _needRestart(false) {
             }
 
             bool addArgument(int from, int to) {
@@ -63,64 +120,88 @@ namespace benchmark {
                     GrowthType growthType = findGrowthType(from, to);
                     bool growing = to > from;
                     _variableArgs.emplace_back(VariableArgument{{from, to}, growthType, growing, from});
-                    _variablesDone = false;
-                    _needRestart = true;
+                    dimensionAdded();
                     return true;
                 }
                 _needRestart = false;
                 return false;
             }
 
-            void pickNextArgument() {
-                if (_variableArgs.empty()) {
-                    return;
+            // returns if the dimension has been activated and the benchmark should restart
+            bool addList(ListKind kind, const std::vector<int> &values) {
+                auto i = std::find_if(_lists.begin(), _lists.end(),
+                    [=](const ListDimension &list) { return list.kind == kind; });
+
+                bool ignored = std::find(_ignoredLists.begin(), _ignoredLists.end(), kind) != _ignoredLists.end();
+
+                if (i == _lists.end() && !values.empty() && !ignored) {
+                    _lists.push_back(ListDimension{kind, values, 0});
+                    dimensionAdded();
+                    return true;
                 }
+                _needRestart = false;
+                return false;
+            }
 
-                VariableArgument &varg = _variableArgs[0];
+            // a dimension the benchmark may add but the harness doesn't sweep, before the first sample
+            void ignoreList(ListKind kind) {
+                _ignoredLists.push_back(kind);
+            }
 
-                _currentArg1 = varg.value;
+            // a dimension the harness adds rather than the benchmark, before the first sample
+            void sweepList(ListKind kind, const std::vector<int> &values) {
+                addList(kind, values);
+                _needRestart = false;
+            }
 
-                switch (varg.growth) {
-                    case Linear: {
-                        varg.value += varg.growing ? 1 : -1;
-                        break;
-                    }
-                    case Exponential2: {
-                        if (varg.growing) {
-                            varg.value *= 2;
-                        } else {
-                            varg.value /= 2;
-                        }
-                        break;
+            void pickNextArgument() {
+                if (!variableArgsMode()) {
+                    return;
+                }
+
+                if (!_started) {
+                    _started = true;
+                    for (auto &varg : _variableArgs)
+                        varg.value = varg.range.first;
+                    for (auto &list : _lists)
+                        list.index = 0;
+                } else {
+                    // odometer: the argument first, then the lists from the last added one
+                    bool carry = true;
+                    if (!_variableArgs.empty()) {
+                        VariableArgument &varg = _variableArgs[0];
+                        int next = nextValue(varg);
+                        carry = !inRange(varg, next) || next == varg.value;
+                        varg.value = carry ? varg.range.first : next;
                     }
-                    case Exponential10: {
-                        if (varg.growing) {
-                            varg.value *= 10;
-                        } else {
-                            varg.value /= 10;
-                        }
-                        break;
+                    for (size_t l = _lists.size(); carry && l-- > 0;) {
+                        ListDimension &list = _lists[l];
+                        carry = ++list.index == list.values.size();
+                        if (carry)
+                            list.index = 0;
                     }
                 }
 
-                if ((varg.growing && varg.value > varg.range.second) ||
-                    (!varg.growing && varg.value < varg.range.second)) {
-                    _variablesDone = true;
-                }
+                _currentArg1 = _variableArgs.empty() ? 0 : _variableArgs[0].value;
+                _variablesDone = lastCombination();
             }
 
             bool running() {
-                if (_variableArgs.empty()) {
+                if (!variableArgsMode()) {
                     // without variable arguments we just run only once
                     bool result = _firstTime;
                     _firstTime = false;
                     return result;
                 }
 
-                return !_variablesDone;
+                return !_variablesDone || !_started;
             }
 
             bool variableArgsMode() const {
+                return !_variableArgs.empty() || !_lists.empty();
+            }
+
+            bool hasArgument() const {
                 return !_variableArgs.empty();
             }
 
@@ -128,6 +209,15 @@ namespace benchmark {
                 return _currentArg1;
             }
 
+            // current value of the list dimension, or the given default if the benchmark doesn't sweep over it
+            int listValue(ListKind kind, int defaultValue) const {
+                for (auto &list : _lists) {
+                    if (list.kind == kind)
+                        return list.values[list.index];
+                }
+                return defaultValue;
+            }
+
             bool needRestart() const {
                 return _needRestart;
             }
@@ -143,6 +233,16 @@ namespace benchmark {
             bool _ended{false};
             BenchmarkState &_bstate;
 
+            uint64_t _operations{0};
+            uint64_t _bytes{0};
+            std::vector<std::pair<std::string, double>> _counters;
+
+            MemoryResource *_memory{nullptr};
+            DatasetCache *_datasets{nullptr};
+#ifdef BENCHMARK_HAS_PMR
+            PmrAdapter _pmr{nullptr};
+#endif
+
         public:
             RunState(BenchmarkState &bstate, duration_t noopTime):
                 _bstate(bstate),
@@ -155,6 +255,10 @@ namespace benchmark {
                 return _bstate.addArgument(from, to);
             }
 
+            bool addList(ListKind kind, const std::vector<int> &values) {
+                return _bstate.addList(kind, values);
+            }
+
             BENCHMARK_ALWAYS_INLINE void start() {
                 _ended = false;
                 _start = clock_t::now();
@@ -184,6 +288,82 @@ namespace benchmark {
             BENCHMARK_ALWAYS_INLINE int arg1() const {
                 return _bstate.getArg();
             }
+
+            // the sample consists of this many operations, results are reported per operation
+            void setOperations(uint64_t operations) {
+                _operations = operations;
+            }
+
+            uint64_t operations() const {
+                return _operations;
+            }
+
+            // bytes the sample read or wrote, reported as a bandwidth
+            void setBytes(uint64_t bytes) {
+                _bytes = bytes;
+            }
+
+            uint64_t bytes() const {
+                return _bytes;
+            }
+
+            // arbitrary value of the sample, e.g. allocations made, shows up as a counter track of the trace
+            void setCounter(const std::string &name, double value) {
+                for (auto &counter : _counters) {
+                    if (counter.first == name) {
+                        counter.second = value;
+                        return;
+                    }
+                }
+                _counters.emplace_back(name, value);
+            }
+
+            const std::vector<std::pair<std::string, double>> &counters() const {
+                return _counters;
+            }
+
+            void setMemory(MemoryResource *memory) {
+                _memory = memory;
+            }
+
+            // memory for the data of the sample, placed and backed the way the benchmark is configured
+            MemoryResource &memory() {
+                static SystemResource system;
+                return _memory ? *_memory : system;
+            }
+
+            template<typename T>
+            Allocator<T> allocator() {
+                return Allocator<T>(&memory());
+            }
+
+            void setDatasets(DatasetCache *datasets) {
+                _datasets = datasets;
+            }
+
+            // data of the generator, made on first use and kept for the rest of the run: state.dataset(benchmark::data::Zipf(ARG1, 1.1))
+            template<typename Generator>
+            const typename Generator::result_type &dataset(const Generator &generator) {
+                static DatasetCache standalone;
+                return (_datasets ? *_datasets : standalone).get(generator);
+            }
+
+#ifdef BENCHMARK_HAS_PMR
+            // state.memory() for std::pmr containers: std::pmr::vector<int> v(state.pmr());
+            std::pmr::memory_resource *pmr() {
+                _pmr = PmrAdapter(&memory());
+                return &_pmr;
+            }
+#endif
+
+            time_point_t startTime() const {
+                return _start;
+            }
+
+            // measured time without the timer overhead subtracted
+            duration_t rawDuration() const {
+                return _duration;
+            }
         };
     }
 }
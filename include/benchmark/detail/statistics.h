@@ -1,8 +1,39 @@
 #pragma once
 #include <vector>
-#include "chrono_utils.h"
+#include "bootstrap.h"
+#include "config.h"
 
 class TimeStatistics {
+public:
+    enum OutlierMethod {
+        OutliersNone,
+        OutliersTukey, // fences at Q1/Q3 -+ 1.5 IQR (mild) and 3 IQR (severe)
+        OutliersMAD    // fences at median -+ 3 (mild) and 5 (severe) scaled MADs
+    };
+
+    struct OutlierCounts {
+        unsigned lowSevere;
+        unsigned lowMild;
+        unsigned highMild;
+        unsigned highSevere;
+
+        unsigned total() const {
+            return lowSevere + lowMild + highMild + highSevere;
+        }
+    };
+
+    // a peak of the sample distribution found by the kernel density estimation
+    struct Mode {
+        benchmark::duration_t location; // where the density peaks
+        benchmark::duration_t median;   // median of the samples attributed to the mode
+        benchmark::duration_t low;
+        benchmark::duration_t high;
+        size_t samples;
+        double share;
+    };
+
+    static const size_t MinSamplesForModes = 20;
+
 private:
     std::vector<benchmark::duration_t> _samples;
     benchmark::duration_t _totalSum;
@@ -12,63 +43,32 @@ private:
     benchmark::duration_t _maximum;
     benchmark::duration_t _stdDev;
 
+    OutlierMethod _outlierMethod;
+    OutlierCounts _outliers;
+    std::vector<Mode> _modes;
+
+    benchmark::detail::Bootstrap::Settings _bootstrap;
+    std::vector<int> _percentiles; // which percentiles get confidence intervals
+    benchmark::detail::ConfidenceInterval _meanInterval;
+    benchmark::detail::ConfidenceInterval _medianInterval;
+    std::vector<benchmark::detail::ConfidenceInterval> _percentileIntervals;
+
 private:
-    void calculateStats() {
-        _totalSum = benchmark::duration_t(0);
-        _average = benchmark::duration_t(0);
-        _maximum = _minimum = _samples[0];
-
-        // minimum and average
-        for (auto sample : _samples) {
-            _average += sample;
-            _totalSum += sample;
-            if (sample < _minimum)
-                _minimum = sample;
-            if (sample > _maximum)
-                _maximum = sample;
-        }
-        _average /= _samples.size();
-
-        // standard deviation
-        auto averageNs = std::chrono::duration_cast<std::chrono::nanoseconds>(_average).count();
-        unsigned long long sumOfSquares = 0;
-        for (auto sample : _samples) {
-            auto sampleNs = sample.count();
-            auto d = (sampleNs > averageNs) ? (sampleNs - averageNs) : (averageNs - sampleNs);
-            sumOfSquares += d * d;
-        }
-        sumOfSquares /= _samples.size();
-        long long stdDevNs = llround(sqrt((double)sumOfSquares));
-        _stdDev = std::chrono::nanoseconds(stdDevNs);
-
-        // median
-        std::sort(_samples.begin(), _samples.end());
-        if (_samples.size() % 2 == 1) {
-            _median = _samples[_samples.size() / 2];
-        } else {
-            auto j = _samples.size() / 2;
-            _median = _samples[j-1] / 2 + _samples[j] / 2;
-        }
-    }
+    void calculateStats();
 
-    bool removeOutliers() {
-        if (_samples.size() < 3)
-            return false;
-
-        bool removed = false;
-        auto outlierThreshold = _average + _stdDev * 2.0f;
-        for (size_t i = 0; i < _samples.size();) {
-            auto sample = _samples[i];
-            if (sample > outlierThreshold) {
-                _samples[i] = _samples.back();
-                _samples.pop_back();
-                removed = true;
-            } else {
-                i++;
-            }
-        }
-        return removed;
-    }
+    // linear interpolation between the closest ranks, samples must be sorted
+    static double quantile(const std::vector<benchmark::duration_t> &sorted, double q);
+
+    // Classifies samples against fences built from robust estimators (they are not skewed by the outliers themselves)
+    // and counts every class. Only the severe ones are left out, of the average and the standard deviation; the
+    // median, the percentiles, the minimum and the maximum are of all samples. Samples must be sorted.
+    bool classifyOutliers();
+
+    void calculateIntervals();
+
+    // Finds peaks of a Gaussian kernel density estimate (binned, Silverman's bandwidth). Peaks which aren't separated
+    // by a deep enough valley are merged, as well as peaks holding too few samples. Samples must be sorted.
+    void detectModes();
 
 public:
     TimeStatistics():
@@ -77,7 +77,13 @@ public:
         , _median(0)
         , _minimum(0)
         , _maximum(0)
-        , _stdDev(0) {
+        , _stdDev(0)
+        , _outlierMethod(OutliersTukey)
+        , _outliers{0, 0, 0, 0}
+        , _bootstrap{benchmark::detail::BootstrapBCa, 1000, 0.95, 42}
+        , _percentiles{90}
+        , _meanInterval{0.0, 0.0, false}
+        , _medianInterval{0.0, 0.0, false} {
         _samples.reserve(256);
     }
 
@@ -85,21 +91,25 @@ public:
         _samples.push_back(sample);
     }
 
-    void clear() {
-        _samples.clear();
+    // drops the samples added first, before calculate()
+    void discardFirst(size_t count);
+
+    void clear();
+
+    void setOutlierMethod(OutlierMethod method) {
+        _outlierMethod = method;
     }
 
-    bool calculate() {
-        if (_samples.empty())
-            return false;
+    void setBootstrap(const benchmark::detail::Bootstrap::Settings &settings) {
+        _bootstrap = settings;
+    }
 
-        calculateStats();
-        if (removeOutliers()) {
-            calculateStats();
-        }
-        return true;
+    void setPercentiles(const std::vector<int> &percentiles) {
+        _percentiles = percentiles;
     }
-    
+
+    bool calculate();
+
     size_t size() const {
         return _samples.size();
     }
@@ -128,12 +138,7 @@ public:
         return _maximum;
     }
 
-    benchmark::duration_t percentile(int nth) const {
-        size_t idx = (size_t)(_samples.size() * ((float)nth / 100.0f)) - 1;
-        if (idx < 0)
-            idx = 0;
-        return _samples[idx];
-    }
+    benchmark::duration_t percentile(int nth) const;
 
     benchmark::duration_t standardDeviation() const {
         return _stdDev;
@@ -146,4 +151,41 @@ public:
     double standardDeviationLevel() const {
         return (double)_stdDev.count() / (double)_average.count();
     }
+
+    OutlierMethod outlierMethod() const {
+        return _outlierMethod;
+    }
+
+    // outliers found by the last calculate(), the severe ones aren't in the average and the standard deviation
+    const OutlierCounts &outliers() const {
+        return _outliers;
+    }
+
+    // empty unless the distribution has at least two distinct peaks
+    const std::vector<Mode> &modes() const {
+        return _modes;
+    }
+
+    bool multimodal() const {
+        return _modes.size() > 1;
+    }
+
+    const std::vector<int> &percentiles() const {
+        return _percentiles;
+    }
+
+    // intervals are not valid when bootstrap is disabled or there are too few samples
+    const benchmark::detail::ConfidenceInterval &averageInterval() const {
+        return _meanInterval;
+    }
+
+    const benchmark::detail::ConfidenceInterval &medianInterval() const {
+        return _medianInterval;
+    }
+
+    benchmark::detail::ConfidenceInterval percentileInterval(int nth) const;
+
+    double confidenceLevel() const {
+        return _bootstrap.confidence;
+    }
 };
@@ -0,0 +1,60 @@
+#pragma once
+#include <vector>
+#include "config.h"
+
+namespace benchmark {
+namespace detail {
+
+/*
+Finds where the transient at the beginning of a sample sequence ends (cold caches, page faults, predictors and
+lazy initialization still warming up), using MSER-5: the sequence is split into batches of 5 samples, and the
+truncation point is the one minimizing the squared standard error of the mean of what is left,
+MSER(d) = sum over j > d of (b[j] - mean(b[d+1..k]))^2 / (k - d)^2. While it falls into the second half of
+the sequence, the series is still drifting and steady state is not reached.
+*/
+class SteadyStateDetector {
+public:
+    static const size_t BatchSize = 5;
+    static const size_t MinBatches = 4;
+
+private:
+    std::vector<duration_t> _samples;
+    std::vector<double> _batchMeans;
+    bool _steady{false};
+    size_t _steadySince{0}; // sample index where steady state has been declared first
+
+    // truncation point in batches, searched among the first half of them
+    size_t truncationPoint() const;
+
+public:
+    void clear() {
+        _samples.clear();
+        _batchMeans.clear();
+        _steady = false;
+        _steadySince = 0;
+    }
+
+    // returns true once steady state is reached
+    bool add(duration_t sample);
+
+    bool steady() const {
+        return _steady;
+    }
+
+    size_t size() const {
+        return _samples.size();
+    }
+
+    // sample index at which the runner learned the steady state has been reached
+    size_t steadySince() const {
+        return _steadySince;
+    }
+
+    // samples to discard, computed on everything seen so far; 0 unless steady state has been reached
+    size_t warmupSamples() const;
+
+    // time measured in the discarded samples
+    duration_t warmupTime() const;
+};
+
+}} //namespaces
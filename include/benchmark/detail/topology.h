@@ -0,0 +1,58 @@
+#pragma once
+#include <string>
+#include <vector>
+
+namespace benchmark {
+namespace detail {
+
+// one hardware thread, as the kernel sees it in /sys/devices/system/cpu
+struct LogicalCpu {
+    int cpu;
+    int package;
+    int core; // unique over packages, SMT siblings share it
+    int l3;   // first cpu of the last level cache domain
+    int node; // NUMA node
+};
+
+enum PartitionGranularity {
+    PartitionCore, // a physical core with its SMT siblings
+    PartitionL3,   // all cores sharing a last level cache
+    PartitionNode  // a NUMA node
+};
+
+// disjoint set of whole physical cores a benchmark runs on without neighbours
+struct CorePartition {
+    unsigned index;
+    std::vector<int> cpus; // the benchmark thread is pinned to the first one, the rest stays idle
+    int l3;
+    int node;
+
+    // e.g. "P1 [cpus 4-5,12-13, L3 4, node 0]"
+    std::string label() const;
+};
+
+// "0-3,8,10-11" -> {0, 1, 2, 3, 8, 10, 11}
+std::vector<int> parseCpuList(const std::string &text);
+
+// {0, 1, 2, 3, 8} -> "0-3,8"
+std::string formatCpuList(std::vector<int> cpus);
+
+// first line of a sysfs file, quietly empty if it's not there
+std::string readSysfsLine(const std::string &path);
+
+// online cpus the process is allowed to run on
+std::vector<LogicalCpu> readTopology();
+
+// physical cores are never split, so no two benchmarks share the execution units of one core
+std::vector<CorePartition> partitionCores(const std::vector<LogicalCpu> &cpus, PartitionGranularity granularity);
+
+// pins the calling thread to the cpu
+bool pinCurrentThread(int cpu);
+
+// pins the calling thread to any of the cpus
+bool pinCurrentThread(const std::vector<int> &cpus);
+
+// cpus the calling thread may run on, empty if it isn't known
+std::vector<int> currentAffinity();
+
+}} //namespaces
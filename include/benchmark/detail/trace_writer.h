@@ -0,0 +1,65 @@
+#pragma once
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "config.h"
+
+namespace benchmark {
+namespace detail {
+
+/*
+Collects samples as slices of the Chrome trace-event format, which chrome://tracing and ui.perfetto.dev open:
+a slice per sample on the track of the thread it ran on, counter tracks (CPU frequency, CPU load, allocations from
+state.memory(), counters set by the benchmark) and a marker where every argument value starts. The file is written at once by save().
+*/
+class TraceWriter {
+    struct Event {
+        char phase; // 'X' slice, 'C' counter, 'i' instant marker
+        std::string name;
+        double ts; // microseconds since the trace start
+        double dur;
+        long tid;
+        std::string argName;
+        double argValue;
+    };
+
+    std::string _path;
+    time_point_t _origin;
+    std::mutex _mutex;
+    std::vector<Event> _events;
+    std::vector<std::pair<long, std::string>> _threadNames;
+
+    static void writeEscaped(FILE *fh, const std::string &text);
+
+    void add(Event &&event) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _events.push_back(std::move(event));
+    }
+
+public:
+    explicit TraceWriter(const std::string &path)
+        : _path(path)
+        , _origin(clock_t::now()) {
+        _events.reserve(4096);
+    }
+
+    static long currentThreadId();
+
+    double timestamp(time_point_t time) const {
+        return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(time - _origin).count() / 1000.0;
+    }
+
+    void nameThread(const std::string &name);
+
+    void addSample(const std::string &name, time_point_t start, duration_t duration, unsigned index);
+
+    void addCounter(const std::string &name, time_point_t time, const std::string &valueName, double value);
+
+    void addMarker(const std::string &name, time_point_t time);
+
+    bool save();
+};
+
+}} //namespaces
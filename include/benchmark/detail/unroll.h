@@ -0,0 +1,193 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <type_traits>
+#include "config.h"
+#include "dont_optimize.h"
+#include "state.h"
+
+namespace benchmark {
+namespace detail {
+
+// Calls f(Offset), f(Offset + 1), ... f(Offset + N - 1) with no loop left in the generated code.
+// Splits in halves, so the template depth is log2(N).
+template<unsigned N, unsigned Offset = 0>
+struct Unroll {
+    template<typename F>
+    static inline BENCHMARK_ALWAYS_INLINE void run(F &f) {
+        Unroll<N / 2, Offset>::run(f);
+        Unroll<N - N / 2, Offset + N / 2>::run(f);
+    }
+};
+
+template<unsigned Offset>
+struct Unroll<1, Offset> {
+    template<typename F>
+    static inline BENCHMARK_ALWAYS_INLINE void run(F &f) {
+        f(Offset);
+    }
+};
+
+template<unsigned Offset>
+struct Unroll<0, Offset> {
+    template<typename F>
+    static inline BENCHMARK_ALWAYS_INLINE void run(F &) {
+    }
+};
+
+// Makes the value opaque to the optimizer while keeping it in a register: unlike DoNotOptimize it never goes through
+// memory, which would add a store-to-load forwarding to every step of a dependency chain. Only integers, pointers,
+// enums, float and double have a register constraint; anything else, a struct or a SIMD type, goes through
+// DoNotOptimize.
+enum OpaqueRegister {
+    OpaqueGeneral, // general purpose register
+    OpaqueFloat,   // xmm on x86, v on ARM64
+    OpaqueMemory   // no register constraint fits
+};
+
+template<typename T>
+struct OpaqueRegisterOf
+    : std::integral_constant<int, std::is_integral<T>::value || std::is_pointer<T>::value || std::is_enum<T>::value
+                                      ? OpaqueGeneral
+                                      : (std::is_same<T, float>::value || std::is_same<T, double>::value
+                                             ? OpaqueFloat
+                                             : OpaqueMemory)> {};
+
+#ifndef BENCHMARK_HAS_NO_INLINE_ASSEMBLY
+template<typename T>
+inline BENCHMARK_ALWAYS_INLINE void opaque(T &value, std::integral_constant<int, OpaqueGeneral>) {
+    asm volatile("" : "+r"(value));
+}
+
+template<typename T>
+inline BENCHMARK_ALWAYS_INLINE void opaque(T &value, std::integral_constant<int, OpaqueFloat>) {
+#if defined(__x86_64__) || defined(__i386__)
+    asm volatile("" : "+x"(value));
+#elif defined(__aarch64__)
+    asm volatile("" : "+w"(value));
+#else
+    benchmark::DoNotOptimize(value);
+#endif
+}
+
+template<typename T>
+inline BENCHMARK_ALWAYS_INLINE void opaque(T &value, std::integral_constant<int, OpaqueMemory>) {
+    benchmark::DoNotOptimize(value);
+}
+
+template<typename T>
+inline BENCHMARK_ALWAYS_INLINE void opaque(T &value) {
+    opaque(value, std::integral_constant<int, OpaqueRegisterOf<T>::value>());
+}
+#else
+template<typename T>
+inline BENCHMARK_ALWAYS_INLINE void opaque(T &value) {
+    benchmark::DoNotOptimize(value);
+}
+#endif
+
+template<typename T, typename Op>
+struct LatencyStep {
+    T &value;
+    Op &op;
+
+    inline BENCHMARK_ALWAYS_INLINE void operator()(unsigned) {
+        value = op(value);
+        opaque(value);
+    }
+};
+
+template<typename T, typename Op, unsigned Chains>
+struct ThroughputStep {
+    T (&values)[Chains];
+    Op &op;
+
+    inline BENCHMARK_ALWAYS_INLINE void operator()(unsigned index) {
+        T &value = values[index % Chains];
+        value = op(value);
+        opaque(value);
+    }
+};
+
+// Measures the core clock as the rate of a chain of dependent additions, which take one cycle on any core worth
+// benchmarking on. Unlike TSC ticks these are real core cycles, whatever the frequency scaling is doing.
+inline double coreCyclesPerNanosecond() {
+    static double result = 0.0;
+    if (result > 0.0)
+        return result;
+
+    static const unsigned Unrolled = 200;
+    static const unsigned Repeats = 20000;
+
+    double best = 0.0;
+    for (int attempt = 0; attempt < 5; attempt++) {
+        uint64_t x = attempt, y = 1;
+        opaque(y);
+        struct AddStep {
+            uint64_t &x;
+            uint64_t y; // register to register, some cores fold chains of additions of an immediate at renaming
+            inline BENCHMARK_ALWAYS_INLINE void operator()(unsigned) {
+                x += y;
+                opaque(x);
+            }
+        } step{x, y};
+
+        auto start = clock_t::now();
+        for (unsigned r = 0; r < Repeats; r++) {
+            Unroll<Unrolled>::run(step);
+        }
+        auto end = clock_t::now();
+        benchmark::DoNotOptimize(x);
+
+        double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+        if (ns > 0.0)
+            best = std::max(best, (double)Unrolled * Repeats / ns);
+    }
+    result = best;
+    return result;
+}
+
+} // namespace detail
+
+// Latency: N copies of op unrolled at compile time, each one taking the result of the previous one.
+// The result is a time (and cycles) per op, not per sample.
+template<unsigned N, typename T, typename Op>
+inline BENCHMARK_ALWAYS_INLINE void measureLatency(detail::RunState &state, T init, Op op, unsigned repeats = 100) {
+    T value = init;
+    detail::opaque(value);
+    detail::LatencyStep<T, Op> step{value, op};
+
+    state.start();
+    for (unsigned r = 0; r < repeats; r++) {
+        detail::Unroll<N>::run(step);
+    }
+    state.stop();
+
+    benchmark::DoNotOptimize(value);
+    state.setOperations((uint64_t)N * repeats);
+}
+
+// Reciprocal throughput: N unrolled copies of op spread over Chains independent dependency chains, enough of them
+// to keep all execution ports busy as long as the latency is below Chains times the throughput.
+template<unsigned N, unsigned Chains = 8, typename T, typename Op>
+inline BENCHMARK_ALWAYS_INLINE void measureThroughput(detail::RunState &state, T init, Op op, unsigned repeats = 100) {
+    T values[Chains];
+    for (unsigned c = 0; c < Chains; c++) {
+        values[c] = init;
+        detail::opaque(values[c]);
+    }
+    detail::ThroughputStep<T, Op, Chains> step{values, op};
+
+    state.start();
+    for (unsigned r = 0; r < repeats; r++) {
+        detail::Unroll<N>::run(step);
+    }
+    state.stop();
+
+    for (unsigned c = 0; c < Chains; c++) {
+        benchmark::DoNotOptimize(values[c]);
+    }
+    state.setOperations((uint64_t)N * repeats);
+}
+
+} // namespace benchmark
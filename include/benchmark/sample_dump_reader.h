@@ -0,0 +1,183 @@
+#pragma once
+
+/*
+Reads raw sample dumps written with --dump, without the rest of the library:
+
+benchmark::SampleDumpReader dump("samples.bin");
+const int64_t *durations = dump.column<int64_t>("duration_ns");
+for (uint64_t row = 0; row < dump.rows(); row++)
+    std::cout << dump.blockName(dump.value(benchmark::detail::DumpBlock, row)) << " " << durations[row] << "\n";
+*/
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "detail/sample_dump_format.h"
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace benchmark {
+
+class SampleDumpReader {
+    const char *_mapped{nullptr};
+    size_t _size{0};
+    const detail::SampleDumpHeader *_header{nullptr};
+    std::vector<std::string> _blocks;
+    std::vector<std::string> _counters;
+
+    bool validate() const {
+        if (_size < sizeof(detail::SampleDumpHeader) || std::memcmp(_header->magic, "BMSAMPL", 8) != 0 ||
+            _header->columnCount > detail::SampleDumpHeader::MaxColumns)
+            return false;
+        for (uint32_t c = 0; c < _header->columnCount; c++) {
+            const detail::SampleDumpColumn &col = _header->columns[c];
+            if (col.offset + _header->rows * detail::columnTypeSize(col.type) > _size)
+                return false;
+        }
+        return _header->namesOffset + _header->namesSize <= _size;
+    }
+
+    void readNames() {
+        const char *p = _mapped + _header->namesOffset, *end = p + _header->namesSize;
+        std::vector<std::string> names;
+        while (p < end) {
+            size_t len = strnlen(p, (size_t)(end - p));
+            names.emplace_back(p, len);
+            p += len + 1;
+        }
+        for (size_t i = 0; i < names.size(); i++) {
+            (i < _header->blockCount ? _blocks : _counters).push_back(names[i]);
+        }
+    }
+
+public:
+    explicit SampleDumpReader(const std::string &path) {
+#ifndef WIN32
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            std::cerr << "Couldn't open '" << path << "'\n";
+            return;
+        }
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+            void *mapped = ::mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped != MAP_FAILED) {
+                _mapped = (const char *)mapped;
+                _size = (size_t)st.st_size;
+            }
+        }
+        ::close(fd);
+
+        _header = (const detail::SampleDumpHeader *)_mapped;
+        if (!_mapped || !validate()) {
+            std::cerr << "'" << path << "' isn't a sample dump\n";
+            _header = nullptr;
+            return;
+        }
+        if (_header->closed)
+            readNames();
+#else
+        std::cerr << "Sample dumps aren't supported on this platform\n";
+#endif
+    }
+
+    ~SampleDumpReader() {
+#ifndef WIN32
+        if (_mapped)
+            ::munmap((void *)_mapped, _size);
+#endif
+    }
+
+    SampleDumpReader(const SampleDumpReader &) = delete;
+    SampleDumpReader &operator=(const SampleDumpReader &) = delete;
+
+    bool valid() const {
+        return _header != nullptr;
+    }
+
+    // false if the run writing it didn't finish, the samples are there but the names aren't
+    bool complete() const {
+        return _header && _header->closed;
+    }
+
+    uint64_t rows() const {
+        return _header ? _header->rows : 0;
+    }
+
+    uint64_t dropped() const {
+        return _header ? _header->dropped : 0;
+    }
+
+    // nanoseconds since the epoch
+    int64_t startTime() const {
+        return _header ? _header->startTime : 0;
+    }
+
+    unsigned columnCount() const {
+        return _header ? _header->columnCount : 0;
+    }
+
+    // the counters carry the names given to them by the benchmark, unused ones are empty
+    std::string columnName(unsigned index) const {
+        if (index >= detail::DumpCounter0 && index - detail::DumpCounter0 < _counters.size())
+            return _counters[index - detail::DumpCounter0];
+        return _header->columns[index].name;
+    }
+
+    uint32_t columnType(unsigned index) const {
+        return _header->columns[index].type;
+    }
+
+    int findColumn(const std::string &name) const {
+        for (unsigned c = 0; c < columnCount(); c++) {
+            if (name == _header->columns[c].name || name == columnName(c))
+                return (int)c;
+        }
+        return -1;
+    }
+
+    // the values of a column, nullptr if there's no such column
+    template<typename T>
+    const T *column(unsigned index) const {
+        if (!_header || index >= _header->columnCount || sizeof(T) != detail::columnTypeSize(columnType(index)))
+            return nullptr;
+        return (const T *)(_mapped + _header->columns[index].offset);
+    }
+
+    template<typename T>
+    const T *column(const std::string &name) const {
+        int index = findColumn(name);
+        return index < 0 ? nullptr : column<T>((unsigned)index);
+    }
+
+    // any value as a double
+    double value(unsigned index, uint64_t row) const {
+        const char *p = _mapped + _header->columns[index].offset;
+        switch (columnType(index)) {
+            case detail::ColumnInt64: return (double)((const int64_t *)p)[row];
+            case detail::ColumnInt32: return (double)((const int32_t *)p)[row];
+            case detail::ColumnUInt32: return (double)((const uint32_t *)p)[row];
+            case detail::ColumnDouble: return ((const double *)p)[row];
+        }
+        return NAN;
+    }
+
+    size_t blockCount() const {
+        return _blocks.size();
+    }
+
+    std::string blockName(double index) const {
+        size_t i = (size_t)index;
+        return i < _blocks.size() ? _blocks[i] : std::to_string(i);
+    }
+};
+
+} // namespace benchmark
@@ -0,0 +1,366 @@
+#pragma once
+
+/*
+Scoped timing zones for production code:
+
+void parse(const Request &r) {
+    BENCHMARK_ZONE("parse");
+    ...
+}
+
+// any thread, whenever a report is wanted
+benchmark::zones::Collector collector;
+collector.collect();
+collector.print(std::cout);
+
+Every thread writes into its own lock-free ring buffer, the collector drains them into per-zone statistics: the
+count, total, extremes and histogram of every call, the percentiles of a uniform reservoir of them, so that a
+collector which runs for the lifetime of the process stays bounded. One collector drains at a time.
+Without BENCHMARK_ENABLE_ZONES defined, BENCHMARK_ZONE expands to nothing.
+*/
+
+#ifdef BENCHMARK_ENABLE_ZONES
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "detail/chrono_utils.h"
+#include "detail/config.h"
+#include "detail/statistics.h"
+
+#ifndef BENCHMARK_ZONE_BUFFER_SIZE
+#define BENCHMARK_ZONE_BUFFER_SIZE 4096 // events per thread, power of 2
+#endif
+
+#ifndef BENCHMARK_ZONE_RESERVOIR_SIZE
+#define BENCHMARK_ZONE_RESERVOIR_SIZE 4096 // durations per zone the percentiles are of
+#endif
+
+namespace benchmark {
+namespace zones {
+
+struct ZoneEvent {
+    uint32_t zone;
+    int64_t start; // clock ticks
+    int64_t end;
+};
+
+// Single producer (the owning thread), single consumer (the collector). When full, new events are dropped and counted.
+class ThreadBuffer {
+    static const uint64_t Capacity = BENCHMARK_ZONE_BUFFER_SIZE;
+    static_assert((Capacity & (Capacity - 1)) == 0, "BENCHMARK_ZONE_BUFFER_SIZE must be a power of 2");
+
+    ZoneEvent _events[Capacity];
+    std::atomic<uint64_t> _head{0}; // next slot to write
+    char _padding[64];              // the reader and the writer don't share a cache line
+    std::atomic<uint64_t> _tail{0}; // next slot to read
+    std::atomic<uint64_t> _dropped{0};
+
+public:
+    BENCHMARK_ALWAYS_INLINE void push(const ZoneEvent &event) {
+        uint64_t head = _head.load(std::memory_order_relaxed);
+        if (head - _tail.load(std::memory_order_acquire) >= Capacity) {
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        _events[head & (Capacity - 1)] = event;
+        _head.store(head + 1, std::memory_order_release);
+    }
+
+    template<typename F>
+    void drain(F &&consume) {
+        uint64_t tail = _tail.load(std::memory_order_relaxed);
+        uint64_t head = _head.load(std::memory_order_acquire);
+        for (; tail != head; ++tail) {
+            consume(_events[tail & (Capacity - 1)]);
+        }
+        _tail.store(tail, std::memory_order_release);
+    }
+
+    uint64_t takeDropped() {
+        return _dropped.exchange(0, std::memory_order_relaxed);
+    }
+};
+
+// Zone names and thread buffers. Locked only when a zone is met or a thread records for the first time, and on collect.
+class Registry {
+    std::mutex _mutex;
+    std::mutex _collectMutex; // the buffers have a single consumer
+    std::vector<std::string> _names;
+    std::vector<std::shared_ptr<ThreadBuffer>> _buffers;
+
+public:
+    static Registry &instance() {
+        static Registry registry;
+        return registry;
+    }
+
+    uint32_t zoneId(const char *name) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto i = std::find(_names.begin(), _names.end(), name);
+        if (i != _names.end())
+            return (uint32_t)(i - _names.begin());
+        _names.push_back(name);
+        return (uint32_t)(_names.size() - 1);
+    }
+
+    std::shared_ptr<ThreadBuffer> addThread() {
+        std::shared_ptr<ThreadBuffer> buffer = std::make_shared<ThreadBuffer>();
+        std::lock_guard<std::mutex> lock(_mutex);
+        _buffers.push_back(buffer);
+        return buffer;
+    }
+
+    std::vector<std::string> names() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _names;
+    }
+
+    // held by a collector while it drains
+    std::mutex &collectMutex() {
+        return _collectMutex;
+    }
+
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _buffers;
+    }
+
+    // buffers of finished threads, forgotten by the registry and left to the caller to drain a last time: their
+    // threads may have pushed more after the collector's drain and before exiting
+    std::vector<std::shared_ptr<ThreadBuffer>> takeFinished() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto finished = std::stable_partition(_buffers.begin(), _buffers.end(),
+                                              [](const std::shared_ptr<ThreadBuffer> &b) { return b.use_count() > 1; });
+        std::vector<std::shared_ptr<ThreadBuffer>> result(finished, _buffers.end());
+        _buffers.erase(finished, _buffers.end());
+        return result;
+    }
+};
+
+inline ThreadBuffer &threadBuffer() {
+    static thread_local std::shared_ptr<ThreadBuffer> buffer = Registry::instance().addThread();
+    return *buffer;
+}
+
+inline BENCHMARK_ALWAYS_INLINE int64_t now() {
+    return (int64_t)benchmark::clock_t::now().time_since_epoch().count();
+}
+
+class ScopedZone {
+    uint32_t _zone;
+    int64_t _start;
+
+public:
+    BENCHMARK_ALWAYS_INLINE explicit ScopedZone(uint32_t zone)
+        : _zone(zone)
+        , _start(now()) {
+    }
+
+    BENCHMARK_ALWAYS_INLINE ~ScopedZone() {
+        threadBuffer().push(ZoneEvent{_zone, _start, now()});
+    }
+
+    ScopedZone(const ScopedZone &) = delete;
+    ScopedZone &operator=(const ScopedZone &) = delete;
+};
+
+struct ZoneReport {
+    std::string name;
+    TimeStatistics stats; // of the reservoir
+    std::vector<benchmark::duration_t> reservoir; // uniform sample of at most BENCHMARK_ZONE_RESERVOIR_SIZE calls
+    std::vector<uint64_t> histogram; // [i] counts durations in [2^i, 2^(i+1)) ns
+    uint64_t count;
+    benchmark::duration_t total;
+    benchmark::duration_t minimum;
+    benchmark::duration_t maximum;
+    bool changed; // since the statistics were calculated
+
+    benchmark::duration_t average() const {
+        return count ? benchmark::duration_t(total.count() / (int64_t)count) : benchmark::duration_t(0);
+    }
+};
+
+// Accumulates everything drained so far, until reset()
+class Collector {
+    static const size_t ReservoirSize = BENCHMARK_ZONE_RESERVOIR_SIZE;
+
+    std::vector<ZoneReport> _zones;
+    uint64_t _dropped{0};
+    uint64_t _random{0x9e3779b97f4a7c15ull};
+
+    // xorshift64, the reservoir only needs the replaced slots spread evenly
+    uint64_t nextRandom() {
+        _random ^= _random << 13;
+        _random ^= _random >> 7;
+        _random ^= _random << 17;
+        return _random;
+    }
+
+    static void clearCalls(ZoneReport &report) {
+        report.stats.clear();
+        report.reservoir.clear();
+        report.histogram.clear();
+        report.count = 0;
+        report.total = benchmark::duration_t(0);
+        report.minimum = benchmark::duration_t::max();
+        report.maximum = benchmark::duration_t(0);
+        report.changed = false;
+    }
+
+    // algorithm R: the n-th call replaces a random slot with probability size/n
+    void add(ZoneReport &report, benchmark::duration_t duration) {
+        report.count++;
+        report.total += duration;
+        report.minimum = std::min(report.minimum, duration);
+        report.maximum = std::max(report.maximum, duration);
+        report.changed = true;
+
+        if (report.reservoir.size() < ReservoirSize) {
+            report.reservoir.push_back(duration);
+        } else {
+            uint64_t slot = nextRandom() % report.count;
+            if (slot < ReservoirSize)
+                report.reservoir[(size_t)slot] = duration;
+        }
+
+        size_t bucket = bucketOf(duration);
+        if (report.histogram.size() <= bucket)
+            report.histogram.resize(bucket + 1);
+        report.histogram[bucket]++;
+    }
+
+    static size_t bucketOf(benchmark::duration_t duration) {
+        auto ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+        size_t bucket = 0;
+        while (ns > 1) {
+            ns >>= 1;
+            bucket++;
+        }
+        return bucket;
+    }
+
+    void addZones() {
+        std::vector<std::string> names = Registry::instance().names();
+        while (_zones.size() < names.size()) {
+            ZoneReport report;
+            report.name = names[_zones.size()];
+            clearCalls(report);
+            // production distributions: keep the tails, don't spend time on resampling
+            report.stats.setOutlierMethod(TimeStatistics::OutliersNone);
+            report.stats.setBootstrap({benchmark::detail::BootstrapNone, 0, 0.95, 0});
+            report.stats.setPercentiles({50, 90, 99});
+            _zones.push_back(std::move(report));
+        }
+    }
+
+public:
+    void collect() {
+        std::lock_guard<std::mutex> lock(Registry::instance().collectMutex());
+        addZones();
+
+        auto drain = [this](ThreadBuffer &buffer) {
+            buffer.drain([this](const ZoneEvent &event) {
+                // a zone met for the first time since the names were read
+                if (event.zone >= _zones.size())
+                    addZones();
+                if (event.zone >= _zones.size())
+                    return;
+                add(_zones[event.zone], benchmark::duration_t(event.end - event.start));
+            });
+            _dropped += buffer.takeDropped();
+        };
+        for (auto &buffer : Registry::instance().buffers()) {
+            drain(*buffer);
+        }
+        for (auto &buffer : Registry::instance().takeFinished()) {
+            drain(*buffer);
+        }
+
+        // only the zones with new calls, of at most ReservoirSize durations each
+        for (auto &report : _zones) {
+            if (!report.changed)
+                continue;
+            report.stats.clear();
+            for (auto duration : report.reservoir) {
+                report.stats.addSample(duration);
+            }
+            report.stats.calculate();
+            report.changed = false;
+        }
+    }
+
+    void reset() {
+        for (auto &report : _zones) {
+            clearCalls(report);
+        }
+        _dropped = 0;
+    }
+
+    const std::vector<ZoneReport> &zones() const {
+        return _zones;
+    }
+
+    // events lost because a thread buffer was full
+    uint64_t dropped() const {
+        return _dropped;
+    }
+
+    void print(std::ostream &os) const {
+        auto oldPrecision = os.precision();
+        for (auto &report : _zones) {
+            if (report.count == 0)
+                continue;
+
+            const TimeStatistics &stats = report.stats;
+            os << "[Zone '" << report.name << "'] " << benchmark::io::Iterations{(unsigned)report.count} << " calls"
+               << ", avg: " << report.average() << ", median: " << stats.medianTime()
+               << ", 90th: " << stats.percentile(90) << ", 99th: " << stats.percentile(99)
+               << ", max: " << report.maximum << "\n";
+
+            uint64_t maxCount = *std::max_element(report.histogram.begin(), report.histogram.end());
+            for (size_t bucket = 0; bucket < report.histogram.size(); bucket++) {
+                if (report.histogram[bucket] == 0)
+                    continue;
+                os << "    " << std::setw(10) << benchmark::duration_t(std::chrono::nanoseconds(1ull << bucket))
+                   << " | ";
+                size_t width = (size_t)(40 * report.histogram[bucket] / maxCount);
+                for (size_t i = 0; i < std::max(width, (size_t)1); i++)
+                    os << '#';
+                os << " " << report.histogram[bucket] << "\n";
+            }
+        }
+        if (_dropped > 0) {
+            os << benchmark::detail::ColorLightRed << "Warning: " << _dropped
+               << " zone events dropped, thread buffers were full (collect more often or raise BENCHMARK_ZONE_BUFFER_SIZE)"
+               << benchmark::detail::ColorReset << "\n";
+        }
+        os << std::setprecision(oldPrecision);
+        os.flush();
+    }
+};
+
+}} // namespaces
+
+#define BENCHMARK_ZONE_CONCAT_IMPL(a, b) a##b
+#define BENCHMARK_ZONE_CONCAT(a, b) BENCHMARK_ZONE_CONCAT_IMPL(a, b)
+
+#define BENCHMARK_ZONE(name) \
+    static const uint32_t BENCHMARK_ZONE_CONCAT(__benchmarkZoneId, __LINE__) = \
+        ::benchmark::zones::Registry::instance().zoneId(name); \
+    ::benchmark::zones::ScopedZone BENCHMARK_ZONE_CONCAT(__benchmarkZone, __LINE__)( \
+        BENCHMARK_ZONE_CONCAT(__benchmarkZoneId, __LINE__))
+
+#else
+
+#define BENCHMARK_ZONE(name)
+
+#endif
@@ -0,0 +1,213 @@
+#include <benchmark/detail/antagonist.h>
+#include <benchmark/detail/dataset.h>
+#include <benchmark/detail/dont_optimize.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+namespace benchmark {
+namespace detail {
+
+namespace {
+
+const size_t CacheLine = 64;
+
+using BranchyFunction = uint64_t (*)(uint64_t);
+
+// a different shape for every N, so that the functions neither fold into one nor share their branch history
+template<unsigned N>
+__attribute__((noinline)) uint64_t branchy(uint64_t x) {
+    if (x & 1)
+        x = x * (2 * N + 3) + N;
+    else
+        x ^= x >> (N % 13 + 1);
+    if (x & 2)
+        x += (uint64_t)N * 0x9E37u;
+    else
+        x = (x << 3) - N;
+    switch ((x >> 2) & 7) {
+        case 0: x += N; break;
+        case 1: x ^= (uint64_t)N << 5; break;
+        case 2: x = x * 7 + N; break;
+        case 3: x -= x >> (N % 7 + 2); break;
+        case 4: x ^= 0x5bd1e995u + N; break;
+        case 5: x = (x >> 1) | ((uint64_t)N << 40); break;
+        case 6: x += x << (N % 5 + 1); break;
+        default: x = ~x + N; break;
+    }
+    return x;
+}
+
+// fills the table with branchy<From>..branchy<From + Count - 1>, split in halves to keep the template depth low
+template<unsigned From, unsigned Count>
+struct BranchyTable {
+    static void fill(BranchyFunction *table) {
+        BranchyTable<From, Count / 2>::fill(table);
+        BranchyTable<From + Count / 2, Count - Count / 2>::fill(table);
+    }
+};
+
+template<unsigned From>
+struct BranchyTable<From, 1> {
+    static void fill(BranchyFunction *table) {
+        table[From] = &branchy<From>;
+    }
+};
+
+// about 100 bytes of code each, several times a 32 KiB instruction cache
+const unsigned BranchyFunctions = 1024;
+
+} // namespace
+
+int parseAntagonist(const std::string &text) {
+    for (int kind = AntagonistLLC; kind <= AntagonistSMT; kind++) {
+        if (text == antagonistName(kind))
+            return kind;
+    }
+    return -1;
+}
+
+const char *antagonistName(int kind) {
+    switch (kind) {
+        case AntagonistLLC: return "llc";
+        case AntagonistBandwidth: return "bandwidth";
+        case AntagonistBranch: return "branch";
+        case AntagonistSMT: return "smt";
+    }
+    return "quiet";
+}
+
+std::vector<int> withQuietBaseline(std::vector<int> kinds) {
+    kinds.erase(std::remove(kinds.begin(), kinds.end(), (int)AntagonistNone), kinds.end());
+    kinds.insert(kinds.begin(), AntagonistNone);
+    return kinds;
+}
+
+size_t lastLevelCacheSize(int cpu) {
+    size_t result = 0;
+    for (int index = 0; index < 8; index++) {
+        std::string dir = "/sys/devices/system/cpu/cpu" + std::to_string(std::max(cpu, 0)) + "/cache/index" +
+                          std::to_string(index);
+        std::string size = readSysfsLine(dir + "/size");
+        if (size.empty())
+            break;
+        size_t bytes = (size_t)std::strtoull(size.c_str(), nullptr, 10);
+        if (size.back() == 'K')
+            bytes <<= 10;
+        else if (size.back() == 'M')
+            bytes <<= 20;
+        result = std::max(result, bytes);
+    }
+    return result > 0 ? result : (size_t)32 << 20;
+}
+
+std::vector<int> antagonistCpus(int kind, int cpu, const std::vector<LogicalCpu> &topology,
+                                const std::vector<int> &configured) {
+    if (!configured.empty())
+        return configured;
+
+    auto self = std::find_if(topology.begin(), topology.end(), [=](const LogicalCpu &c) { return c.cpu == cpu; });
+    std::vector<int> result;
+    if (self == topology.end())
+        return result;
+
+    for (auto &other : topology) {
+        if (other.cpu == cpu)
+            continue;
+        bool sibling = other.core == self->core;
+        if (kind == AntagonistBranch || kind == AntagonistSMT) {
+            if (sibling)
+                result.push_back(other.cpu);
+        } else if (!sibling && (kind == AntagonistBandwidth || other.l3 == self->l3)) {
+            result.push_back(other.cpu);
+        }
+    }
+    return result;
+}
+
+Antagonists::Antagonists(int kind, const std::vector<int> &cpus)
+    : _kind(kind), _cpus(cpus), _stop(false) {
+    if (_kind == AntagonistNone || _cpus.empty())
+        return;
+
+    size_t llc = lastLevelCacheSize(_cpus.front());
+    if (_kind == AntagonistLLC) {
+        _buffer.resize(2 * llc);
+    } else if (_kind == AntagonistBandwidth) {
+        _buffer.resize(std::max(4 * llc, (size_t)64 << 20));
+        _target.resize(_buffer.size());
+    }
+    // touched up front, so that the page faults are over before the first sample
+    std::memset(_buffer.data(), 1, _buffer.size());
+    std::memset(_target.data(), 0, _target.size());
+
+    for (size_t i = 0; i < _cpus.size(); i++)
+        _threads.emplace_back(&Antagonists::loop, this, _cpus[i], i);
+}
+
+Antagonists::~Antagonists() {
+    _stop = true;
+    for (auto &thread : _threads)
+        thread.join();
+}
+
+void Antagonists::loop(int cpu, size_t index) {
+    pinCurrentThread(cpu);
+
+    size_t slice = _buffer.size() / _cpus.size() / CacheLine * CacheLine;
+    char *begin = _buffer.data() + index * slice;
+    uint64_t x = 0x9E3779B97F4A7C15ull * (index + 1);
+
+    if (_kind == AntagonistLLC) {
+        while (!_stop.load(std::memory_order_relaxed)) {
+            // written rather than read, dirty lines cost the benchmark a write-back on top of the miss
+            for (size_t offset = 0; offset < slice; offset += CacheLine)
+                begin[offset]++;
+            benchmark::ClobberMemory();
+        }
+    } else if (_kind == AntagonistBandwidth) {
+        char *target = _target.data() + index * slice;
+        while (!_stop.load(std::memory_order_relaxed)) {
+            std::memcpy(target, begin, slice);
+            benchmark::ClobberMemory();
+        }
+    } else if (_kind == AntagonistBranch) {
+        BranchyFunction table[BranchyFunctions];
+        BranchyTable<0, BranchyFunctions>::fill(table);
+        data::SplitMix64 random(x);
+        while (!_stop.load(std::memory_order_relaxed)) {
+            for (unsigned i = 0; i < 1024; i++) {
+                uint64_t r = random.next();
+                x = table[r % BranchyFunctions](x ^ r);
+            }
+        }
+    } else if (_kind == AntagonistSMT) {
+        // independent chains, as many ports busy as the core has
+        uint64_t a = x, b = x + 1, c = x + 2, d = x + 3;
+        while (!_stop.load(std::memory_order_relaxed)) {
+            for (unsigned i = 0; i < 1024; i++) {
+                a = a * 3 + 1;
+                b = b * 5 + 3;
+                c ^= c << 1;
+                d += d >> 2;
+            }
+            benchmark::DoNotOptimize(a);
+            benchmark::DoNotOptimize(b);
+            benchmark::DoNotOptimize(c);
+            benchmark::DoNotOptimize(d);
+        }
+        x = a + b + c + d;
+    }
+    benchmark::DoNotOptimize(x);
+}
+
+std::string Antagonists::description() const {
+    if (_kind == AntagonistNone)
+        return "";
+    if (_cpus.empty())
+        return std::string(antagonistName(_kind)) + " (no cpu for it)";
+    return std::string(antagonistName(_kind)) + " on cpus " + formatCpuList(_cpus);
+}
+
+}} //namespaces
@@ -0,0 +1,23 @@
+#include <benchmark/detail/arena.h>
+
+namespace benchmark {
+namespace detail {
+
+int parseAllocatorStrategy(const std::string &text) {
+    static const char *names[] = {"arena", "system", "pool"};
+    for (int i = 0; i < (int)(sizeof(names) / sizeof(names[0])); i++) {
+        if (text == names[i])
+            return i;
+    }
+    return -1;
+}
+
+const char *allocatorStrategyName(int strategy) {
+    switch (strategy) {
+        case AllocatorSystem: return "system";
+        case AllocatorPool: return "pool";
+    }
+    return "arena";
+}
+
+}} //namespaces
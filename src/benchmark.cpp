@@ -1,6 +1,33 @@
 #include <benchmark/benchmark.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <benchmark/detail/antagonist.h>
+#include <benchmark/detail/chrono_utils.h>
+#include <benchmark/detail/colorization.h>
+#include <benchmark/detail/comparison_table.h>
+#include <benchmark/detail/core_latency.h>
+#include <benchmark/detail/cpu_info.h>
+#include <benchmark/detail/energy.h>
+#include <benchmark/detail/file_io.h>
+#include <benchmark/detail/history.h>
+#include <benchmark/detail/json_report.h>
+#include <benchmark/detail/page_resource.h>
+#include <benchmark/detail/sample_dump.h>
+#include <benchmark/detail/topology.h>
+#include <benchmark/detail/trace_writer.h>
+
+#include <sys/resource.h>
 
 BenchmarkSilo::BenchmarkCont *BenchmarkSilo::benchmarks;
+BenchmarkSilo::GroupCont *BenchmarkSilo::groupDefinitions;
 
 namespace benchmark {
 
@@ -9,3 +36,1308 @@ void UseCharPointer(char const volatile *)
 }
 
 } // namespace benchmark
+
+Benchmark::Benchmark(const BenchmarkSetup &setup_, const char *name_)
+    : _name(name_), _setup(setup_), _totalIterations(0), Iterations(200), _out(&std::cout) {
+    // benchmarks register during static initialization, maybe before std::cout of a translation unit without <iostream>
+    static std::ios_base::Init streams;
+    configureStatistics();
+
+    // clock's now() takes longer when called first time
+    auto init_timer = benchmark::clock_t::now();
+    benchmark::DoNotOptimize(init_timer);
+
+    static bool onlyOnce = false;
+    if (!onlyOnce) {
+        onlyOnce = true;
+        printCPULoad();
+    }
+}
+
+Benchmark::~Benchmark() {
+}
+
+void Benchmark::setSetup(const BenchmarkSetup &setup_) {
+    _setup = setup_;
+    configureStatistics();
+}
+
+void Benchmark::configureStatistics() {
+    _stats.setOutlierMethod(_setup.outlierMethod);
+    _stats.setBootstrap(_setup.bootstrap);
+    _stats.setPercentiles(_setup.percentiles);
+}
+
+void Benchmark::warmupCpu() {
+    static std::atomic<bool> done{false};
+    if (done.exchange(true)) // benchmarks of the parallel mode may get here at the same time
+        return;
+
+    out() << benchmark::detail::ColorLightRed
+              << "Warning: CPU power-safe mode enabled. Will try to warm up before the benchmark."
+              << benchmark::detail::ColorReset
+              << std::endl;
+
+    static const auto WarmupTime = std::chrono::seconds(4);
+
+    auto start = benchmark::clock_t::now(); // do nothing serious for N seconds cycle
+    while (true) {
+        unsigned p = rand();
+        benchmark::DoNotOptimize(p);
+        if (benchmark::clock_t::now() - start > WarmupTime)
+            break;
+    }
+}
+
+void Benchmark::discardWarmup() {
+    if (_steadyState.steady()) {
+        _warmupSamples = (unsigned)_steadyState.warmupSamples();
+        _warmupTime = _steadyState.warmupTime();
+        _stats.discardFirst(_warmupSamples);
+    } else {
+        // too few samples to tell is fine, a series that keeps drifting isn't
+        _steadyStateMissed = _steadyState.size() >=
+            benchmark::detail::SteadyStateDetector::BatchSize * benchmark::detail::SteadyStateDetector::MinBatches;
+    }
+}
+
+std::string Benchmark::sampleLabel(benchmark::detail::BenchmarkState &bs) {
+    std::string label = _name;
+    if (bs.hasArgument())
+        label += " $1=" + std::to_string(bs.getArg());
+    if (!_memoryLabel.empty())
+        label += " | " + _memoryLabel;
+    if (!_antagonistLabel.empty())
+        label += " | " + _antagonistLabel;
+    if (!_layoutLabel.empty())
+        label += " | " + _layoutLabel;
+    return label;
+}
+
+void Benchmark::configureMemory(benchmark::detail::BenchmarkState &bs) {
+    int placement = bs.listValue(benchmark::detail::ListPlacement, _setup.placement);
+    int backing = bs.listValue(benchmark::detail::ListBacking, _setup.backing);
+    int strategy = bs.listValue(benchmark::detail::ListAllocator, _setup.allocator);
+    _strategy.reset();
+    _pages.reset();
+    unpinBlock();
+    std::vector<benchmark::detail::NumaNode> nodes = benchmark::detail::readNumaNodes();
+    _pages.reset(new benchmark::detail::PageResource(placement, backing, nodes));
+    // local and remote are relative to the node the thread is on when the policy is made, so it stays there
+    if (placement != benchmark::PlaceDefault) {
+        for (auto &node : nodes) {
+            if (node.id == _pages->policy().threadNode)
+                pinBlock(node.cpus);
+        }
+    }
+    if (strategy == benchmark::AllocatorSystem)
+        _strategy.reset(new benchmark::SystemResource());
+    else if (strategy == benchmark::AllocatorPool)
+        _strategy.reset(new benchmark::PoolResource(_pages.get()));
+    _memory = _strategy ? _strategy.get() : _pages.get();
+
+    _pagesLabel = placement == benchmark::PlaceDefault && backing == benchmark::BackingDefault ? "" : _pages->description();
+    _memoryLabel = strategy == benchmark::AllocatorSystem ? "" : _pagesLabel; // the heap ignores both
+    if (strategy != benchmark::AllocatorArena || allocatorSwept(bs)) {
+        std::string name = benchmark::detail::allocatorStrategyName(strategy);
+        _memoryLabel = _memoryLabel.empty() ? name : name + ", " + _memoryLabel;
+    }
+}
+
+void Benchmark::pinBlock(const std::vector<int> &cpus) {
+    std::vector<int> allowed = benchmark::detail::currentAffinity();
+    std::vector<int> pinned;
+    for (int cpu : cpus) {
+        if (allowed.empty() || std::find(allowed.begin(), allowed.end(), cpu) != allowed.end())
+            pinned.push_back(cpu);
+    }
+    if (pinned.empty() || pinned == allowed)
+        return;
+    if (_unpinnedAffinity.empty())
+        _unpinnedAffinity = allowed;
+    benchmark::detail::pinCurrentThread(pinned);
+}
+
+void Benchmark::unpinBlock() {
+    if (_unpinnedAffinity.empty())
+        return;
+    benchmark::detail::pinCurrentThread(_unpinnedAffinity);
+    _unpinnedAffinity.clear();
+}
+
+void Benchmark::configureAntagonist(benchmark::detail::BenchmarkState &bs) {
+    _antagonists.reset();
+    _antagonistLabel.clear();
+    _antagonistIdle = false;
+    if (bs.listValue(benchmark::detail::ListAntagonist, -1) < 0)
+        return;
+
+    // the benchmark thread stays where it is, quiet or not, so that it doesn't move onto the cores of the antagonist
+    int cpu = benchmark::detail::getCurrentCore();
+    if (cpu >= 0)
+        pinBlock({cpu});
+
+    int kind = bs.listValue(benchmark::detail::ListAntagonist, benchmark::AntagonistNone);
+    if (kind == benchmark::AntagonistNone) {
+        _antagonistLabel = benchmark::detail::antagonistName(kind);
+        return;
+    }
+    std::vector<int> cpus =
+        benchmark::detail::antagonistCpus(kind, cpu, benchmark::detail::readTopology(), _setup.antagonistCpus);
+    _antagonists.reset(new benchmark::detail::Antagonists(kind, cpus));
+    _antagonistLabel = _antagonists->description();
+    _antagonistIdle = !_antagonists->running();
+}
+
+void Benchmark::configureLayout(benchmark::detail::BenchmarkState &bs) {
+    _heapGap.reset();
+    _offsetMemory.reset();
+    _layoutLabel.clear();
+    int index = bs.listValue(benchmark::detail::ListLayout, -1);
+    _layout = benchmark::detail::memoryLayout(index < 0 ? 0 : (unsigned)index);
+    if (index < 0)
+        return;
+
+    _layoutLabel = _layout.description();
+    if (_layout.heap > 0)
+        _heapGap.reset(new char[_layout.heap]);
+    if (_layout.data > 0) {
+        _offsetMemory.reset(new benchmark::detail::OffsetResource(_memory, _layout.data));
+        _memory = _offsetMemory.get();
+    }
+}
+
+void Benchmark::resetMemory() {
+    _memory->reset();
+    if (_memory != _pages.get())
+        _pages->reset();
+}
+
+void Benchmark::printStrategyDifference(const std::vector<StrategyResult> &results) {
+    if (results.empty() || _setup.outputStyle == BenchmarkSetup::OutputStyle::Nothing)
+        return;
+
+    const std::string &baseline = results.front().strategy;
+    benchmark::detail::ComparisonTable table(_name);
+    for (auto &entry : results) {
+        std::ostringstream cell;
+        const benchmark::detail::BenchmarkResult &result = entry.result;
+        auto base = std::find_if(results.begin(), results.end(), [&](const StrategyResult &other) {
+            return other.strategy == baseline && other.row == entry.row;
+        });
+        if (entry.strategy != baseline && base != results.end() && base->result.median.count() > 0) {
+            int verdict = benchmark::detail::significance(base->result, result);
+            char difference[32];
+            std::snprintf(difference, sizeof(difference), "%+.1f%%",
+                          ((double)result.median.count() / base->result.median.count() - 1.0) * 100.0);
+            cell << (verdict > 0 ? benchmark::detail::ColorLightGreen : verdict < 0 ? benchmark::detail::ColorRed : "")
+                 << result.median << " (" << difference << ")" << benchmark::detail::ColorReset;
+        } else {
+            cell << result.median;
+        }
+        table.addCell(table.column(entry.strategy), entry.row, entry.measured ? cell.str() : "n/a");
+    }
+    out() << "\n";
+    table.print(out());
+}
+
+void Benchmark::printLayoutVariance(const std::vector<StrategyResult> &results) {
+    if (results.empty() || _setup.outputStyle == BenchmarkSetup::OutputStyle::Nothing)
+        return;
+
+    std::vector<std::string> rows;
+    for (auto &entry : results) {
+        if (std::find(rows.begin(), rows.end(), entry.row) == rows.end())
+            rows.push_back(entry.row);
+    }
+
+    benchmark::detail::ComparisonTable table(_name + " layouts");
+    auto nanoseconds = [](double ns) {
+        std::ostringstream text;
+        text << std::chrono::duration_cast<benchmark::duration_t>(std::chrono::duration<double, std::nano>(ns));
+        return text.str();
+    };
+    auto percent = [](double part, double whole) {
+        char text[32];
+        std::snprintf(text, sizeof(text), "%.1f%%", whole > 0 ? part / whole * 100.0 : 0.0);
+        return std::string(text);
+    };
+    for (auto &row : rows) {
+        std::vector<benchmark::detail::BenchmarkResult> layouts;
+        for (auto &entry : results) {
+            if (entry.row == row)
+                layouts.push_back(entry.result);
+        }
+        benchmark::detail::LayoutVariance variance = benchmark::detail::layoutVariance(layouts);
+        table.addCell(table.column("median"), row, nanoseconds(variance.median));
+        table.addCell(table.column("fastest"), row, nanoseconds(variance.minimum));
+        table.addCell(table.column("slowest"), row, nanoseconds(variance.maximum));
+        table.addCell(table.column("sample σ"), row, percent(variance.sampleStdDev, variance.median));
+        table.addCell(table.column("layout σ"), row, percent(variance.layoutStdDev, variance.median));
+        char share[16];
+        std::snprintf(share, sizeof(share), "%.0f%%", variance.layoutShare * 100.0);
+        table.addCell(table.column("layout share"), row, share);
+    }
+    out() << "\n";
+    table.print(out());
+    out() << "Differences smaller than about twice the layout σ may come from the layout rather than the code\n";
+}
+
+void Benchmark::traceSample(const benchmark::detail::RunState &state, benchmark::detail::BenchmarkState &bs,
+                            unsigned index) {
+    _trace->addSample(sampleLabel(bs), state.startTime(), state.rawDuration(), index);
+
+    auto now = benchmark::clock_t::now();
+    int core = benchmark::detail::getCurrentCore();
+    if (core >= 0) {
+        _trace->addCounter("CPU core", state.startTime(), "core", core);
+    }
+    int freqKHz = benchmark::detail::readCoreFrequency(core);
+    if (freqKHz > 0) {
+        _trace->addCounter("CPU frequency", now, "MHz", freqKHz / 1000.0);
+    }
+    for (auto &counter : state.counters()) {
+        _trace->addCounter(counter.first, state.startTime(), counter.first, counter.second);
+    }
+    // what the body took from state.memory(), once it takes anything
+    if (_memory->allocations() > 0) {
+        _trace->addCounter("Allocations", state.startTime(), "count",
+                           (double)(_memory->allocations() - _allocationsBefore));
+        _trace->addCounter("Allocated", state.startTime(), "bytes",
+                           (double)(_memory->allocatedBytes() - _allocatedBytesBefore));
+    }
+}
+
+void Benchmark::storeResult(const int *varg1) {
+    benchmark::detail::BenchmarkResult result;
+    result.name = _name;
+    result.hasArg = varg1 != nullptr;
+    result.arg = varg1 ? *varg1 : 0;
+    result.iterations = _totalIterations;
+    result.operations = _operationsPerSample;
+    result.bytes = _bytesPerSample;
+    result.average = _stats.averageTime();
+    result.median = _stats.medianTime();
+    result.minimum = _stats.minimalTime();
+    result.maximum = _stats.maximalTime();
+    result.stdDev = _stats.standardDeviation();
+    result.medianInterval = _stats.medianInterval();
+    result.warmupSamples = _warmupSamples;
+    result.warmupTime = _warmupTime;
+    result.partition = _partition;
+    result.memory = _memory ? _memory->description() : "";
+    result.datasets = _datasets.used();
+    result.antagonist = _antagonistLabel;
+    result.layout = _layoutLabel;
+    if (_energy)
+        result.energy = _energy->usage();
+    for (auto &counter : _counterSums)
+        result.counters.emplace_back(counter.name, counter.sum / counter.samples);
+    _results.push_back(result);
+}
+
+void Benchmark::printResults(const int *varg1) {
+    auto oldPrecision = out().precision();
+    out() << std::fixed; // disable scientific notation
+
+    if (_setup.outputStyle == BenchmarkSetup::OutputStyle::Full) {
+        printTitle(varg1);
+        out() << " done ";
+
+        out() << benchmark::io::Iterations{_totalIterations} << " iters";
+        out() << ", total spent " << _stats.totalTimeRun() << "\n";
+
+        out() << "Avg    : " << benchmark::io::DurationInterval{_stats.averageTime(), _stats.averageInterval()};
+        if (_stats.averageTime() > std::chrono::milliseconds(1)) {
+            out() << " (" << std::setprecision(3)
+                      << 1000000.0f /
+                         std::chrono::duration_cast<std::chrono::microseconds>(_stats.averageTime()).count()
+                      << " fps)\n";
+        } else {
+            out() << "\n";
+        }
+
+        out() << "StdDev : " << benchmark::io::ColoredDuration{_stats.standardDeviation(),
+                                                                   _stats.highDeviation()
+                                                                   ? benchmark::detail::ColorRed
+                                                                   : benchmark::detail::ColorLightGreen};
+
+        if (_stats.standardDeviationLevel() >= 0.01f) {
+            out() << " (" << (int) (_stats.standardDeviationLevel() * 100.0) << "%)";
+        } else {
+            out() << std::setprecision(1)
+                      << " (" << (float) (_stats.standardDeviationLevel() * 100.0) << "%)";
+        }
+        out() << "\n";
+        out() << "Median : " << benchmark::io::DurationInterval{_stats.medianTime(), _stats.medianInterval()} << "\n";
+        for (int nth : _stats.percentiles()) {
+            out() << std::left << std::setw(7) << (std::to_string(nth) + "th") << std::right << ": "
+                      << benchmark::io::DurationInterval{_stats.percentile(nth), _stats.percentileInterval(nth)} << "\n";
+        }
+        out() << "Min    : " << _stats.minimalTime() << "\n";
+        out() << "Max    : " << _stats.maximalTime() << std::endl;
+        if (_operationsPerSample > 0) {
+            out() << "Per op : ";
+            printPerOperation();
+            out() << "\n";
+        }
+        if (_bytesPerSample > 0) {
+            out() << "Rate   : ";
+            printRate();
+            out() << "\n";
+        }
+        out() << "Timer  : overhead " << _calibration.overhead << " ± " << _calibration.overheadSpread
+                  << " subtracted, resolution " << _calibration.resolution << "\n";
+        if (_energy) {
+            out() << "Energy : ";
+            printEnergy();
+            out() << "\n";
+        }
+
+        if (!_counterSums.empty()) {
+            out() << "Counter: ";
+            printCounters();
+            out() << "\n";
+        }
+        if (!_datasets.used().empty()) {
+            out() << "Data   : " << _datasets.used() << "\n";
+        }
+        if (_warmupSamples > 0) {
+            out() << "Warm-up: " << _warmupSamples << " samples discarded, " << _warmupTime << " measured\n";
+        }
+        if (_stats.outlierMethod() != TimeStatistics::OutliersNone) {
+            out() << "Outliers: ";
+            printOutliers();
+            out() << "\n";
+        }
+        if (_stats.multimodal()) {
+            out() << benchmark::detail::ColorLightYellow << "Modes  : " << benchmark::detail::ColorReset;
+            printModes();
+            out() << std::endl;
+        }
+
+    } else if (_setup.outputStyle == BenchmarkSetup::OutputStyle::OneLine) {
+        printTitle(varg1);
+        out() << " ";
+
+        out() << benchmark::io::Iterations{_totalIterations} << " iters";
+
+        out() << ", avg: " << benchmark::io::DurationInterval{_stats.averageTime(), _stats.averageInterval()};
+        if (_stats.averageTime() > std::chrono::milliseconds(1)) {
+            out() << " (" << std::setprecision(3)
+                      << (1000000.0f /
+                          std::chrono::duration_cast<std::chrono::microseconds>(_stats.averageTime()).count())
+                      << " fps)";
+        }
+
+        out() << ", median: " << benchmark::io::DurationInterval{_stats.medianTime(), _stats.medianInterval()};
+        for (int nth : _stats.percentiles()) {
+            out() << ", " << nth << "th: "
+                      << benchmark::io::DurationInterval{_stats.percentile(nth), _stats.percentileInterval(nth)};
+        }
+
+        out() << ", stddev: " << benchmark::io::ColoredDuration{_stats.standardDeviation(),
+                                                                    _stats.highDeviation()
+                                                                    ? benchmark::detail::ColorRed
+                                                                    : benchmark::detail::ColorReset};
+        if (_stats.standardDeviationLevel() >= 0.01f) {
+            out() << " (" << (int) (_stats.standardDeviationLevel() * 100.0) << "%)";
+        } else {
+            out() << " (" << std::setprecision(1) << (float) (_stats.standardDeviationLevel() * 100.0) << "%)";
+        }
+
+        out() << ", min: " << _stats.minimalTime();
+
+        if (_operationsPerSample > 0) {
+            out() << ", per op: ";
+            printPerOperation();
+        }
+        if (_bytesPerSample > 0) {
+            out() << ", rate: ";
+            printRate();
+        }
+        if (_energy) {
+            out() << ", energy: ";
+            printEnergy();
+        }
+        if (!_counterSums.empty()) {
+            out() << ", counters: ";
+            printCounters();
+        }
+
+        if (_warmupSamples > 0) {
+            out() << ", warm-up: " << _warmupSamples << " samples (" << _warmupTime << ")";
+        }
+        if (_stats.outliers().total() > 0) {
+            out() << ", outliers: ";
+            printOutliers();
+        }
+        out() << std::endl;
+
+        if (_stats.multimodal()) {
+            out() << benchmark::detail::ColorLightYellow << "    multimodal: " << benchmark::detail::ColorReset;
+            printModes();
+            out() << std::endl;
+        }
+    }
+
+    if (_setup.outputStyle != BenchmarkSetup::OutputStyle::Nothing && _steadyStateMissed) {
+        out() << benchmark::detail::ColorLightRed
+                  << "    Warning: steady state not reached, the timings kept drifting until the end"
+                  << benchmark::detail::ColorReset << std::endl;
+    }
+    if (_setup.outputStyle != BenchmarkSetup::OutputStyle::Nothing && _calibration.overhead.count() > 0 &&
+        _calibration.nearFloor(_stats.medianTime())) {
+        out() << benchmark::detail::ColorLightRed << "    Warning: the result is close to the timer floor (overhead "
+                  << _calibration.overhead << " ± " << _calibration.overheadSpread << ", resolution "
+                  << _calibration.resolution << "), measure more work per sample, e.g. with REPEAT"
+                  << benchmark::detail::ColorReset << std::endl;
+    }
+    out() << std::setprecision(oldPrecision);
+}
+
+void Benchmark::printTitle(const int *varg1) {
+    out() << "[Benchmark '" << _name << "'";
+    if (varg1)
+        out() << " $1=" << *varg1;
+    if (!_memoryLabel.empty())
+        out() << " | " << _memoryLabel;
+    if (!_antagonistLabel.empty())
+        out() << " | " << _antagonistLabel;
+    if (!_layoutLabel.empty())
+        out() << " | " << _layoutLabel;
+    if (!_partition.empty())
+        out() << " on " << _partition;
+    out() << "]";
+}
+
+void Benchmark::printPerOperation() {
+    double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(_stats.medianTime()).count() /
+                (double)_operationsPerSample;
+    double cyclesPerNs = benchmark::detail::coreCyclesPerNanosecond();
+
+    auto oldPrecision = out().precision();
+    out() << std::setprecision(3) << ns << " ns";
+    if (cyclesPerNs > 0.0) {
+        out() << ", " << std::setprecision(2) << ns * cyclesPerNs << " cycles";
+    }
+    out() << " (" << _operationsPerSample << " ops/sample)" << std::setprecision(oldPrecision);
+}
+
+void Benchmark::printRate() {
+    double seconds = std::chrono::duration<double>(_stats.medianTime()).count();
+    if (seconds <= 0.0)
+        return;
+    if (_operationsPerSample > 0)
+        out() << benchmark::detail::formatRate((double)_operationsPerSample / seconds, "ops") << ", ";
+    out() << benchmark::detail::formatRate((double)_bytesPerSample / seconds, "B");
+}
+
+void Benchmark::printCounters() {
+    for (size_t i = 0; i < _counterSums.size(); i++) {
+        char value[32];
+        std::snprintf(value, sizeof(value), "%.4g", _counterSums[i].sum / _counterSums[i].samples);
+        out() << (i ? ", " : "") << _counterSums[i].name << "=" << value;
+    }
+}
+
+void Benchmark::printOutliers() {
+    const TimeStatistics::OutlierCounts &outliers = _stats.outliers();
+    out() << outliers.total() << " of " << _stats.size();
+
+    if (outliers.total() == 0)
+        return;
+
+    const char *sep = " (";
+    const std::pair<unsigned, const char *> classes[] = {{outliers.lowSevere, "low severe"},
+                                                         {outliers.lowMild, "low mild"},
+                                                         {outliers.highMild, "high mild"},
+                                                         {outliers.highSevere, "high severe"}};
+    for (auto &cls : classes) {
+        if (cls.first == 0)
+            continue;
+        out() << sep << cls.first << " " << cls.second;
+        sep = ", ";
+    }
+    out() << ")";
+}
+
+void Benchmark::printEnergy() {
+    std::vector<benchmark::detail::EnergyUsage> usage = _energy->usage();
+    if (usage.empty()) {
+        out() << "unavailable";
+        return;
+    }
+    const char *sep = "";
+    for (auto &domain : usage) {
+        char watts[32];
+        std::snprintf(watts, sizeof(watts), "%.3g W", domain.watts);
+        out() << sep << domain.domain << " " << benchmark::detail::formatEnergy(domain.joules) << "/iter " << watts;
+        sep = ", ";
+    }
+}
+
+void Benchmark::printModes() {
+    const char *sep = "";
+    for (auto &mode : _stats.modes()) {
+        out() << sep << mode.median << " (" << (int)std::lround(mode.share * 100.0) << "%, "
+                  << mode.low << ".." << mode.high << ")";
+        sep = " | ";
+    }
+}
+
+void Benchmark::printCPULoad() {
+    out() << "CPU usage:\n";
+    auto cpuLoad = benchmark::detail::getCPULoad();
+    out() << cpuLoad;
+    out() << "\n\n";
+}
+
+void Benchmark::beginRun(benchmark::detail::BenchmarkState &bs) {
+#ifdef _DEBUG
+    static std::once_flag warnDebugMode;
+    std::call_once(warnDebugMode, [this]() { out() << "Warning: Running in a Debug configuration" << std::endl; });
+#endif
+    // in the parallel mode the other cores are busy with benchmarks already, ANTAGONISTS() of the body too
+    if (!_partition.empty())
+        bs.ignoreList(benchmark::detail::ListAntagonist);
+    else if (!_setup.antagonists.empty())
+        bs.sweepList(benchmark::detail::ListAntagonist, benchmark::detail::withQuietBaseline(_setup.antagonists));
+    if (_setup.layouts > 1)
+        bs.sweepList(benchmark::detail::ListLayout, benchmark::detail::layoutList(_setup.layouts));
+
+    if (!_setup.skipWarmup) {
+        if (benchmark::detail::isCPUScalingEnabled()) {
+            warmupCpu(); // TODO: check if it really works
+        }
+    }
+
+    int ret = setpriority(PRIO_PROCESS, 0, -20);
+    if (ret == -1) {
+        out() << "Couldn't to set priority (code " << errno << "), try to run with administrator privileges" << std::endl;
+    }
+
+    calibrateTimer();
+
+    _energy.reset();
+    if (_setup.energy)
+        _energy.reset(new benchmark::detail::EnergyMeter(benchmark::detail::readRaplDomains()));
+
+    if (_setup.outputStyle == BenchmarkSetup::OutputStyle::Full)
+        out() << "[Benchmark '" << _name << "'] started" << std::endl;
+}
+
+void Benchmark::beginBlock(benchmark::detail::BenchmarkState &bs) {
+    _totalIterations = 0;
+    _blockStartTime = std::chrono::steady_clock::now();
+
+    if (bs.variableArgsMode()) {
+        bs.pickNextArgument();
+    }
+    configureMemory(bs);
+    configureAntagonist(bs);
+    configureLayout(bs);
+    _datasets.beginBlock();
+    if (_energy)
+        _energy->clear();
+    _stats.clear();
+    _operationsPerSample = 0;
+    _bytesPerSample = 0;
+    _counterSums.clear();
+    _steadyState.clear();
+    _warmupSamples = 0;
+    _warmupTime = benchmark::duration_t(0);
+    _steadyStateMissed = false;
+    _sampleIndex = 0;
+
+    _cpuStatsBefore.reset();
+    _traceBlockStart = benchmark::time_point_t{};
+    if (_trace) {
+        _cpuStatsBefore = benchmark::detail::readCPUStats();
+    }
+    _dumpBlock = _dump ? _dump->beginBlock(sampleLabel(bs)) : 0;
+}
+
+void Benchmark::beginSample(benchmark::detail::RunState &state) {
+    state.setMemory(_memory);
+    state.setDatasets(&_datasets);
+    if (_trace) {
+        _allocationsBefore = _memory->allocations();
+        _allocatedBytesBefore = _memory->allocatedBytes();
+    }
+
+    if (_energy)
+        _energy->begin();
+}
+
+bool Benchmark::endSample(const benchmark::detail::RunState &state, benchmark::detail::BenchmarkState &bs,
+                          unsigned &counted) {
+    if (_energy)
+        _energy->end();
+    resetMemory();
+
+    if (bs.needRestart()) // needed for ADD_ARG_RANGE functionality
+        return false;
+
+    benchmark::duration_t sample = state.getSample();
+    _operationsPerSample = state.operations();
+    _bytesPerSample = state.bytes();
+    for (auto &counter : state.counters()) {
+        auto sum = std::find_if(_counterSums.begin(), _counterSums.end(),
+                                [&](const CounterSum &c) { return c.name == counter.first; });
+        if (sum == _counterSums.end()) {
+            _counterSums.push_back(CounterSum{counter.first, counter.second, 1});
+        } else {
+            sum->sum += counter.second;
+            sum->samples++;
+        }
+    }
+
+    if (_trace) {
+        if (_sampleIndex == 0)
+            _traceBlockStart = state.startTime();
+        traceSample(state, bs, _sampleIndex);
+    }
+    if (_dump) {
+        _dump->record(_dumpBlock, state, sample);
+    }
+
+    _totalIterations++;
+    _stats.addSample(sample);
+    _sampleIndex++;
+
+    // samples of the warm-up don't count, they are going to be discarded
+    if (_setup.skipSteadyState || _steadyState.add(sample)) {
+        counted++;
+    }
+
+    // give other processes chance to do their job, so that the scheduler is less willing to suspend ours
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    if (std::chrono::steady_clock::now() - _blockStartTime > std::chrono::seconds(2))
+        return false;
+
+    out() << (_sampleIndex % 5 ? "" : ".");
+    out().flush();
+    return true;
+}
+
+void Benchmark::endBlock(benchmark::detail::BenchmarkState &bs, std::vector<StrategyResult> &strategyResults) {
+    if (!_setup.skipSteadyState) {
+        discardWarmup();
+    }
+
+    if (_trace && !_stats.empty()) {
+        std::string label = sampleLabel(bs);
+        _trace->addMarker(label, _traceBlockStart);
+        float load = benchmark::detail::getTotalCPULoad(*_cpuStatsBefore, *benchmark::detail::readCPUStats());
+        _trace->addCounter("CPU load", _traceBlockStart, "%", load * 100.0);
+    }
+
+    _antagonists.reset(); // quiet again for the printing
+
+    if (!_stats.empty()) {
+        calculateTimings();
+
+        out() << "\r";
+        out().flush();
+
+        if (bs.hasArgument()) {
+            int varg1 = bs.getArg();
+            printResults(&varg1);
+            storeResult(&varg1);
+        } else {
+            printResults(nullptr);
+            storeResult(nullptr);
+        }
+
+        std::string argument = bs.hasArgument() ? "$1=" + std::to_string(bs.getArg()) : "-";
+        int antagonist = bs.listValue(benchmark::detail::ListAntagonist, -1);
+        int layout = bs.listValue(benchmark::detail::ListLayout, -1);
+        // the strategies and antagonists are compared under the same layout
+        std::string layoutRow = layout >= 0 ? " | layout " + std::to_string(layout) : "";
+        if (allocatorSwept(bs)) {
+            std::string row = argument;
+            if (!_pagesLabel.empty())
+                row += " | " + _pagesLabel;
+            if (antagonist >= 0)
+                row += std::string(" | ") + benchmark::detail::antagonistName(antagonist);
+            row += layoutRow;
+            int strategy = bs.listValue(benchmark::detail::ListAllocator, benchmark::AllocatorArena);
+            strategyResults.push_back(StrategyResult{benchmark::detail::allocatorStrategyName(strategy), row,
+                                                     _results.back(), benchmark::detail::ListAllocator, true});
+        }
+        if (antagonist >= 0) {
+            std::string row = _memoryLabel.empty() ? argument : argument + " | " + _memoryLabel;
+            strategyResults.push_back(StrategyResult{benchmark::detail::antagonistName(antagonist), row + layoutRow,
+                                                     _results.back(), benchmark::detail::ListAntagonist,
+                                                     !_antagonistIdle});
+        }
+        if (layout >= 0) {
+            std::string row = _memoryLabel.empty() ? argument : argument + " | " + _memoryLabel;
+            if (antagonist >= 0)
+                row += std::string(" | ") + benchmark::detail::antagonistName(antagonist);
+            strategyResults.push_back(
+                StrategyResult{_layoutLabel, row, _results.back(), benchmark::detail::ListLayout, true});
+        }
+    }
+}
+
+void Benchmark::endRun(const std::vector<StrategyResult> &strategyResults) {
+    for (auto dimension : {benchmark::detail::ListAllocator, benchmark::detail::ListAntagonist}) {
+        std::vector<StrategyResult> results;
+        for (auto &result : strategyResults) {
+            if (result.dimension == dimension)
+                results.push_back(result);
+        }
+        printStrategyDifference(results);
+    }
+
+    std::vector<StrategyResult> layouts;
+    for (auto &result : strategyResults) {
+        if (result.dimension == benchmark::detail::ListLayout)
+            layouts.push_back(result);
+    }
+    printLayoutVariance(layouts);
+    _heapGap.reset();
+    _datasets.clear();
+    unpinBlock();
+}
+
+benchmark::duration_t CoreLatencyBenchmark::fromNs(double ns) {
+    return std::chrono::duration_cast<benchmark::duration_t>(std::chrono::duration<double, std::nano>(ns));
+}
+
+std::string CoreLatencyBenchmark::formatNs(double ns) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), ns < 10 ? "%.1f" : "%.0f", ns);
+    return buf;
+}
+
+void CoreLatencyBenchmark::vrun() {
+    measure(benchmark::detail::readTopology());
+}
+
+void CoreLatencyBenchmark::measure(const std::vector<benchmark::detail::LogicalCpu> &cpus) {
+    bool quiet = setup().outputStyle == BenchmarkSetup::OutputStyle::Nothing;
+    if (cpus.size() < 2) {
+        if (!quiet)
+            out() << "[Benchmark 'CoreLatency'] needs at least 2 cpus, there is " << cpus.size() << std::endl;
+        return;
+    }
+
+    benchmark::detail::CoreLatencyMatrix matrix = benchmark::detail::measureCoreLatency(cpus, Rounds, RoundTrips);
+    for (size_t a = 0; a < cpus.size(); a++) {
+        for (size_t b = a + 1; b < cpus.size(); b++) {
+            const benchmark::detail::CoreLatencySample &sample = matrix.samples[a][b];
+            if (std::isnan(sample.median))
+                continue;
+            benchmark::detail::BenchmarkResult result{};
+            result.name = "CoreLatency cpu" + std::to_string(cpus[a].cpu) + "-cpu" + std::to_string(cpus[b].cpu);
+            result.iterations = Rounds;
+            result.operations = RoundTrips * 2;
+            result.average = fromNs(sample.average);
+            result.median = fromNs(sample.median);
+            result.minimum = fromNs(sample.minimum);
+            result.maximum = fromNs(sample.maximum);
+            result.stdDev = fromNs(sample.stdDev);
+            result.medianInterval = benchmark::detail::ConfidenceInterval{0, 0, false};
+            addResult(result);
+        }
+    }
+    if (!quiet)
+        print(matrix);
+}
+
+void CoreLatencyBenchmark::print(const benchmark::detail::CoreLatencyMatrix &matrix) {
+    out() << "[Benchmark 'CoreLatency'] one-way latency in ns, " << Rounds << " rounds of " << RoundTrips
+          << " round trips per pair\n";
+    benchmark::detail::ComparisonTable table("");
+    for (size_t a = 0; a < matrix.cpus.size(); a++) {
+        std::string row = "cpu" + std::to_string(matrix.cpus[a].cpu);
+        for (size_t b = 0; b < matrix.cpus.size(); b++) {
+            size_t column = table.column(std::to_string(matrix.cpus[b].cpu));
+            table.addCell(column, row, std::isnan(matrix.at(a, b)) ? "-" : formatNs(matrix.at(a, b)));
+        }
+    }
+    table.print(out());
+
+    std::vector<benchmark::detail::CoreLatencySample> relations = matrix.byRelation();
+    for (size_t r = 0; r < relations.size(); r++) {
+        if (std::isnan(relations[r].median))
+            continue;
+        out() << "    " << benchmark::detail::relationName((int)r) << ": " << formatNs(relations[r].median)
+              << " ns (" << formatNs(relations[r].minimum) << ".." << formatNs(relations[r].maximum) << ")\n";
+    }
+    for (auto &level : matrix.levels()) {
+        out() << "    up to " << formatNs(level.threshold) << " ns:";
+        for (auto &cluster : level.clusters)
+            out() << " [" << benchmark::detail::formatCpuList(cluster) << "]";
+        out() << "\n";
+    }
+    out().flush();
+}
+
+void BenchmarkSilo::registerBenchmark(Benchmark *pb) {
+    if (!benchmarks) {
+        benchmarks = new BenchmarkCont();
+    }
+    benchmarks->push_back(pb);
+}
+
+Benchmark *BenchmarkSilo::find(const std::string &name) {
+    for (size_t i = 0; benchmarks && i < benchmarks->size(); i++) {
+        if ((*benchmarks)[i]->name() == name)
+            return (*benchmarks)[i];
+    }
+    return nullptr;
+}
+
+bool BenchmarkSilo::compared(const Benchmark *benchmark) {
+    for (auto other : *benchmarks) {
+        if (other->compares(benchmark->name()))
+            return true;
+    }
+    return false;
+}
+
+int BenchmarkSilo::runAll() {
+    for (auto benchmark : *benchmarks) {
+        if (!compared(benchmark))
+            benchmark->vrun();
+    }
+    printGroups();
+    return 0;
+}
+
+int BenchmarkSilo::runParallel(benchmark::detail::PartitionGranularity granularity) {
+    std::vector<benchmark::detail::CorePartition> partitions =
+        benchmark::detail::partitionCores(benchmark::detail::readTopology(), granularity);
+
+    // RAPL counts for the whole socket, the energy of a benchmark is its own only while it runs alone
+    std::vector<Benchmark *> shared, exclusive;
+    for (auto benchmark : *benchmarks) {
+        if (!compared(benchmark))
+            (benchmark->exclusive() || benchmark->setup().energy ? exclusive : shared).push_back(benchmark);
+    }
+
+    std::cout << "Running " << shared.size() << " benchmarks on " << partitions.size() << " partitions";
+    if (!exclusive.empty())
+        std::cout << ", then " << exclusive.size() << " exclusive ones";
+    std::cout << std::endl;
+
+    std::mutex outputMutex;
+    auto runBuffered = [&outputMutex](Benchmark *benchmark, const std::string &partition) {
+        std::ostringstream buffer;
+        buffer.copyfmt(std::cout);
+        benchmark->setOutput(&buffer);
+        benchmark->setPartition(partition);
+        benchmark->vrun();
+        benchmark->setOutput(&std::cout);
+
+        std::lock_guard<std::mutex> lock(outputMutex);
+        std::cout << buffer.str();
+        std::cout.flush();
+    };
+
+    std::atomic<size_t> next{0};
+    std::vector<std::thread> workers;
+    for (auto &partition : partitions) {
+        workers.emplace_back([&shared, &next, &partition, &runBuffered, &outputMutex]() {
+            if (!benchmark::detail::pinCurrentThread(partition.cpus.front())) {
+                std::lock_guard<std::mutex> lock(outputMutex);
+                std::cerr << "Couldn't pin a thread to cpu " << partition.cpus.front() << "\n";
+            }
+            for (size_t i = next++; i < shared.size(); i = next++) {
+                runBuffered(shared[i], partition.label());
+            }
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+
+    for (auto benchmark : exclusive) {
+        runBuffered(benchmark, "exclusive");
+    }
+
+    printGroups();
+    return 0;
+}
+
+void BenchmarkSilo::registerGroup(const char *group, const char *members) {
+    if (!groupDefinitions) {
+        groupDefinitions = new GroupCont();
+    }
+    groupDefinitions->emplace_back(group, members);
+}
+
+std::vector<benchmark::detail::BenchmarkGroup> BenchmarkSilo::groups() {
+    std::vector<benchmark::detail::BenchmarkGroup> result;
+    auto member = [](const Benchmark *benchmark, const std::string &label) {
+        return benchmark::detail::GroupMember{label, benchmark->name(), benchmark->results()};
+    };
+
+    for (size_t i = 0; groupDefinitions && i < groupDefinitions->size(); i++) {
+        benchmark::detail::BenchmarkGroup group;
+        group.name = (*groupDefinitions)[i].first;
+        for (auto &name : benchmark::detail::splitTypeList((*groupDefinitions)[i].second.c_str())) {
+            Benchmark *benchmark = find(name);
+            if (benchmark)
+                group.members.push_back(member(benchmark, name));
+            else
+                std::cerr << "Couldn't find benchmark '" << name << "' of group '" << group.name << "'\n";
+        }
+        if (!group.members.empty())
+            result.push_back(group);
+    }
+
+    for (size_t i = 0; benchmarks && i < benchmarks->size(); i++) {
+        const Benchmark *benchmark = (*benchmarks)[i];
+        if (benchmark->group().empty())
+            continue;
+        auto group = std::find_if(result.begin(), result.end(), [&](const benchmark::detail::BenchmarkGroup &g) {
+            return g.name == benchmark->group();
+        });
+        if (group == result.end()) {
+            result.push_back(benchmark::detail::BenchmarkGroup{benchmark->group(), {}});
+            group = result.end() - 1;
+        }
+        auto &members = group->members;
+        members.insert(benchmark->groupBaseline() ? members.begin() : members.end(),
+                       member(benchmark, benchmark->groupLabel()));
+    }
+    return result;
+}
+
+void BenchmarkSilo::printGroups() {
+    bool quiet = !benchmarks || benchmarks->empty() ||
+                 benchmarks->front()->setup().outputStyle == BenchmarkSetup::OutputStyle::Nothing;
+    if (quiet)
+        return;
+
+    for (auto &group : groups()) {
+        benchmark::detail::ComparisonTable table = benchmark::detail::groupTable(group);
+        if (!table.empty()) {
+            std::cout << "\n";
+            table.print(std::cout);
+        }
+    }
+}
+
+bool BenchmarkSilo::writeJson(const std::string &path) {
+    std::vector<benchmark::detail::BenchmarkResult> results;
+    for (size_t i = 0; benchmarks && i < benchmarks->size(); i++) {
+        auto &own = (*benchmarks)[i]->results();
+        results.insert(results.end(), own.begin(), own.end());
+    }
+    return benchmark::detail::writeJsonReport(path, results, groups());
+}
+
+int BenchmarkSilo::runAll(const BenchmarkSetup &setup) {
+    if (setup.historyQuery) {
+        if (setup.historyFile.empty())
+            return 1;
+        benchmark::detail::HistoryLog history(setup.historyFile);
+        return history.printQuery(std::cout, setup.historyFilter, setup.historyLast) ? 0 : 1;
+    }
+
+    std::unique_ptr<benchmark::detail::TraceWriter> trace;
+    if (!setup.traceFile.empty()) {
+        trace.reset(new benchmark::detail::TraceWriter(setup.traceFile));
+        trace->nameThread("benchmarks");
+    }
+
+    std::unique_ptr<benchmark::detail::SampleDump> dump;
+    if (!setup.dumpFile.empty()) {
+        dump.reset(new benchmark::detail::SampleDump(setup.dumpFile, setup.dumpCapacity));
+        if (!dump->isOpen())
+            dump.reset();
+    }
+
+    if (setup.coreLatency) {
+        bool registered = false;
+        for (size_t i = 0; benchmarks && i < benchmarks->size(); i++) {
+            registered = registered || dynamic_cast<CoreLatencyBenchmark *>((*benchmarks)[i]) != nullptr;
+        }
+        if (!registered)
+            registerBenchmark(new CoreLatencyBenchmark());
+    }
+
+    for (auto benchmark : *benchmarks) {
+        benchmark->setSetup(setup);
+        benchmark->setTrace(trace.get());
+        benchmark->setDump(dump.get());
+    }
+    int ret = setup.parallel ? runParallel(setup.partitionGranularity) : runAll();
+
+    if (dump) {
+        for (auto benchmark : *benchmarks) {
+            benchmark->setDump(nullptr);
+        }
+        uint64_t rows = dump->rows(), dropped = dump->dropped();
+        dump->close();
+        std::cout << rows << " samples dumped to '" << setup.dumpFile << "'";
+        if (dropped > 0)
+            std::cout << ", " << dropped << " didn't fit (--dumpCapacity)";
+        std::cout << std::endl;
+    }
+
+    if (trace) {
+        for (auto benchmark : *benchmarks) {
+            benchmark->setTrace(nullptr);
+        }
+        if (trace->save())
+            std::cout << "Trace saved to '" << setup.traceFile << "'" << std::endl;
+    }
+
+    if (!setup.jsonFile.empty() && writeJson(setup.jsonFile)) {
+        std::cout << "Results saved to '" << setup.jsonFile << "'" << std::endl;
+    }
+
+    if (!setup.historyFile.empty()) {
+        appendHistory(setup.historyFile);
+    }
+    return ret;
+}
+
+void BenchmarkSilo::appendHistory(const std::string &path) {
+    std::string revision = benchmark::detail::currentRevision();
+    uint64_t machine = benchmark::detail::machineFingerprint();
+    auto timestamp = (int64_t)std::time(nullptr);
+
+    std::vector<benchmark::detail::HistoryRecord> records;
+    for (auto benchmark : *benchmarks) {
+        for (auto &result : benchmark->results()) {
+            records.push_back(benchmark::detail::HistoryLog::makeRecord(result, revision, machine, timestamp));
+        }
+    }
+    if (benchmark::detail::HistoryLog(path).append(records))
+        std::cout << records.size() << " results of revision " << revision << " appended to '" << path << "'"
+                  << std::endl;
+}
+
+void BenchmarkSilo::deleteAll() {
+    for (auto benchmark : *benchmarks) {
+        delete benchmark;
+    }
+    delete benchmarks;
+}
+
+namespace benchmark {
+namespace detail {
+
+std::vector<std::string> splitTypeList(const char *types) {
+    std::vector<std::string> result;
+    std::string current;
+    int depth = 0;
+    for (const char *c = types; *c; c++) {
+        if (*c == '<' || *c == '(' || *c == '[') {
+            depth++;
+        } else if (*c == '>' || *c == ')' || *c == ']') {
+            depth--;
+        } else if (*c == ',' && depth == 0) {
+            result.push_back(current);
+            current.clear();
+            continue;
+        }
+        if (!current.empty() || *c != ' ')
+            current += *c;
+    }
+    result.push_back(current);
+
+    for (auto &type : result) {
+        while (!type.empty() && type.back() == ' ')
+            type.pop_back();
+    }
+    return result;
+}
+
+}} // namespaces
+
+CompareBenchmark::CompareBenchmark(const char *variants)
+    : Benchmark(title(benchmark::detail::splitTypeList(variants)).c_str())
+    , _variants(benchmark::detail::splitTypeList(variants)) {
+}
+
+std::string CompareBenchmark::title(const std::vector<std::string> &variants) {
+    std::string result;
+    for (auto &variant : variants)
+        result += (result.empty() ? "" : " vs ") + variant;
+    return result;
+}
+
+benchmark::duration_t CompareBenchmark::sample(Benchmark *variant, benchmark::detail::BenchmarkState &bs,
+                                               uint64_t &operations) {
+    benchmark::detail::RunState state(bs, timerCalibration().overhead);
+    state.setMemory(variant->memory());
+    state.setDatasets(&variant->datasets());
+    state.start();
+    variant->vsample(state);
+    state.stop();
+    variant->resetMemory();
+    operations = state.operations();
+    return state.getSample();
+}
+
+bool CompareBenchmark::nextCombination(Benchmark *variant, benchmark::detail::BenchmarkState &bs) {
+    while (bs.running()) {
+        if (bs.variableArgsMode())
+            bs.pickNextArgument();
+        variant->configureMemory(bs);
+        variant->datasets().beginBlock();
+
+        uint64_t operations = 0;
+        sample(variant, bs, operations); // dropped, it's the one that may add dimensions
+        if (!bs.needRestart())
+            return true;
+    }
+    return false;
+}
+
+bool CompareBenchmark::compares(const std::string &name) const {
+    return std::find(_variants.begin(), _variants.end(), name) != _variants.end();
+}
+
+void CompareBenchmark::vrun() {
+    std::vector<Benchmark *> variants;
+    for (auto &name : _variants) {
+        Benchmark *variant = BenchmarkSilo::find(name);
+        if (!variant) {
+            std::cerr << "BENCHMARK_COMPARE(" << _variants.front() << ", ...): no benchmark named '" << name << "'"
+                      << std::endl;
+            return;
+        }
+        variants.push_back(variant);
+    }
+    if (variants.size() < 2) {
+        std::cerr << "BENCHMARK_COMPARE(" << _variants.front() << "): nothing to compare it to" << std::endl;
+        return;
+    }
+
+    if (!setup().skipWarmup && benchmark::detail::isCPUScalingEnabled())
+        warmupCpu();
+    if (setpriority(PRIO_PROCESS, 0, -20) == -1)
+        out() << "Couldn't to set priority (code " << errno << "), try to run with administrator privileges" << std::endl;
+    calibrateTimer();
+
+    if (setup().outputStyle == BenchmarkSetup::OutputStyle::Full)
+        out() << "[Benchmark '" << name() << "'] started" << std::endl;
+
+    // variants with other arguments or lists than the first one stop at the shorter sweep
+    std::vector<benchmark::detail::BenchmarkState> states(variants.size());
+    for (uint64_t combination = 0;; combination++) {
+        for (size_t v = 0; v < variants.size(); v++) {
+            if (!nextCombination(variants[v], states[v])) {
+                // in reverse, each variant gives back the affinity the one before it left
+                for (auto variant = variants.rbegin(); variant != variants.rend(); ++variant) {
+                    (*variant)->datasets().clear();
+                    (*variant)->unpinBlock();
+                }
+                return;
+            }
+        }
+        measure(variants, states, combination);
+    }
+}
+
+void CompareBenchmark::measure(const std::vector<Benchmark *> &variants,
+                               std::vector<benchmark::detail::BenchmarkState> &states, uint64_t combination) {
+    size_t n = variants.size();
+    std::vector<std::vector<benchmark::duration_t>> samples(n);
+    std::vector<uint64_t> operations(n, 0);
+    std::vector<size_t> order(n);
+    for (size_t v = 0; v < n; v++)
+        order[v] = v;
+
+    benchmark::detail::FastRandom random(setup().bootstrap.seed + combination);
+    auto startTime = std::chrono::steady_clock::now();
+    for (unsigned round = 0; round < Rounds; round++) {
+        for (size_t v = n; v > 1; v--)
+            std::swap(order[v - 1], order[random.below((uint32_t)v)]);
+
+        for (size_t v : order) {
+            for (unsigned i = 0; i < BlockSize; i++)
+                samples[v].push_back(sample(variants[v], states[v], operations[v]));
+        }
+
+        // same pause as between the samples of run(), once per round here not to break up the blocks
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        if (std::chrono::steady_clock::now() - startTime > std::chrono::seconds(2) * (long)n)
+            break;
+        out() << ".";
+        out().flush();
+    }
+    out() << "\r";
+    out().flush();
+
+    std::vector<std::vector<double>> ns(n);
+    for (size_t v = 0; v < n; v++) {
+        for (auto &s : samples[v])
+            ns[v].push_back((double)std::chrono::duration_cast<std::chrono::nanoseconds>(s).count());
+    }
+
+    std::vector<benchmark::detail::BenchmarkResult> results;
+    std::vector<std::string> verdicts(n);
+    std::vector<benchmark::detail::PairedComparison> comparisons(n);
+    for (size_t v = 0; v < n; v++) {
+        TimeStatistics stats;
+        stats.setOutlierMethod(setup().outlierMethod);
+        stats.setBootstrap(setup().bootstrap);
+        for (auto &s : samples[v])
+            stats.addSample(s);
+        stats.calculate();
+
+        benchmark::detail::BenchmarkResult result{};
+        result.name = variants[v]->name();
+        result.hasArg = states[v].hasArgument();
+        result.arg = result.hasArg ? states[v].getArg() : 0;
+        result.iterations = (unsigned)samples[v].size();
+        result.operations = operations[v];
+        result.average = stats.averageTime();
+        result.median = stats.medianTime();
+        result.minimum = stats.minimalTime();
+        result.maximum = stats.maximalTime();
+        result.stdDev = stats.standardDeviation();
+        result.medianInterval = stats.medianInterval();
+        result.warmupTime = benchmark::duration_t(0);
+        result.memory = variants[v]->memory() ? variants[v]->memory()->description() : "";
+        result.datasets = variants[v]->datasets().used();
+        if (v > 0) {
+            comparisons[v] = benchmark::detail::comparePaired(ns[0], ns[v], setup().bootstrap.resamples,
+                                                              setup().bootstrap.confidence,
+                                                              setup().bootstrap.seed + combination);
+            verdicts[v] = benchmark::detail::comparisonVerdict(variants[0]->name(), variants[v]->name(),
+                                                               comparisons[v]);
+            result.comparison = verdicts[v];
+        }
+        variants[v]->addResult(result);
+        results.push_back(result);
+    }
+
+    if (setup().outputStyle != BenchmarkSetup::OutputStyle::Nothing)
+        print(variants, states, results, comparisons, verdicts);
+}
+
+void CompareBenchmark::print(const std::vector<Benchmark *> &variants,
+                             std::vector<benchmark::detail::BenchmarkState> &states,
+                             const std::vector<benchmark::detail::BenchmarkResult> &results,
+                             const std::vector<benchmark::detail::PairedComparison> &comparisons,
+                             const std::vector<std::string> &verdicts) {
+    out() << "[Benchmark '" << name() << "'";
+    if (states[0].hasArgument())
+        out() << " $1=" << states[0].getArg();
+    out() << "] " << results[0].iterations / BlockSize << " rounds of " << BlockSize
+          << " samples each, in random order\n";
+    for (size_t v = 0; v < variants.size(); v++) {
+        out() << "    " << variants[v]->sampleLabel(states[v]) << ": median "
+              << benchmark::io::DurationInterval{results[v].median, results[v].medianInterval} << "\n";
+    }
+    for (size_t v = 1; v < variants.size(); v++) {
+        const char *color = !benchmark::detail::significant(comparisons[v]) ? ""
+                            : comparisons[v].ratio > 1                      ? benchmark::detail::ColorLightGreen
+                                                                            : benchmark::detail::ColorRed;
+        out() << "    " << color << verdicts[v] << benchmark::detail::ColorReset << "\n";
+    }
+    out().flush();
+}
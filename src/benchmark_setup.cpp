@@ -0,0 +1,181 @@
+#include <benchmark/detail/benchmark_setup.h>
+#include <benchmark/detail/antagonist.h>
+#include <iostream>
+#include <sstream>
+
+BenchmarkSetup::BenchmarkSetup(int argc, const char **argv):
+    BenchmarkSetup()
+{
+    ProgramArguments args(argc, argv);
+
+    std::string outputStyle_ = args.after("output");
+    if (outputStyle_ == "full") {
+        outputStyle = OutputStyle::Full;
+    } else if (outputStyle_ == "oneline") {
+        outputStyle = OutputStyle::OneLine;
+    } else if (outputStyle_ == "table") {
+        outputStyle = OutputStyle::Table;
+    } else if (outputStyle_ == "nothing") {
+        outputStyle = OutputStyle::Nothing;
+    } else if (!outputStyle_.empty()) {
+        std::cerr << "Unexpected value of 'output' argument: " << outputStyle_ << std::endl;
+    }
+
+    verbose = args.contains("verbose");
+    skipWarmup = args.contains("skipWarmup");
+    skipSteadyState = args.contains("skipSteadyState");
+
+    std::string outliers_ = args.after("outliers");
+    if (outliers_ == "tukey") {
+        outlierMethod = TimeStatistics::OutliersTukey;
+    } else if (outliers_ == "mad") {
+        outlierMethod = TimeStatistics::OutliersMAD;
+    } else if (outliers_ == "none") {
+        outlierMethod = TimeStatistics::OutliersNone;
+    } else if (!outliers_.empty()) {
+        std::cerr << "Unexpected value of 'outliers' argument: " << outliers_ << std::endl;
+    }
+
+    std::string bootstrap_ = args.after("bootstrap");
+    if (bootstrap_ == "bca") {
+        bootstrap.method = benchmark::detail::BootstrapBCa;
+    } else if (bootstrap_ == "percentile") {
+        bootstrap.method = benchmark::detail::BootstrapPercentile;
+    } else if (bootstrap_ == "none") {
+        bootstrap.method = benchmark::detail::BootstrapNone;
+    } else if (!bootstrap_.empty()) {
+        std::cerr << "Unexpected value of 'bootstrap' argument: " << bootstrap_ << std::endl;
+    }
+
+    std::string resamples_ = args.after("resamples");
+    if (!resamples_.empty()) {
+        bootstrap.resamples = (unsigned)std::atoi(resamples_.c_str());
+    }
+
+    std::string confidence_ = args.after("confidence");
+    if (!confidence_.empty()) {
+        double confidence = std::atof(confidence_.c_str());
+        if (confidence > 0.0 && confidence < 1.0) {
+            bootstrap.confidence = confidence;
+        } else {
+            std::cerr << "Unexpected value of 'confidence' argument: " << confidence_ << std::endl;
+        }
+    }
+
+    traceFile = args.after("trace");
+    jsonFile = args.after("json");
+
+    dumpFile = args.after("dump");
+    std::string dumpCapacity_ = args.after("dumpCapacity");
+    if (!dumpCapacity_.empty()) {
+        long long capacity = std::atoll(dumpCapacity_.c_str());
+        if (capacity > 0) {
+            dumpCapacity = (uint64_t)capacity;
+        } else {
+            std::cerr << "Unexpected value of 'dumpCapacity' argument: " << dumpCapacity_ << std::endl;
+        }
+    }
+
+    parallel = args.contains("parallel");
+    std::string partition_ = args.after("partition");
+    if (partition_ == "core") {
+        partitionGranularity = benchmark::detail::PartitionCore;
+    } else if (partition_ == "l3") {
+        partitionGranularity = benchmark::detail::PartitionL3;
+    } else if (partition_ == "node") {
+        partitionGranularity = benchmark::detail::PartitionNode;
+    } else if (!partition_.empty()) {
+        std::cerr << "Unexpected value of 'partition' argument: " << partition_ << std::endl;
+    }
+
+    std::string numa_ = args.after("numa");
+    if (!numa_.empty()) {
+        int placement_ = benchmark::detail::parsePlacement(numa_);
+        if (placement_ >= 0) {
+            placement = placement_;
+        } else {
+            std::cerr << "Unexpected value of 'numa' argument: " << numa_ << std::endl;
+        }
+    }
+
+    std::string pages_ = args.after("pages");
+    if (!pages_.empty()) {
+        int backing_ = benchmark::detail::parseBacking(pages_);
+        if (backing_ >= 0) {
+            backing = backing_;
+        } else {
+            std::cerr << "Unexpected value of 'pages' argument: " << pages_ << std::endl;
+        }
+    }
+
+    coreLatency = args.contains("coreLatency");
+    energy = args.contains("energy");
+
+    std::string allocator_ = args.after("allocator");
+    if (!allocator_.empty()) {
+        int strategy = benchmark::detail::parseAllocatorStrategy(allocator_);
+        if (strategy >= 0) {
+            allocator = strategy;
+        } else {
+            std::cerr << "Unexpected value of 'allocator' argument: " << allocator_ << std::endl;
+        }
+    }
+
+    // comma separated, e.g. "llc,smt"
+    std::string antagonists_ = args.after("antagonists");
+    if (!antagonists_.empty()) {
+        std::istringstream ss(antagonists_);
+        std::string item;
+        while (std::getline(ss, item, ',')) {
+            int kind = benchmark::detail::parseAntagonist(item);
+            if (kind >= 0) {
+                antagonists.push_back(kind);
+            } else {
+                std::cerr << "Unexpected antagonist: " << item << std::endl;
+            }
+        }
+    }
+    antagonistCpus = benchmark::detail::parseCpuList(args.after("antagonistCpus"));
+
+    std::string layouts_ = args.after("layouts");
+    if (!layouts_.empty()) {
+        int count = std::atoi(layouts_.c_str());
+        if (count > 1) {
+            layouts = (unsigned)count;
+        } else {
+            std::cerr << "Unexpected value of 'layouts' argument: " << layouts_ << std::endl;
+        }
+    }
+
+    historyFile = args.after("history");
+    historyQuery = args.contains("historyQuery");
+    historyFilter = args.after("historyFilter");
+    std::string last_ = args.after("last");
+    if (!last_.empty()) {
+        int last = std::atoi(last_.c_str());
+        if (last > 0) {
+            historyLast = (unsigned)last;
+        } else {
+            std::cerr << "Unexpected value of 'last' argument: " << last_ << std::endl;
+        }
+    }
+    if (historyQuery && historyFile.empty()) {
+        std::cerr << "'historyQuery' needs a 'history' file" << std::endl;
+    }
+
+    // comma separated, e.g. "90,99"
+    std::string percentiles_ = args.after("percentiles");
+    if (!percentiles_.empty()) {
+        percentiles.clear();
+        std::istringstream ss(percentiles_);
+        std::string item;
+        while (std::getline(ss, item, ',')) {
+            int nth = std::atoi(item.c_str());
+            if (nth > 0 && nth <= 100) {
+                percentiles.push_back(nth);
+            } else {
+                std::cerr << "Unexpected percentile: " << item << std::endl;
+            }
+        }
+    }
+}
@@ -0,0 +1,212 @@
+#include <benchmark/detail/bootstrap.h>
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+namespace benchmark {
+namespace detail {
+
+double normalCdf(double x) {
+    return 0.5 * std::erfc(-x / std::sqrt(2.0));
+}
+
+double normalQuantile(double p) {
+    static const double a[] = {-3.969683028665376e+01, 2.209460984245205e+02, -2.759285104469687e+02,
+                               1.383577518672690e+02,  -3.066479806614716e+01, 2.506628277459239e+00};
+    static const double b[] = {-5.447609879822406e+01, 1.615858368580409e+02, -1.556989798598866e+02,
+                               6.680131188771972e+01,  -1.328068155288572e+01};
+    static const double c[] = {-7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00,
+                               -2.549671010322563e+00, 4.374664141464968e+00,  2.938163982698783e+00};
+    static const double d[] = {7.784695709041462e-03, 3.224671290700398e-01, 2.445134137142996e+00, 3.754408661907416e+00};
+
+    if (p <= 0.0)
+        return -HUGE_VAL;
+    if (p >= 1.0)
+        return HUGE_VAL;
+
+    if (p < 0.02425) {
+        double q = std::sqrt(-2.0 * std::log(p));
+        return (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+               ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1.0);
+    }
+    if (p > 1.0 - 0.02425) {
+        double q = std::sqrt(-2.0 * std::log(1.0 - p));
+        return -(((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+               ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1.0);
+    }
+    double q = p - 0.5;
+    double r = q * q;
+    return (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) * q /
+           (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1.0);
+}
+
+double Bootstrap::quantileOfSorted(const std::vector<double> &sorted, double q) {
+    double pos = q * (double)(sorted.size() - 1);
+    size_t lo = (size_t)pos;
+    if (lo + 1 >= sorted.size())
+        return sorted.back();
+    double frac = pos - (double)lo;
+    return sorted[lo] * (1.0 - frac) + sorted[lo + 1] * frac;
+}
+
+void Bootstrap::resampleRange(unsigned from, unsigned to, std::vector<double> &out) const {
+    const uint32_t n = (uint32_t)_sorted.size();
+    const size_t q = _quantiles.size();
+
+    FastRandom rnd(_settings.seed + from);
+    std::vector<uint32_t> counts(n);
+
+    std::vector<size_t> ranks(2 * q);
+    std::vector<double> fracs(q);
+    for (size_t k = 0; k < q; k++) {
+        double pos = _quantiles[k] * (double)(n - 1);
+        ranks[2 * k] = (size_t)pos;
+        ranks[2 * k + 1] = std::min((size_t)pos + 1, (size_t)n - 1);
+        fracs[k] = pos - (double)ranks[2 * k];
+    }
+    std::vector<size_t> order(2 * q); // rank slots by ascending rank, so one pass finds all of them
+    for (size_t k = 0; k < order.size(); k++) {
+        order[k] = k;
+    }
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return ranks[a] < ranks[b]; });
+    std::vector<double> rankValues(2 * q);
+
+    for (unsigned r = from; r < to; r++) {
+        std::fill(counts.begin(), counts.end(), 0u);
+        for (uint32_t i = 0; i < n; i++) {
+            counts[rnd.below(n)]++;
+        }
+
+        double sum = 0.0;
+        size_t cumulative = 0;
+        size_t next = 0;
+        for (uint32_t i = 0; i < n; i++) {
+            sum += (double)counts[i] * _sorted[i];
+            cumulative += counts[i];
+            while (next < order.size() && ranks[order[next]] < cumulative) {
+                rankValues[order[next]] = _sorted[i];
+                next++;
+            }
+        }
+
+        out[r] = sum / (double)n;
+        for (size_t k = 0; k < q; k++) {
+            out[(1 + k) * _settings.resamples + r] =
+                rankValues[2 * k] * (1.0 - fracs[k]) + rankValues[2 * k + 1] * fracs[k];
+        }
+    }
+}
+
+std::vector<double> Bootstrap::jackknife(size_t estimator) const {
+    const size_t n = _sorted.size();
+    std::vector<double> result(n);
+
+    if (estimator == 0) {
+        double sum = 0.0;
+        for (double v : _sorted) {
+            sum += v;
+        }
+        for (size_t i = 0; i < n; i++) {
+            result[i] = (sum - _sorted[i]) / (double)(n - 1);
+        }
+        return result;
+    }
+
+    double pos = _quantiles[estimator - 1] * (double)(n - 2);
+    size_t lo = (size_t)pos;
+    size_t hi = std::min(lo + 1, n - 2);
+    double frac = pos - (double)lo;
+    for (size_t i = 0; i < n; i++) {
+        double vlo = _sorted[lo < i ? lo : lo + 1];
+        double vhi = _sorted[hi < i ? hi : hi + 1];
+        result[i] = vlo * (1.0 - frac) + vhi * frac;
+    }
+    return result;
+}
+
+ConfidenceInterval Bootstrap::interval(size_t estimator, double estimate, double *boot) const {
+    const unsigned b = _settings.resamples;
+    std::sort(boot, boot + b);
+
+    double alpha = (1.0 - _settings.confidence) / 2.0;
+    double lowerP = alpha;
+    double upperP = 1.0 - alpha;
+
+    if (_settings.method == BootstrapBCa) {
+        size_t below = 0, ties = 0;
+        for (unsigned i = 0; i < b; i++) {
+            if (boot[i] < estimate) {
+                below++;
+            } else if (boot[i] == estimate) {
+                ties++;
+            }
+        }
+        double z0 = normalQuantile(((double)below + 0.5 * (double)ties) / (double)b);
+
+        std::vector<double> jack = jackknife(estimator);
+        double jackMean = 0.0;
+        for (double v : jack) {
+            jackMean += v;
+        }
+        jackMean /= (double)jack.size();
+        double num = 0.0, den = 0.0;
+        for (double v : jack) {
+            double d = jackMean - v;
+            num += d * d * d;
+            den += d * d;
+        }
+        double a = (den > 0.0) ? num / (6.0 * std::pow(den, 1.5)) : 0.0;
+
+        if (std::isfinite(z0)) {
+            auto adjust = [&](double p) {
+                double z = normalQuantile(p);
+                return normalCdf(z0 + (z0 + z) / (1.0 - a * (z0 + z)));
+            };
+            lowerP = adjust(lowerP);
+            upperP = adjust(upperP);
+        }
+    }
+
+    std::vector<double> sortedBoot(boot, boot + b);
+    return ConfidenceInterval{quantileOfSorted(sortedBoot, lowerP), quantileOfSorted(sortedBoot, upperP), true};
+}
+
+std::vector<ConfidenceInterval> Bootstrap::run() const {
+    std::vector<ConfidenceInterval> result(estimatorsCount(), ConfidenceInterval{0.0, 0.0, false});
+    if (_settings.method == BootstrapNone || _settings.resamples < 2 || _sorted.size() < 3)
+        return result;
+
+    const unsigned b = _settings.resamples;
+    std::vector<double> boot(estimatorsCount() * b);
+
+    // threads pay off only when there's enough work for them
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    double work = (double)b * (double)_sorted.size();
+    threads = std::min(threads, (unsigned)(work / 250000.0) + 1);
+    threads = std::min(threads, b);
+
+    if (threads == 1) {
+        resampleRange(0, b, boot);
+    } else {
+        std::vector<std::thread> workers;
+        for (unsigned t = 0; t < threads; t++) {
+            unsigned from = b * t / threads, to = b * (t + 1) / threads;
+            workers.emplace_back([this, from, to, &boot]() { resampleRange(from, to, boot); });
+        }
+        for (auto &worker : workers) {
+            worker.join();
+        }
+    }
+
+    double sum = 0.0;
+    for (double v : _sorted) {
+        sum += v;
+    }
+    result[0] = interval(0, sum / (double)_sorted.size(), &boot[0]);
+    for (size_t k = 0; k < _quantiles.size(); k++) {
+        result[1 + k] = interval(1 + k, quantileOfSorted(_sorted, _quantiles[k]), &boot[(1 + k) * b]);
+    }
+    return result;
+}
+
+}} //namespaces
@@ -0,0 +1,69 @@
+#include <benchmark/detail/calibration.h>
+#include <algorithm>
+#include <vector>
+#include <benchmark/detail/dont_optimize.h>
+#include <benchmark/detail/state.h>
+
+namespace benchmark {
+namespace detail {
+
+static duration_t medianOf(std::vector<duration_t> &v) {
+    std::nth_element(v.begin(), v.begin() + v.size() / 2, v.end());
+    return v[v.size() / 2];
+}
+
+// empty MEASURE, not inlined into the caller the same way testedFunc of a BENCHMARK isn't
+static void emptyMeasure(RunState &state) {
+    state.start();
+    int dummy = 0;
+    benchmark::DoNotOptimize(dummy);
+    state.stop();
+}
+
+TimerCalibration calibrateTimer() {
+    static const int ResolutionProbes = 200;
+    static const int OverheadProbes = 1000;
+
+    TimerCalibration result;
+
+    std::vector<duration_t> samples;
+    samples.reserve(OverheadProbes);
+
+    // clock's now() takes longer when called first time
+    auto init = clock_t::now();
+    benchmark::DoNotOptimize(init);
+
+    for (int i = 0; i < ResolutionProbes; i++) {
+        auto t0 = clock_t::now();
+        auto t1 = clock_t::now();
+        while (t1 == t0) {
+            t1 = clock_t::now();
+        }
+        samples.push_back(t1 - t0);
+    }
+    result.resolution = *std::min_element(samples.begin(), samples.end());
+
+    // exactly the way Benchmark::run() takes a sample
+    samples.clear();
+    void (*volatile func)(RunState &) = &emptyMeasure;
+    BenchmarkState bs;
+    for (int i = 0; i < OverheadProbes; i++) {
+        RunState state(bs, duration_t(0));
+        state.start();
+        func(state);
+        state.stop();
+        samples.push_back(state.getSample());
+    }
+    result.overheadMin = *std::min_element(samples.begin(), samples.end());
+    result.overheadMax = *std::max_element(samples.begin(), samples.end());
+    result.overhead = medianOf(samples);
+
+    for (auto &sample : samples) {
+        sample = (sample > result.overhead) ? sample - result.overhead : result.overhead - sample;
+    }
+    result.overheadSpread = std::chrono::duration_cast<duration_t>(medianOf(samples) * 1.4826);
+
+    return result;
+}
+
+}} //namespaces
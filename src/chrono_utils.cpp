@@ -0,0 +1,128 @@
+#include <benchmark/detail/chrono_utils.h>
+#include <cmath>
+#include <iomanip>
+#include <ostream>
+
+std::ostream& operator <<(std::ostream &os, benchmark::duration_t duration) {
+    auto durationNs = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+    auto durationMcs = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+    auto durationMs = std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
+    auto durationSec = std::chrono::duration_cast<std::chrono::seconds>(duration).count();
+    auto durationMin = std::chrono::duration_cast<std::chrono::minutes>(duration).count();
+
+    auto oldPrecision = os.precision();
+
+    if (durationNs < 1000) {
+        os << durationNs << " ns";
+    } else if (durationMcs < 10) {
+        os << std::setprecision(2) << (float) durationNs / 1000.0f << " μs";
+    } else if (durationMcs < 1000) {
+        os << durationMcs << " μs";
+    } else if (durationMs < 10) {
+        os << std::setprecision(2) << (float) durationMcs / 1000.0f << " ms";
+    } else if (durationMs < 1000) {
+        os << durationMs << " ms";
+    } else if (durationSec < 10) {
+        os << std::setprecision(2) << (float) durationMs / 1000.0f << " sec";
+    } else if (durationMin < 1) {
+        os << durationSec << " sec";
+    } else {
+        os << std::setprecision(2) << (float) durationSec / 60.0f << " min";
+    }
+    os << benchmark::detail::ColorReset << std::setprecision(oldPrecision);
+    return os;
+}
+
+std::ostream& operator <<(std::ostream &os, benchmark::io::DurationInterval v) {
+    os << v.duration;
+    if (!v.interval.valid)
+        return os;
+
+    // same unit choice as for a single duration above
+    auto durationNs = std::chrono::duration_cast<std::chrono::nanoseconds>(v.duration).count();
+    double divisor = 1.0;
+    int precision = 0;
+    if (durationNs < 1000) {
+    } else if (durationNs < 10000) {
+        divisor = 1e3, precision = 2;
+    } else if (durationNs < 1000000) {
+        divisor = 1e3;
+    } else if (durationNs < 10000000) {
+        divisor = 1e6, precision = 2;
+    } else if (durationNs < 1000000000) {
+        divisor = 1e6;
+    } else if (durationNs < 10000000000ll) {
+        divisor = 1e9, precision = 2;
+    } else if (durationNs < 60000000000ll) {
+        divisor = 1e9;
+    } else {
+        divisor = 60e9, precision = 2;
+    }
+
+    double nsPerTick = 1e9 * benchmark::duration_t::period::num / benchmark::duration_t::period::den;
+    auto oldPrecision = os.precision();
+    auto oldFlags = os.flags();
+    double lower = v.interval.lower * nsPerTick / divisor;
+    double upper = v.interval.upper * nsPerTick / divisor;
+    if (precision == 0) { // whole units are truncated, as above
+        lower = std::floor(lower);
+        upper = std::floor(upper);
+    }
+    os << std::fixed << std::setprecision(precision) << " [" << lower << ", " << upper << "]";
+    os.flags(oldFlags);
+    os << std::setprecision(oldPrecision);
+    return os;
+}
+
+std::ostream& operator <<(std::ostream &os, benchmark::io::ColoredDuration v) {
+    os << v.colorTag << v.duration << benchmark::detail::ColorReset;
+    return os;
+}
+
+std::ostream& operator <<(std::ostream &os, benchmark::io::Iterations v) {
+    auto oldPrecision = os.precision();
+
+    if (v.iterations < 1000) {
+        os << v.iterations;
+    } else if (v.iterations < 1000000) { // thousands
+        if (v.iterations % 1000 < 100) {
+            os << v.iterations / 1000 << "k";
+        } else {
+            os << std::setprecision(1) << (float) v.iterations / 1000.0f << "k";
+        }
+    } else { // millions
+        os << std::setprecision(1) << (float) v.iterations / 1000000.0f << "m";
+    }
+    os << std::setprecision(oldPrecision);
+    return os;
+}
+
+std::ostream& operator <<(std::ostream &os, std::unique_ptr<benchmark::detail::CPULoadResult> &cpuLoad) {
+    for (int i = 0; i < cpuLoad->numCores; i++) {
+        float loadRel = cpuLoad->loadByCore[i];
+
+        benchmark::detail::ColorTag color = benchmark::detail::selectColorForCPULoad(loadRel);
+        os << "[Core " << i << ": " << color << (int) (loadRel * 100.0f) << "%"
+                  << benchmark::detail::ColorReset << "] ";
+
+        if (i % 4 == 0 && i > 0) // split by a column
+            os << "\n";
+    }
+    os << "\n";
+    for (int i = 0; i < cpuLoad->numCores; i++) {
+        int curFreq = cpuLoad->freqByCore[i].curFreq;
+        int maxFreq = cpuLoad->freqByCore[i].maxFreq;
+
+        float freqRel = 0.0f;
+        if (curFreq > 0 && maxFreq > 0)
+            freqRel = (float) curFreq / (float) maxFreq;
+
+        benchmark::detail::ColorTag color = benchmark::detail::selectColorForCPUFreq(freqRel);
+        os << "[Freq " << i << ": " << color << (int) (freqRel * 100.0f) << "%"
+                  << benchmark::detail::ColorReset << "] ";
+
+        if (i % 4 == 0 && i > 0) // split by a column
+            os << "\n";
+    }
+    return os;
+}
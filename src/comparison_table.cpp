@@ -0,0 +1,172 @@
+#include <benchmark/detail/comparison_table.h>
+#include <algorithm>
+#include <cstdio>
+#include <ostream>
+#include <sstream>
+#include <benchmark/detail/chrono_utils.h>
+#include <benchmark/detail/colorization.h>
+
+namespace benchmark {
+namespace detail {
+
+size_t visibleLength(const std::string &text) {
+    size_t length = 0;
+    for (size_t i = 0; i < text.size(); i++) {
+        if (text[i] == '\x1B') {
+            while (i < text.size() && text[i] != 'm')
+                i++;
+            continue;
+        }
+        if (((unsigned char)text[i] & 0xC0) != 0x80)
+            length++;
+    }
+    return length;
+}
+
+std::string rowName(const BenchmarkResult &result) {
+    std::string row = result.hasArg ? "$1=" + std::to_string(result.arg) : "-";
+    if (!result.antagonist.empty())
+        row += " " + result.antagonist;
+    if (!result.layout.empty())
+        row += " " + result.layout.substr(0, result.layout.find(" (")); // "layout 3", the offsets are in the results
+    return row;
+}
+
+double speedup(const BenchmarkResult &baseline, const BenchmarkResult &result) {
+    if (baseline.median.count() <= 0 || result.median.count() <= 0)
+        return 0.0;
+    return (double)baseline.median.count() / result.median.count();
+}
+
+int significance(const BenchmarkResult &baseline, const BenchmarkResult &result) {
+    const ConfidenceInterval &a = result.medianInterval, &b = baseline.medianInterval;
+    if (!a.valid || !b.valid)
+        return 0;
+    return a.upper < b.lower ? 1 : a.lower > b.upper ? -1 : 0;
+}
+
+std::vector<std::string> BenchmarkGroup::rows() const {
+    std::vector<std::string> result;
+    for (auto &member : members) {
+        for (auto &r : member.results) {
+            std::string row = rowName(r);
+            if (std::find(result.begin(), result.end(), row) == result.end())
+                result.push_back(row);
+        }
+    }
+    return result;
+}
+
+const BenchmarkResult *BenchmarkGroup::find(size_t member, const std::string &row) const {
+    for (auto &result : members[member].results) {
+        if (rowName(result) == row)
+            return &result;
+    }
+    return nullptr;
+}
+
+size_t ComparisonTable::rowIndex(const std::string &row) {
+    auto i = std::find(_rows.begin(), _rows.end(), row);
+    if (i != _rows.end())
+        return i - _rows.begin();
+
+    _rows.push_back(row);
+    _cells.push_back(std::vector<std::string>(_columns.size()));
+    return _rows.size() - 1;
+}
+
+size_t ComparisonTable::addColumn(const std::string &column) {
+    _columns.push_back(column);
+    for (auto &cells : _cells) {
+        cells.resize(_columns.size());
+    }
+    return _columns.size() - 1;
+}
+
+size_t ComparisonTable::column(const std::string &name) {
+    auto i = std::find(_columns.begin(), _columns.end(), name);
+    return i != _columns.end() ? (size_t)(i - _columns.begin()) : addColumn(name);
+}
+
+void ComparisonTable::addResult(size_t column, const BenchmarkResult &result) {
+    std::ostringstream cell;
+    cell << result.median;
+    addCell(column, rowName(result), cell.str());
+}
+
+void ComparisonTable::addCell(size_t column, const std::string &row, const std::string &text) {
+    _cells[rowIndex(row)][column] = text;
+}
+
+void ComparisonTable::print(std::ostream &os) const {
+    std::vector<size_t> widths;
+    size_t firstWidth = _title.size();
+    for (auto &row : _rows) {
+        firstWidth = std::max(firstWidth, row.size());
+    }
+    for (size_t c = 0; c < _columns.size(); c++) {
+        size_t width = visibleLength(_columns[c]);
+        for (auto &cells : _cells) {
+            width = std::max(width, visibleLength(cells[c]));
+        }
+        widths.push_back(width);
+    }
+
+    auto pad = [&](size_t n) {
+        for (size_t i = 0; i < n; i++)
+            os << ' ';
+    };
+
+    os << _title;
+    pad(firstWidth - _title.size());
+    for (size_t c = 0; c < _columns.size(); c++) {
+        pad(widths[c] + 2 - visibleLength(_columns[c]));
+        os << _columns[c];
+    }
+    os << "\n";
+
+    for (size_t r = 0; r < _rows.size(); r++) {
+        os << _rows[r];
+        pad(firstWidth - _rows[r].size());
+        for (size_t c = 0; c < _columns.size(); c++) {
+            pad(widths[c] + 2 - visibleLength(_cells[r][c]));
+            os << _cells[r][c];
+        }
+        os << "\n";
+    }
+    os << ColorReset;
+    os.flush();
+}
+
+ComparisonTable groupTable(const BenchmarkGroup &group) {
+    ComparisonTable table(group.name);
+    for (size_t m = 0; m < group.members.size(); m++) {
+        table.addColumn(m == 0 && group.members.size() > 1 ? group.members[m].label + " (baseline)"
+                                                           : group.members[m].label);
+    }
+
+    for (auto &row : group.rows()) {
+        const BenchmarkResult *base = group.find(0, row);
+        for (size_t m = 0; m < group.members.size(); m++) {
+            const BenchmarkResult *result = group.find(m, row);
+            if (!result)
+                continue;
+
+            std::ostringstream cell;
+            double times = base && m > 0 ? speedup(*base, *result) : 0.0;
+            if (times > 0.0) {
+                int verdict = significance(*base, *result);
+                char text[32];
+                std::snprintf(text, sizeof(text), "%.2fx", times);
+                cell << (verdict > 0 ? ColorLightGreen : verdict < 0 ? ColorRed : "") << result->median << " ("
+                     << text << ")" << ColorReset;
+            } else {
+                cell << result->median;
+            }
+            table.addCell(m, row, cell.str());
+        }
+    }
+    return table;
+}
+
+}} //namespaces
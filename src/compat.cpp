@@ -0,0 +1,170 @@
+#include <benchmark/compat.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <regex>
+#include <benchmark/detail/colorization.h>
+
+namespace benchmark {
+namespace internal {
+
+std::vector<int64_t> rangeValues(int64_t lo, int64_t hi, int multiplier) {
+    std::vector<int64_t> result{lo};
+    if (hi <= lo)
+        return result;
+    for (int64_t value = 1; value < hi; value *= multiplier) {
+        if (value > lo)
+            result.push_back(value);
+        if (multiplier < 2)
+            break;
+    }
+    result.push_back(hi);
+    return result;
+}
+
+std::string Benchmark::instanceName(const std::vector<int64_t> &args) const {
+    std::string result = _name;
+    for (size_t i = 0; i < args.size(); i++) {
+        result += "/";
+        if (i < _argNames.size() && !_argNames[i].empty())
+            result += _argNames[i] + ":";
+        result += std::to_string(args[i]);
+    }
+    return result;
+}
+
+std::vector<std::unique_ptr<Benchmark>> &registrations() {
+    static std::vector<std::unique_ptr<Benchmark>> result;
+    return result;
+}
+
+Benchmark *registerBenchmark(const std::string &name, Function function) {
+    registrations().emplace_back(new Benchmark(name, std::move(function)));
+    return registrations().back().get();
+}
+
+CompatBenchmark::CompatBenchmark(const std::string &name, Function function, std::vector<int64_t> args,
+                                 IterationCount iterations)
+    : ::Benchmark(name.c_str())
+    , _function(std::move(function))
+    , _args(std::move(args))
+    , _iterations(iterations) {
+}
+
+duration_t CompatBenchmark::measureOnce(IterationCount iterations) {
+    detail::BenchmarkState bs;
+    detail::RunState run(bs, duration_t(0));
+    State state(&run, _args, iterations);
+    _function(state);
+    if (state.skipped()) {
+        _message = state.message();
+        return duration_t(0);
+    }
+    return run.getSample();
+}
+
+IterationCount CompatBenchmark::calibrate() {
+    const double SampleTime = 1e-3;
+    const IterationCount MaxIterations = 1000000000;
+
+    IterationCount iterations = 1;
+    while (true) {
+        double seconds = std::chrono::duration<double>(measureOnce(iterations)).count();
+        if (!_message.empty() || seconds >= SampleTime || iterations >= MaxIterations)
+            return iterations;
+        double factor = seconds > 0 ? std::min(10.0, 1.4 * SampleTime / seconds) : 10.0;
+        iterations = std::min(MaxIterations, std::max(iterations + 1, (IterationCount)((double)iterations * factor)));
+    }
+}
+
+void CompatBenchmark::vrun() {
+    _message.clear();
+    IterationCount iterations = _iterations > 0 ? _iterations : calibrate();
+    if (!_message.empty()) {
+        if (setup().outputStyle != BenchmarkSetup::OutputStyle::Nothing)
+            out() << "[Benchmark '" << name() << "'] skipped: " << _message << std::endl;
+        return;
+    }
+
+    run([&](detail::RunState &run) {
+        State state(&run, _args, iterations);
+        _function(state);
+        // items are the operations when the benchmark counts them, the time per item on the "Per op" line
+        run.setOperations((uint64_t)(state.items_processed() > 0 ? state.items_processed() : state.iterations()));
+        if (state.bytes_processed() > 0)
+            run.setBytes((uint64_t)state.bytes_processed());
+
+        double seconds = std::chrono::duration<double>(run.getSample()).count();
+        for (auto &counter : state.counters)
+            run.setCounter(counter.first, counter.second.finalValue(state.iterations(), seconds));
+        if (state.bytes_processed() > 0 && seconds > 0)
+            run.setCounter("bytes_per_second", (double)state.bytes_processed() / seconds);
+        if (state.items_processed() > 0 && seconds > 0)
+            run.setCounter("items_per_second", (double)state.items_processed() / seconds);
+        if (state.skipped())
+            _message = state.message();
+        _label = state.label();
+    });
+
+    if (setup().outputStyle == BenchmarkSetup::OutputStyle::Nothing)
+        return;
+    if (!_label.empty())
+        out() << "    " << _label << std::endl;
+    if (!_message.empty())
+        out() << detail::ColorLightRed << "    Warning: skipped in a sample: " << _message << detail::ColorReset
+              << std::endl;
+}
+
+BenchmarkSetup &compatSetup() {
+    static BenchmarkSetup setup;
+    return setup;
+}
+
+std::string &compatFilter() {
+    static std::string filter;
+    return filter;
+}
+
+} // namespace internal
+
+void Initialize(int *argc, char **argv) {
+    int kept = 1;
+    for (int i = 1; i < *argc; i++) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 19, "--benchmark_filter=") == 0)
+            internal::compatFilter() = arg.substr(19);
+        else if (arg.compare(0, 12, "--benchmark_") != 0)
+            argv[kept++] = argv[i];
+    }
+    *argc = kept;
+    internal::compatSetup() = BenchmarkSetup(*argc, (const char **)argv);
+}
+
+bool ReportUnrecognizedArguments(int, char **) {
+    return false;
+}
+
+size_t RunSpecifiedBenchmarks() {
+    std::regex filter(internal::compatFilter().empty() ? ".*" : internal::compatFilter());
+    size_t count = 0;
+    for (auto &registration : internal::registrations()) {
+        for (auto &args : registration->args()) {
+            std::string name = registration->instanceName(args);
+            if (!std::regex_search(name, filter))
+                continue;
+            BenchmarkSilo::registerBenchmark(
+                new internal::CompatBenchmark(name, registration->function(), args, registration->iterations()));
+            count++;
+        }
+    }
+    if (count > 0)
+        BenchmarkSilo::runAll(internal::compatSetup());
+    return count;
+}
+
+void Shutdown() {
+    BenchmarkSilo::deleteAll();
+    internal::registrations().clear();
+}
+
+} // namespace benchmark
@@ -0,0 +1,175 @@
+#include <benchmark/detail/core_latency.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+namespace benchmark {
+namespace detail {
+
+bool pingPong(int cpuA, int cpuB, unsigned rounds, unsigned roundTrips, std::vector<double> &oneWay) {
+    struct alignas(64) Line {
+        std::atomic<uint64_t> value{0};
+    };
+    Line line;
+    std::atomic<int> ready{0};
+    std::atomic<bool> failed{false};
+    uint64_t last = 2ull * rounds * roundTrips;
+
+    std::thread responder([&]() {
+        if (!pinCurrentThread(cpuB))
+            failed = true;
+        ready++;
+        if (failed)
+            return;
+        for (uint64_t expected = 1; expected < last; expected += 2) {
+            while (line.value.load(std::memory_order_acquire) != expected) {
+                if (failed.load(std::memory_order_relaxed))
+                    return;
+            }
+            line.value.store(expected + 1, std::memory_order_release);
+        }
+    });
+
+    std::thread initiator([&]() {
+        if (!pinCurrentThread(cpuA))
+            failed = true;
+        while (ready.load() == 0) {
+        }
+        if (failed)
+            return;
+
+        uint64_t next = 1;
+        for (unsigned round = 0; round < rounds; round++) {
+            auto start = clock_t::now();
+            for (unsigned trip = 0; trip < roundTrips; trip++, next += 2) {
+                line.value.store(next, std::memory_order_release);
+                while (line.value.load(std::memory_order_acquire) != next + 1) {
+                }
+            }
+            auto elapsed = std::chrono::duration<double, std::nano>(clock_t::now() - start).count();
+            oneWay.push_back(elapsed / (2.0 * roundTrips));
+        }
+    });
+
+    initiator.join();
+    responder.join();
+    return !failed;
+}
+
+CoreLatencySample summarize(std::vector<double> values) {
+    CoreLatencySample result{NAN, NAN, NAN, NAN, NAN};
+    if (values.empty())
+        return result;
+
+    std::sort(values.begin(), values.end());
+    size_t n = values.size();
+    result.median = n % 2 ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2;
+    result.minimum = values.front();
+    result.maximum = values.back();
+    double sum = 0, squares = 0;
+    for (double v : values)
+        sum += v;
+    result.average = sum / n;
+    for (double v : values)
+        squares += (v - result.average) * (v - result.average);
+    result.stdDev = n > 1 ? std::sqrt(squares / (n - 1)) : 0;
+    return result;
+}
+
+CoreRelation coreRelation(const LogicalCpu &a, const LogicalCpu &b) {
+    if (a.core == b.core)
+        return RelationSMT;
+    if (a.l3 == b.l3)
+        return RelationL3;
+    if (a.package == b.package)
+        return RelationSocket;
+    return RelationRemote;
+}
+
+const char *relationName(int relation) {
+    static const char *names[] = {"SMT siblings", "shared L3", "same socket", "cross socket"};
+    return names[relation];
+}
+
+std::vector<LatencyLevel> CoreLatencyMatrix::levels(double gap) const {
+    std::vector<double> sorted;
+    for (size_t a = 0; a < cpus.size(); a++) {
+        for (size_t b = a + 1; b < cpus.size(); b++) {
+            if (!std::isnan(at(a, b)))
+                sorted.push_back(at(a, b));
+        }
+    }
+    std::sort(sorted.begin(), sorted.end());
+
+    std::vector<LatencyLevel> result;
+    for (size_t i = 0; i + 1 < sorted.size(); i++) {
+        if (sorted[i + 1] <= sorted[i] * gap)
+            continue;
+
+        // connected components of the pairs up to the threshold
+        std::vector<size_t> component(cpus.size());
+        for (size_t c = 0; c < component.size(); c++)
+            component[c] = c;
+        auto root = [&](size_t c) {
+            while (component[c] != c)
+                c = component[c] = component[component[c]];
+            return c;
+        };
+        for (size_t a = 0; a < cpus.size(); a++) {
+            for (size_t b = a + 1; b < cpus.size(); b++) {
+                if (at(a, b) <= sorted[i])
+                    component[root(a)] = root(b);
+            }
+        }
+
+        LatencyLevel level{sorted[i], {}};
+        std::vector<size_t> roots;
+        for (size_t c = 0; c < cpus.size(); c++) {
+            size_t r = root(c);
+            size_t index = (size_t)(std::find(roots.begin(), roots.end(), r) - roots.begin());
+            if (index == roots.size()) {
+                roots.push_back(r);
+                level.clusters.push_back({});
+            }
+            level.clusters[index].push_back(cpus[c].cpu);
+        }
+        result.push_back(level);
+    }
+    return result;
+}
+
+std::vector<CoreLatencySample> CoreLatencyMatrix::byRelation() const {
+    std::vector<std::vector<double>> values(RelationRemote + 1);
+    for (size_t a = 0; a < cpus.size(); a++) {
+        for (size_t b = a + 1; b < cpus.size(); b++) {
+            if (!std::isnan(at(a, b)))
+                values[coreRelation(cpus[a], cpus[b])].push_back(at(a, b));
+        }
+    }
+    std::vector<CoreLatencySample> result;
+    for (auto &relation : values)
+        result.push_back(summarize(relation));
+    return result;
+}
+
+CoreLatencyMatrix measureCoreLatency(const std::vector<LogicalCpu> &cpus, unsigned rounds,
+                                      unsigned roundTrips) {
+    CoreLatencyMatrix result;
+    result.cpus = cpus;
+    CoreLatencySample none{NAN, NAN, NAN, NAN, NAN};
+    result.samples.assign(cpus.size(), std::vector<CoreLatencySample>(cpus.size(), none));
+
+    for (size_t a = 0; a < cpus.size(); a++) {
+        for (size_t b = a + 1; b < cpus.size(); b++) {
+            std::vector<double> oneWay;
+            if (!pingPong(cpus[a].cpu, cpus[b].cpu, rounds, roundTrips, oneWay))
+                continue;
+            result.samples[a][b] = result.samples[b][a] = summarize(oneWay);
+        }
+    }
+    return result;
+}
+
+}} //namespaces
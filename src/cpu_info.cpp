@@ -0,0 +1,262 @@
+#include <benchmark/detail/cpu_info.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+#ifndef WIN32
+#include <sched.h>
+#endif
+
+namespace benchmark {
+namespace detail {
+
+int getCPUCoresNum() {
+    int cpuCores = 0;
+
+#ifdef WIN32
+    return 1;
+#else
+    // open '/proc/cpuinfo' and count 'processor' word
+    FILE *fh = std::fopen("/proc/cpuinfo", "rb");
+    if (!fh)
+        return 1;
+
+    static const int BufSize = 1000;
+    char *buf = (char *)std::malloc(BufSize);
+
+    while (true) {
+        if (!std::fgets(buf, BufSize, fh))
+            break;
+
+        if (std::strstr(buf, "processor")) {
+            cpuCores++;
+        }
+    }
+    std::fclose(fh);
+    std::free(buf);
+
+    if (cpuCores == 0)
+        return 1;
+
+    return cpuCores;
+#endif
+}
+
+std::string getFileText(const std::string &filePath) {
+    static const int BufSize = 256;
+    char buf[BufSize];
+
+    FILE *fh = std::fopen(filePath.c_str(), "r");
+    if (!fh) {
+        std::cerr << "Couldn't open '" << filePath << "'\n";
+        return "";
+    }
+
+    char *fresult = std::fgets(buf, BufSize, fh);
+    if (!fresult) {
+        std::fclose(fh);
+        std::cerr << "Couldn't read from '" << filePath << "'\n";
+        return "";
+    }
+    std::fclose(fh);
+
+    return std::string(buf);
+}
+
+bool isCPUScalingEnabled() {
+#ifdef WIN32
+    return false;
+#else
+    int coresNum = getCPUCoresNum();
+
+    for (int i = 0; i < coresNum; i++) {
+        std::string governorPath = "/sys/devices/system/cpu/cpu";
+        governorPath += std::to_string(i);
+        governorPath += "/cpufreq/scaling_governor";
+
+        std::string governorText = getFileText(governorPath);
+        if (governorText != "performance\n" &&
+            governorText != "performance") {
+            return true;
+        }
+    }
+
+    return false;
+#endif
+}
+
+std::vector<CoreFrequency> readCPUFreqs() {
+#ifdef WIN32
+    return std::vector<CoreFrequency>();
+#else
+    int coresNum = getCPUCoresNum();
+    std::vector<CoreFrequency> result;
+
+    for (int i = 0; i < coresNum; i++) {
+        std::string cpuPath = "/sys/devices/system/cpu/cpu";
+        cpuPath += std::to_string(i);
+        cpuPath += "/cpufreq/";
+
+        std::string curFreqText = getFileText(cpuPath + "scaling_cur_freq");
+        std::string maxFreqText = getFileText(cpuPath + "cpuinfo_max_freq");
+
+        result.push_back({std::atoi(curFreqText.c_str()), std::atoi(maxFreqText.c_str())});
+    }
+
+    return result;
+#endif
+}
+
+int getCurrentCore() {
+#if defined(__linux__)
+    return sched_getcpu();
+#else
+    return -1;
+#endif
+}
+
+int readCoreFrequency(int core) {
+#ifdef WIN32
+    return 0;
+#else
+    if (core < 0)
+        return 0;
+
+    char path[128];
+    std::snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cpufreq/scaling_cur_freq", core);
+    FILE *fh = std::fopen(path, "r");
+    if (!fh)
+        return 0;
+
+    char buf[32];
+    int result = 0;
+    if (std::fgets(buf, sizeof(buf), fh))
+        result = std::atoi(buf);
+    std::fclose(fh);
+    return result;
+#endif
+}
+
+std::unique_ptr<CPUStats> readCPUStats() {
+    std::ifstream ifs("/proc/stat");
+
+    std::unique_ptr<CPUStats> result{ new CPUStats{} };
+
+    std::string line;
+    while (std::getline(ifs, line)) {
+        if (!line.compare(0, 3, "cpu")) {
+            std::istringstream ss(line);
+            std::string cpuLabel;
+            ss >> cpuLabel;
+
+            if (cpuLabel == "cpu") // total stats, skip
+                continue;
+
+            result->statsByCore.push_back({});
+            CPUCoreStats &coreStats = result->statsByCore.back();
+
+            for (size_t i = 0; i < NumStates; ++i)
+                ss >> coreStats.timeSample[i];
+        }
+    }
+
+    return result;
+}
+
+float getTotalCPULoad(const CPUStats &s1, const CPUStats &s2) {
+    size_t loadTimeD = 0, totalTimeD = 0;
+    for (size_t i = 0; i < s1.statsByCore.size() && i < s2.statsByCore.size(); i++) {
+        size_t load = s2.statsByCore[i].loadTime() - s1.statsByCore[i].loadTime();
+        loadTimeD += load;
+        totalTimeD += load + s2.statsByCore[i].idleTime() - s1.statsByCore[i].idleTime();
+    }
+    return totalTimeD ? (float)loadTimeD / (float)totalTimeD : 0.0f;
+}
+
+std::vector<RaplDomain> readRaplDomains(const std::string &root) {
+    std::vector<RaplDomain> result;
+#if defined(__linux__)
+    auto readLine = [](const std::string &path, std::string &text) {
+        FILE *fh = std::fopen(path.c_str(), "r");
+        if (!fh)
+            return false;
+        char buf[128];
+        bool ok = std::fgets(buf, sizeof(buf), fh) != nullptr;
+        std::fclose(fh);
+        text = ok ? buf : "";
+        while (!text.empty() && (text.back() == '\n' || text.back() == ' '))
+            text.pop_back();
+        return ok;
+    };
+
+    // intel-rapl:0 is package 0, intel-rapl:0:1 a subzone of it (core, uncore, dram)
+    for (int zone = 0; zone < 64; zone++) {
+        std::string zonePath = root + "/intel-rapl:" + std::to_string(zone);
+        std::string zoneName;
+        if (!readLine(zonePath + "/name", zoneName))
+            break;
+
+        for (int sub = -1; sub < 16; sub++) {
+            std::string path = sub < 0 ? zonePath : zonePath + "/intel-rapl:" + std::to_string(zone) + ":" + std::to_string(sub);
+            std::string name, energy, range;
+            if (!readLine(path + "/name", name)) {
+                if (sub < 0)
+                    continue;
+                break;
+            }
+            if (!readLine(path + "/energy_uj", energy) || !readLine(path + "/max_energy_range_uj", range))
+                continue; // energy_uj is root-only on recent kernels
+            result.push_back(RaplDomain{sub < 0 ? name : zoneName + "/" + name, path + "/energy_uj",
+                                        std::strtoull(range.c_str(), nullptr, 10)});
+        }
+    }
+#else
+    (void)root;
+#endif
+    return result;
+}
+
+bool readRaplEnergy(const RaplDomain &domain, uint64_t &microjoules) {
+    FILE *fh = std::fopen(domain.energyPath.c_str(), "r");
+    if (!fh)
+        return false;
+    char buf[32];
+    bool ok = std::fgets(buf, sizeof(buf), fh) != nullptr;
+    std::fclose(fh);
+    if (ok)
+        microjoules = std::strtoull(buf, nullptr, 10);
+    return ok;
+}
+
+std::unique_ptr<CPULoadResult> getCPULoad() {
+    int cores = getCPUCoresNum();
+
+    std::unique_ptr<CPUStats> s1 = readCPUStats();
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    std::unique_ptr<CPUStats> s2 = readCPUStats();
+
+    std::vector<CoreFrequency> freqs = readCPUFreqs();
+
+    std::unique_ptr<CPULoadResult> result{ new CPULoadResult{} };
+    result->numCores = cores;
+
+    for (int i = 0; i < cores; i++) {
+        size_t loadTimeD = s2->statsByCore[i].loadTime() - s1->statsByCore[i].loadTime();
+        size_t idleTimeD = s2->statsByCore[i].idleTime() - s1->statsByCore[i].idleTime();
+        size_t totalTimeD = loadTimeD + idleTimeD;
+        result->loadByCore.push_back((float)loadTimeD / (float)totalTimeD);
+
+        int curFreq = freqs.empty() ? 0 : freqs[i].curFreq;
+        int maxFreq = freqs.empty() ? 0 : freqs[i].maxFreq;
+        result->freqByCore.push_back({curFreq, maxFreq});
+    }
+
+    return result;
+}
+
+}} //namespaces
@@ -0,0 +1,124 @@
+#include <benchmark/detail/dataset.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace benchmark {
+namespace data {
+
+std::string formatParameter(double value) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%g", value);
+    return buf;
+}
+
+std::string Uniform::description() const {
+    return "uniform(n=" + std::to_string(n) + ", min=" + std::to_string(min) + ", max=" + std::to_string(max) +
+           ", seed=" + std::to_string(seed) + ")";
+}
+
+Uniform::result_type Uniform::generate() const {
+    SplitMix64 random(seed);
+    result_type result(n);
+    uint64_t range = max - min;
+    for (auto &value : result)
+        value = range == UINT64_MAX ? random.next() : min + random.nextBelow(range + 1);
+    return result;
+}
+
+std::string Zipf::description() const {
+    return "zipf(n=" + std::to_string(n) + ", s=" + formatParameter(s) + ", universe=" + std::to_string(universe) +
+           ", seed=" + std::to_string(seed) + ")";
+}
+
+Zipf::result_type Zipf::generate() const {
+    std::vector<double> cdf(std::max(universe, (size_t)1));
+    double sum = 0;
+    for (size_t k = 0; k < cdf.size(); k++) {
+        sum += 1.0 / std::pow((double)(k + 1), s);
+        cdf[k] = sum;
+    }
+
+    SplitMix64 random(seed);
+    result_type result(n);
+    for (auto &value : result) {
+        double u = random.nextDouble() * sum;
+        size_t rank = (size_t)(std::upper_bound(cdf.begin(), cdf.end(), u) - cdf.begin());
+        value = scramble(seed + std::min(rank, cdf.size() - 1));
+    }
+    return result;
+}
+
+std::string Ordered::description() const {
+    static const char *names[] = {"sorted", "reversed", "nearly sorted"};
+    std::string result = std::string(names[order]) + "(n=" + std::to_string(n);
+    if (order == OrderNearlySorted)
+        result += ", swapped=" + formatParameter(swapped);
+    return result + ", seed=" + std::to_string(seed) + ")";
+}
+
+Ordered::result_type Ordered::generate() const {
+    result_type result = Uniform(n, 0, UINT64_MAX, seed).generate();
+    std::sort(result.begin(), result.end());
+    if (order == OrderReversed) {
+        std::reverse(result.begin(), result.end());
+    } else if (order == OrderNearlySorted && n > 1) {
+        SplitMix64 random(scramble(seed));
+        size_t swaps = (size_t)(swapped * (double)n / 2);
+        for (size_t i = 0; i < swaps; i++)
+            std::swap(result[random.nextBelow(n)], result[random.nextBelow(n)]);
+    }
+    return result;
+}
+
+std::string Strings::description() const {
+    return "strings(n=" + std::to_string(n) + ", length " + std::to_string(minLength) + ".." +
+           std::to_string(maxLength) + (lengths == LengthGeometric ? " geometric" : " uniform") +
+           ", seed=" + std::to_string(seed) + ")";
+}
+
+Strings::result_type Strings::generate() const {
+    SplitMix64 random(seed);
+    double mean = (double)(maxLength - minLength) / 2;
+    result_type result(n);
+    for (auto &text : result) {
+        size_t length;
+        if (lengths == LengthGeometric && mean > 0) {
+            double u = random.nextDouble();
+            length = minLength + (size_t)(std::log(1.0 - u) / std::log(mean / (mean + 1.0)));
+            length = std::min(length, maxLength);
+        } else {
+            length = minLength + (size_t)random.nextBelow(maxLength - minLength + 1);
+        }
+        text.resize(length);
+        for (auto &c : text)
+            c = (char)('a' + random.nextBelow(26));
+    }
+    return result;
+}
+
+std::string KeySet::description() const {
+    return "keys(n=" + std::to_string(n) + ", lookups=" + std::to_string(lookups) +
+           ", hit ratio=" + formatParameter(hitRatio) + ", seed=" + std::to_string(seed) + ")";
+}
+
+KeySet::result_type KeySet::generate() const {
+    // scramble() is a bijection: keys come from seed + [0, n), misses from seed + [n, ...)
+    result_type result;
+    result.keys.resize(n);
+    for (size_t i = 0; i < n; i++)
+        result.keys[i] = scramble(seed + i);
+
+    SplitMix64 random(scramble(~seed));
+    result.lookups.resize(lookups);
+    uint64_t miss = n;
+    for (auto &key : result.lookups) {
+        if (n > 0 && random.nextDouble() < hitRatio)
+            key = result.keys[random.nextBelow(n)];
+        else
+            key = scramble(seed + miss++);
+    }
+    return result;
+}
+
+}} //namespaces
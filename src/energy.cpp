@@ -0,0 +1,58 @@
+#include <benchmark/detail/energy.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+namespace benchmark {
+namespace detail {
+
+std::string formatEnergy(double joules) {
+    char buf[32];
+    if (joules < 1e-3)
+        std::snprintf(buf, sizeof(buf), "%.3g μJ", joules * 1e6);
+    else if (joules < 1)
+        std::snprintf(buf, sizeof(buf), "%.3g mJ", joules * 1e3);
+    else
+        std::snprintf(buf, sizeof(buf), "%.3g J", joules);
+    return buf;
+}
+
+void EnergyMeter::clear() {
+    std::fill(_joules.begin(), _joules.end(), 0.0);
+    _time = duration_t(0);
+    _samples = 0;
+}
+
+void EnergyMeter::begin() {
+    for (size_t d = 0; d < _domains.size(); d++) {
+        if (!_failed[d] && !readRaplEnergy(_domains[d], _before[d]))
+            _failed[d] = true;
+    }
+    _start = clock_t::now();
+}
+
+void EnergyMeter::end() {
+    _time += clock_t::now() - _start;
+    for (size_t d = 0; d < _domains.size(); d++) {
+        uint64_t after = 0;
+        if (_failed[d] || !readRaplEnergy(_domains[d], after)) {
+            _failed[d] = true;
+            continue;
+        }
+        _joules[d] += difference(_before[d], after, _domains[d].maxEnergyRange) * 1e-6;
+    }
+    _samples++;
+}
+
+std::vector<EnergyUsage> EnergyMeter::usage() const {
+    std::vector<EnergyUsage> result;
+    double seconds = std::chrono::duration<double>(_time).count();
+    for (size_t d = 0; d < _domains.size() && _samples > 0; d++) {
+        if (_failed[d])
+            continue;
+        result.push_back(EnergyUsage{_domains[d].name, _joules[d] / _samples, seconds > 0 ? _joules[d] / seconds : 0});
+    }
+    return result;
+}
+
+}} //namespaces
@@ -0,0 +1,291 @@
+#include <benchmark/detail/file_io.h>
+#include <benchmark/detail/dataset.h>
+#include <benchmark/detail/dont_optimize.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace benchmark {
+
+namespace {
+
+const size_t DirectAlignment = 4096;
+
+std::string directoryOf(int location) {
+    if (location == FileOnTmpfs)
+        return "/dev/shm";
+    const char *tmp = std::getenv("TMPDIR");
+    return tmp && *tmp ? tmp : "/var/tmp";
+}
+
+} // namespace
+
+TempFile::TempFile(size_t size, int location, uint64_t seed)
+    : _fd(-1), _directFd(-1), _size(size), _map(nullptr), _cursor(0), _batches(0) {
+    std::string pattern = directoryOf(location) + "/benchmark-XXXXXX";
+    std::vector<char> path(pattern.begin(), pattern.end());
+    path.push_back('\0');
+    _fd = mkstemp(path.data());
+    if (_fd < 0) {
+        std::cerr << "Couldn't create a file in '" << directoryOf(location) << "'\n";
+        return;
+    }
+    _path = path.data();
+
+    // seeded data rather than zeros, which some file systems and devices compress or skip
+    data::SplitMix64 random(seed);
+    std::vector<uint64_t> chunk(1 << 16);
+    for (size_t written = 0; written < size;) {
+        for (auto &value : chunk)
+            value = random.next();
+        size_t bytes = std::min(size - written, chunk.size() * sizeof(uint64_t));
+        ssize_t ret = pwrite(_fd, chunk.data(), bytes, (off_t)written);
+        if (ret <= 0) {
+            std::cerr << "Couldn't write to '" << _path << "'\n";
+            _size = written;
+            break;
+        }
+        written += (size_t)ret;
+    }
+    fsync(_fd);
+
+#ifdef O_DIRECT
+    _directFd = open(_path.c_str(), O_RDWR | O_DIRECT);
+#endif
+    if (_size > 0) {
+        void *map = mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+        _map = map == MAP_FAILED ? nullptr : (char *)map;
+    }
+}
+
+TempFile::TempFile(TempFile &&other)
+    : _path(std::move(other._path)), _fd(other._fd), _directFd(other._directFd), _size(other._size), _map(other._map),
+      _cursor(other._cursor), _batches(other._batches) {
+    other._path.clear();
+    other._fd = -1;
+    other._directFd = -1;
+    other._map = nullptr;
+}
+
+TempFile::~TempFile() {
+    if (_map)
+        munmap(_map, _size);
+    if (_directFd >= 0)
+        close(_directFd);
+    if (_fd >= 0)
+        close(_fd);
+    if (!_path.empty())
+        unlink(_path.c_str());
+}
+
+bool TempFile::dropCache() const {
+    if (_fd < 0)
+        return false;
+    if (fdatasync(_fd) != 0)
+        return false;
+    // the pages stay cached while the mapping references them
+    if (_map && madvise(_map, _size, MADV_DONTNEED) != 0)
+        return false;
+#ifdef POSIX_FADV_DONTNEED
+    if (posix_fadvise(_fd, 0, 0, POSIX_FADV_DONTNEED) != 0)
+        return false;
+    // cold only if nothing is left in the page cache, never on tmpfs
+    return residentPages() <= 0;
+#else
+    return false;
+#endif
+}
+
+long TempFile::residentPages() const {
+    if (!_map)
+        return -1;
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    std::vector<unsigned char> pages((_size + page - 1) / page);
+    if (mincore(_map, _size, pages.data()) != 0)
+        return -1;
+    long resident = 0;
+    for (unsigned char p : pages)
+        resident += p & 1;
+    return resident;
+}
+
+uint64_t TempFile::nextSequential(size_t blockSize, size_t blocks) const {
+    uint64_t span = (uint64_t)blockSize * blocks;
+    if (_cursor + span > _size)
+        _cursor = 0;
+    uint64_t offset = _cursor;
+    _cursor += span;
+    return offset;
+}
+
+namespace data {
+
+std::string File::description() const {
+    return "file(size=" + std::to_string(size) + ", location=" + (location == FileOnTmpfs ? "tmpfs" : "disk") +
+           ", seed=" + std::to_string(seed) + ")";
+}
+
+File::result_type File::generate() const {
+    return TempFile(size, location, seed);
+}
+
+} // namespace data
+
+IoJob::IoJob(int method, int pattern, size_t blockSize, size_t blocks, unsigned queueDepth, int mode, uint64_t seed)
+    : _method(method), _pattern(pattern), _mode(mode), _blockSize(blockSize), _blocks(blocks),
+      _queueDepth(std::max(1u, queueDepth)), _seed(seed), _generation(0), _busy(0), _stop(false), _fd(-1), _next(0),
+      _bytes(0) {
+    if (_method == IoMmap || _mode == IoWriteSync)
+        _queueDepth = 1;
+    _buffers.resize(std::min((size_t)_queueDepth, std::max(_blocks, (size_t)1)));
+    for (auto &buffer : _buffers) {
+        void *p = nullptr;
+        if (posix_memalign(&p, DirectAlignment, std::max(_blockSize, DirectAlignment)) != 0)
+            p = nullptr;
+        else
+            std::memset(p, 0x5a, _blockSize);
+        buffer = (char *)p;
+    }
+    for (unsigned i = 1; i < _buffers.size(); i++)
+        _workers.emplace_back(&IoJob::work, this, i);
+}
+
+IoJob::~IoJob() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _wake.notify_all();
+    for (auto &worker : _workers)
+        worker.join();
+    for (char *buffer : _buffers)
+        std::free(buffer);
+}
+
+void IoJob::prepare(const TempFile &file) {
+    _offsets.resize(_blocks);
+    size_t fileBlocks = _blockSize ? file.size() / _blockSize : 0;
+    if (fileBlocks == 0) {
+        _offsets.clear();
+        return;
+    }
+
+    if (_pattern == IoSequential) {
+        uint64_t start = file.nextSequential(_blockSize, std::min(_blocks, fileBlocks));
+        for (size_t i = 0; i < _blocks; i++)
+            _offsets[i] = (start + (uint64_t)i * _blockSize) % ((uint64_t)fileBlocks * _blockSize);
+    } else {
+        data::SplitMix64 random(_seed + file.nextBatch());
+        for (auto &offset : _offsets)
+            offset = random.nextBelow(fileBlocks) * _blockSize;
+    }
+}
+
+uint64_t IoJob::run(const TempFile &file) {
+    if (_offsets.size() != _blocks)
+        prepare(file);
+    if (_offsets.empty() || !_buffers.front())
+        return 0;
+
+    if (_method == IoMmap)
+        return file.map() ? runMapped(file.map()) : 0;
+
+    int fd = _method == IoDirect ? file.directFd() : file.fd();
+    if (fd < 0 || (_method == IoDirect && _blockSize % DirectAlignment != 0))
+        return 0;
+    return runQueued(fd);
+}
+
+uint64_t IoJob::drain(int fd, char *buffer) {
+    uint64_t bytes = 0;
+    for (size_t i = _next++; i < _offsets.size(); i = _next++) {
+        ssize_t ret = _mode == IoRead ? pread(fd, buffer, _blockSize, (off_t)_offsets[i])
+                                      : pwrite(fd, buffer, _blockSize, (off_t)_offsets[i]);
+        if (ret < 0 || (_mode == IoWriteSync && fdatasync(fd) != 0)) {
+            _next = _offsets.size();
+            break;
+        }
+        bytes += (uint64_t)ret;
+    }
+    return bytes;
+}
+
+void IoJob::work(unsigned index) {
+    uint64_t seen = 0;
+    while (true) {
+        int fd;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _wake.wait(lock, [&] { return _stop || _generation != seen; });
+            if (_stop)
+                return;
+            seen = _generation;
+            fd = _fd;
+        }
+        _bytes += drain(fd, _buffers[index]);
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _busy--;
+        }
+        _done.notify_one();
+    }
+}
+
+uint64_t IoJob::runQueued(int fd) {
+    _next = 0;
+    _bytes = 0;
+    if (!_workers.empty()) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _fd = fd;
+        _busy = (unsigned)_workers.size();
+        _generation++;
+    }
+    _wake.notify_all();
+
+    uint64_t bytes = drain(fd, _buffers.front());
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _done.wait(lock, [&] { return _busy == 0; });
+    return bytes + _bytes;
+}
+
+uint64_t IoJob::runMapped(char *map) {
+    char *buffer = _buffers.front();
+    for (uint64_t offset : _offsets) {
+        if (_mode == IoRead) {
+            std::memcpy(buffer, map + offset, _blockSize);
+        } else {
+            std::memcpy(map + offset, buffer, _blockSize);
+            if (_mode == IoWriteSync) {
+                // msync wants a page-aligned address
+                uint64_t page = offset & ~(uint64_t)(DirectAlignment - 1);
+                if (msync(map + page, offset + _blockSize - page, MS_SYNC) != 0)
+                    return 0;
+            }
+        }
+    }
+    benchmark::DoNotOptimize(buffer[0]);
+    return (uint64_t)_blockSize * _offsets.size();
+}
+
+namespace detail {
+
+std::string formatRate(double perSecond, const char *unit) {
+    static const char *prefixes[] = {"", "k", "M", "G", "T"};
+    size_t prefix = 0;
+    while (perSecond >= 1000.0 && prefix + 1 < sizeof(prefixes) / sizeof(prefixes[0])) {
+        perSecond /= 1000.0;
+        prefix++;
+    }
+    char buf[48];
+    std::snprintf(buf, sizeof(buf), "%.3g %s%s/s", perSecond, prefixes[prefix], unit);
+    return buf;
+}
+
+}} //namespaces
@@ -0,0 +1,401 @@
+#include <benchmark/detail/history.h>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <unordered_map>
+#include <benchmark/detail/chrono_utils.h>
+#include <benchmark/detail/colorization.h>
+#include <benchmark/detail/cpu_info.h>
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace benchmark {
+namespace detail {
+
+namespace {
+
+struct SeriesHash {
+    size_t operator()(const HistoryRecord *record) const {
+        return (size_t)record->seriesHash();
+    }
+};
+
+struct SameSeries {
+    bool operator()(const HistoryRecord *a, const HistoryRecord *b) const {
+        return a->sameSeries(*b);
+    }
+};
+
+} // namespace
+
+uint64_t HistoryRecord::seriesHash() const {
+    uint64_t hash = fnv1a(name, strnlen(name, sizeof(name)));
+    hash = fnv1a(&machine, sizeof(machine), hash);
+    hash = fnv1a(&variant, sizeof(variant), hash);
+    return fnv1a(args, argCount * sizeof(args[0]), hash);
+}
+
+uint64_t machineFingerprint() {
+    std::string identity;
+#ifndef WIN32
+    char hostname[256] = {0};
+    if (gethostname(hostname, sizeof(hostname) - 1) == 0)
+        identity += hostname;
+
+    FILE *fh = std::fopen("/proc/cpuinfo", "r");
+    if (fh) {
+        char buf[512];
+        while (std::fgets(buf, sizeof(buf), fh)) {
+            if (std::strncmp(buf, "model name", 10) == 0) {
+                identity += buf;
+                break;
+            }
+        }
+        std::fclose(fh);
+    }
+#endif
+    identity += std::to_string(getCPUCoresNum());
+    return fnv1a(identity);
+}
+
+std::string currentRevision() {
+    const char *env = std::getenv("BENCHMARK_REVISION");
+    if (env && *env)
+        return env;
+
+    std::string result;
+#ifndef WIN32
+    FILE *pipe = popen("git rev-parse --short=12 HEAD 2>/dev/null", "r");
+    if (pipe) {
+        char buf[64] = {0};
+        if (std::fgets(buf, sizeof(buf), pipe))
+            result = buf;
+        pclose(pipe);
+    }
+#endif
+    while (!result.empty() && (result.back() == '\n' || result.back() == '\r'))
+        result.pop_back();
+    return result.empty() ? "unknown" : result;
+}
+
+HistoryRecord HistoryLog::makeRecord(const BenchmarkResult &result, const std::string &revision, uint64_t machine,
+                                      int64_t timestamp) {
+    HistoryRecord record;
+    std::memset(&record, 0, sizeof(record));
+    copyText(record.name, sizeof(record.name), result.name);
+    copyText(record.revision, sizeof(record.revision), revision);
+    record.machine = machine;
+    record.timestamp = timestamp;
+    record.argCount = result.hasArg ? 1 : 0;
+    record.args[0] = result.hasArg ? result.arg : 0;
+    record.iterations = result.iterations;
+    record.median = toNs(result.median);
+    record.average = toNs(result.average);
+    record.minimum = toNs(result.minimum);
+    record.maximum = toNs(result.maximum);
+    record.stdDev = toNs(result.stdDev);
+    record.medianLower = result.medianInterval.valid ? result.medianInterval.lower : record.median;
+    record.medianUpper = result.medianInterval.valid ? result.medianInterval.upper : record.median;
+
+    // a run in another partition, with another placement, load or layout is another series
+    std::string labels;
+    for (const std::string *label : {&result.partition, &result.memory, &result.antagonist, &result.layout}) {
+        if (label->empty())
+            continue;
+        if (!labels.empty())
+            labels += "; ";
+        labels += *label;
+    }
+    if (!labels.empty())
+        record.variant =
+            fnv1a(result.partition + '\n' + result.memory + '\n' + result.antagonist + '\n' + result.layout);
+    copyText(record.labels, sizeof(record.labels), labels);
+    return record;
+}
+
+bool HistoryLog::append(const std::vector<HistoryRecord> &records) {
+#ifdef WIN32
+    std::cerr << "Result history isn't supported on this platform\n";
+    return false;
+#else
+    if (records.empty())
+        return true;
+
+    int fd = ::open(_path.c_str(), O_RDWR | O_APPEND | O_CREAT, 0644);
+    if (fd < 0) {
+        std::cerr << "Couldn't open '" << _path << "'\n";
+        return false;
+    }
+
+    // whoever appends first writes the header, another process appending at the same time waits for it
+    if (::flock(fd, LOCK_EX) != 0) {
+        ::close(fd);
+        std::cerr << "Couldn't lock '" << _path << "'\n";
+        return false;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        std::cerr << "Couldn't stat '" << _path << "'\n";
+        return false;
+    }
+
+    std::string data;
+    if (st.st_size != 0) {
+        HistoryHeader header;
+        if (::pread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+            std::memcmp(header.magic, "BMHIST", 6) != 0 || header.version != Version ||
+            header.recordSize != sizeof(HistoryRecord)) {
+            ::close(fd);
+            std::cerr << "'" << _path << "' isn't a benchmark history file of version " << Version << "\n";
+            return false;
+        }
+    } else {
+        HistoryHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, "BMHIST", 6);
+        header.version = Version;
+        header.recordSize = sizeof(HistoryRecord);
+        data.append((const char *)&header, sizeof(header));
+    }
+    data.append((const char *)records.data(), records.size() * sizeof(HistoryRecord));
+
+    bool ok = ::write(fd, data.data(), data.size()) == (ssize_t)data.size();
+    ::close(fd); // releases the lock
+    if (!ok)
+        std::cerr << "Couldn't write to '" << _path << "'\n";
+    return ok;
+#endif
+}
+
+HistoryMapping::~HistoryMapping() {
+#ifndef WIN32
+    if (_mapped)
+        ::munmap(_mapped, _size);
+#endif
+}
+
+bool HistoryLog::map(HistoryMapping &mapping) const {
+#ifdef WIN32
+    std::cerr << "Result history isn't supported on this platform\n";
+    return false;
+#else
+    int fd = ::open(_path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Couldn't open '" << _path << "'\n";
+        return false;
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        std::cerr << "Couldn't read from '" << _path << "'\n";
+        return false;
+    }
+    if ((size_t)st.st_size < sizeof(HistoryHeader)) {
+        ::close(fd);
+        return st.st_size == 0; // created, nothing appended yet
+    }
+
+    size_t size = (size_t)st.st_size;
+    void *mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "Couldn't map '" << _path << "'\n";
+        return false;
+    }
+
+    const HistoryHeader *header = (const HistoryHeader *)mapped;
+    if (std::memcmp(header->magic, "BMHIST", 6) != 0 || header->version != Version ||
+        header->recordSize != sizeof(HistoryRecord)) {
+        ::munmap(mapped, size);
+        std::cerr << "'" << _path << "' isn't a benchmark history file of version " << Version << "\n";
+        return false;
+    }
+
+    if (mapping._mapped)
+        ::munmap(mapping._mapped, mapping._size);
+    mapping._mapped = mapped;
+    mapping._size = size;
+    mapping._records = (const HistoryRecord *)((const char *)mapped + sizeof(HistoryHeader));
+    mapping._count = (size - sizeof(HistoryHeader)) / sizeof(HistoryRecord);
+    return true;
+#endif
+}
+
+bool HistoryLog::read(const std::function<void(const HistoryRecord &)> &consume) const {
+    HistoryMapping mapping;
+    if (!map(mapping))
+        return false;
+    for (auto &record : mapping)
+        consume(record);
+    return true;
+}
+
+std::vector<HistoryRecord> HistoryLog::records() const {
+    std::vector<HistoryRecord> result;
+    read([&result](const HistoryRecord &record) { result.push_back(record); });
+    return result;
+}
+
+std::vector<HistoryLog::Series> HistoryLog::series(const HistoryRecord *begin, const HistoryRecord *end,
+                                                   const std::string &filter) {
+    std::vector<Series> result;
+    std::unordered_map<const HistoryRecord *, size_t, SeriesHash, SameSeries> index; // first run -> series
+    for (const HistoryRecord *record = begin; record != end; record++) {
+        if (!filter.empty() && std::strstr(record->name, filter.c_str()) == nullptr)
+            continue;
+
+        auto found = index.insert(std::make_pair(record, result.size()));
+        if (found.second)
+            result.push_back(Series());
+        result[found.first->second].runs.push_back(record);
+    }
+
+    for (auto &s : result) {
+        std::stable_sort(s.runs.begin(), s.runs.end(), [](const HistoryRecord *a, const HistoryRecord *b) {
+            return a->timestamp < b->timestamp;
+        });
+    }
+    return result;
+}
+
+double HistoryLog::trend(const std::vector<const HistoryRecord *> &runs) {
+    size_t n = runs.size();
+    if (n < 3)
+        return 0.0;
+
+    double meanX = (double)(n - 1) / 2.0, meanY = 0.0;
+    for (auto run : runs)
+        meanY += run->median;
+    meanY /= (double)n;
+
+    double sxy = 0.0, sxx = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        sxy += ((double)i - meanX) * (runs[i]->median - meanY);
+        sxx += ((double)i - meanX) * ((double)i - meanX);
+    }
+    return meanY > 0.0 ? sxy / sxx / meanY : 0.0;
+}
+
+HistoryLog::StepChange HistoryLog::stepChange(const std::vector<const HistoryRecord *> &runs, double minRelative,
+                                              double minScore) {
+    StepChange result{false, 0, 0.0, 0.0, 0.0};
+    size_t n = runs.size();
+    if (n < 4)
+        return result;
+
+    double runNoise = 0.0; // variance of a single run median, from the intervals
+    for (auto run : runs) {
+        double halfWidth = (run->medianUpper - run->medianLower) / 2.0 / 1.96;
+        runNoise += halfWidth * halfWidth;
+    }
+    runNoise /= (double)n;
+
+    double bestScore = 0.0;
+    for (size_t split = 2; split + 2 <= n; split++) {
+        double means[2] = {0.0, 0.0}, ss[2] = {0.0, 0.0};
+        size_t counts[2] = {split, n - split};
+        for (size_t i = 0; i < n; i++)
+            means[i >= split] += runs[i]->median;
+        means[0] /= (double)counts[0];
+        means[1] /= (double)counts[1];
+        for (size_t i = 0; i < n; i++) {
+            double d = runs[i]->median - means[i >= split];
+            ss[i >= split] += d * d;
+        }
+
+        double pooled = std::max((ss[0] + ss[1]) / (double)(n - 2), runNoise);
+        double se = std::sqrt(pooled * (1.0 / (double)counts[0] + 1.0 / (double)counts[1]));
+        double shift = std::fabs(means[1] - means[0]);
+        double score = se > 0.0 ? shift / se : (shift > 0.0 ? INFINITY : 0.0);
+        if (means[0] <= 0.0 || shift / means[0] < minRelative || score < minScore)
+            continue;
+
+        if (score > bestScore) {
+            bestScore = score;
+            result = StepChange{true, split, means[0], means[1], means[1] / means[0] - 1.0};
+        }
+    }
+    return result;
+}
+
+std::string HistoryLog::formatDate(int64_t timestamp) {
+    char buf[32] = {0};
+    std::time_t t = (std::time_t)timestamp;
+    std::tm *tm = std::localtime(&t);
+    if (tm)
+        std::strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M", tm);
+    return buf;
+}
+
+std::string HistoryLog::percent(double fraction) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%+.1f%%", fraction * 100.0);
+    return buf;
+}
+
+duration_t HistoryLog::fromNs(double ns) {
+    return std::chrono::duration_cast<duration_t>(std::chrono::nanoseconds((int64_t)ns));
+}
+
+bool HistoryLog::printQuery(std::ostream &os, const std::string &filter, size_t last) const {
+    HistoryMapping mapping;
+    if (!map(mapping))
+        return false;
+    std::vector<Series> grouped = series(mapping.begin(), mapping.end(), filter);
+    if (grouped.empty()) {
+        os << "No runs in '" << _path << "'" << (filter.empty() ? "" : " matching '" + filter + "'") << "\n";
+        return false;
+    }
+
+    for (auto &s : grouped) {
+        const HistoryRecord &latest = s.latest();
+        size_t from = s.runs.size() > last ? s.runs.size() - last : 0;
+        std::vector<const HistoryRecord *> recent(s.runs.begin() + (std::ptrdiff_t)from, s.runs.end());
+
+        os << "[History '" << latest.name << "'";
+        for (uint32_t a = 0; a < latest.argCount; a++)
+            os << " $" << a + 1 << "=" << latest.args[a];
+        if (latest.labels[0])
+            os << ", " << latest.labels;
+        os << "] machine " << std::hex << std::setw(8) << std::setfill('0') << (uint32_t)(latest.machine >> 32)
+           << std::dec << std::setfill(' ') << ", " << s.runs.size() << " runs, latest: "
+           << fromNs(latest.median) << " (" << latest.revision << ", " << formatDate(latest.timestamp) << ")";
+        if (recent.size() >= 3)
+            os << ", trend over last " << recent.size() << ": " << percent(trend(recent)) << "/run";
+        os << "\n";
+
+        auto minmax = std::minmax_element(s.runs.begin(), s.runs.end(),
+                                          [](const HistoryRecord *a, const HistoryRecord *b) {
+                                              return a->median < b->median;
+                                          });
+        const HistoryRecord &best = **minmax.first, &worst = **minmax.second;
+        os << "    best : " << fromNs(best.median) << " (" << best.revision << ", " << formatDate(best.timestamp)
+           << "), worst: " << fromNs(worst.median) << " (" << worst.revision << ", "
+           << formatDate(worst.timestamp) << ")\n";
+
+        StepChange step = stepChange(recent);
+        if (step.found) {
+            const HistoryRecord &first = *recent[step.index];
+            os << (step.relative > 0.0 ? benchmark::detail::ColorLightRed : benchmark::detail::ColorLightGreen)
+               << "    step : " << percent(step.relative) << " at "
+               << first.revision << " (" << formatDate(first.timestamp) << "), " << fromNs(step.before) << " -> "
+               << fromNs(step.after) << benchmark::detail::ColorReset << "\n";
+        }
+    }
+
+    os.flush();
+    return true;
+}
+
+}} //namespaces
@@ -0,0 +1,162 @@
+#include <benchmark/detail/json_report.h>
+#include <cstdio>
+#include <iostream>
+
+namespace benchmark {
+namespace detail {
+
+namespace {
+
+void writeString(FILE *fh, const std::string &text) {
+    std::fputc('"', fh);
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            std::fputc('\\', fh);
+            std::fputc(c, fh);
+        } else if ((unsigned char)c < 0x20) {
+            std::fprintf(fh, "\\u%04x", (unsigned)c);
+        } else {
+            std::fputc(c, fh);
+        }
+    }
+    std::fputc('"', fh);
+}
+
+void writeNs(FILE *fh, duration_t duration) {
+    std::fprintf(fh, "%lld", (long long)std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+}
+
+void writeArg(FILE *fh, const BenchmarkResult &result) {
+    if (result.hasArg)
+        std::fprintf(fh, "%d", result.arg);
+    else
+        std::fprintf(fh, "null");
+}
+
+void writeResult(FILE *fh, const BenchmarkResult &result) {
+    std::fprintf(fh, "{\"name\": ");
+    writeString(fh, result.name);
+    std::fprintf(fh, ", \"arg\": ");
+    writeArg(fh, result);
+    std::fprintf(fh, ", \"iterations\": %u, \"operations\": %llu, \"bytes\": %llu", result.iterations,
+                 (unsigned long long)result.operations, (unsigned long long)result.bytes);
+
+    const std::pair<const char *, duration_t> times[] = {
+        {"median_ns", result.median},   {"average_ns", result.average}, {"minimum_ns", result.minimum},
+        {"maximum_ns", result.maximum}, {"stddev_ns", result.stdDev},   {"warmup_ns", result.warmupTime}};
+    for (auto &time : times) {
+        std::fprintf(fh, ", \"%s\": ", time.first);
+        writeNs(fh, time.second);
+    }
+    if (result.medianInterval.valid)
+        std::fprintf(fh, ", \"median_interval_ns\": [%.17g, %.17g]", result.medianInterval.lower,
+                     result.medianInterval.upper);
+    else
+        std::fprintf(fh, ", \"median_interval_ns\": null");
+    std::fprintf(fh, ", \"warmup_samples\": %u", result.warmupSamples);
+
+    const std::pair<const char *, const std::string *> texts[] = {
+        {"partition", &result.partition}, {"memory", &result.memory},         {"datasets", &result.datasets},
+        {"antagonist", &result.antagonist}, {"layout", &result.layout},
+        {"comparison", &result.comparison}};
+    for (auto &text : texts) {
+        std::fprintf(fh, ", \"%s\": ", text.first);
+        writeString(fh, *text.second);
+    }
+
+    std::fprintf(fh, ", \"energy\": [");
+    for (size_t i = 0; i < result.energy.size(); i++) {
+        std::fprintf(fh, "%s{\"domain\": ", i ? ", " : "");
+        writeString(fh, result.energy[i].domain);
+        std::fprintf(fh, ", \"joules\": %.17g, \"watts\": %.17g}", result.energy[i].joules, result.energy[i].watts);
+    }
+    std::fprintf(fh, "], \"counters\": {");
+    for (size_t i = 0; i < result.counters.size(); i++) {
+        std::fprintf(fh, "%s", i ? ", " : "");
+        writeString(fh, result.counters[i].first);
+        std::fprintf(fh, ": %.17g", result.counters[i].second);
+    }
+    std::fprintf(fh, "}}");
+}
+
+void writeGroup(FILE *fh, const BenchmarkGroup &group) {
+    std::fprintf(fh, "{\"name\": ");
+    writeString(fh, group.name);
+    std::fprintf(fh, ", \"baseline\": ");
+    writeString(fh, group.members.empty() ? "" : group.members.front().label);
+    std::fprintf(fh, ", \"columns\": [");
+    for (size_t m = 0; m < group.members.size(); m++) {
+        std::fprintf(fh, "%s", m ? ", " : "");
+        writeString(fh, group.members[m].label);
+    }
+    std::fprintf(fh, "], \"rows\": [");
+
+    std::vector<std::string> rows = group.rows();
+    for (size_t r = 0; r < rows.size(); r++) {
+        const BenchmarkResult *base = group.find(0, rows[r]);
+        const BenchmarkResult *any = base;
+        for (size_t m = 0; !any && m < group.members.size(); m++)
+            any = group.find(m, rows[r]);
+
+        std::fprintf(fh, "%s\n    {\"row\": ", r ? "," : "");
+        writeString(fh, rows[r]);
+        std::fprintf(fh, ", \"arg\": ");
+        writeArg(fh, *any);
+        std::fprintf(fh, ", \"antagonist\": ");
+        writeString(fh, any->antagonist);
+        std::fprintf(fh, ", \"layout\": ");
+        writeString(fh, any->layout);
+        std::fprintf(fh, ", \"cells\": [");
+        for (size_t m = 0; m < group.members.size(); m++) {
+            std::fprintf(fh, "%s", m ? ", " : "");
+            const BenchmarkResult *result = group.find(m, rows[r]);
+            if (!result) {
+                std::fprintf(fh, "null");
+                continue;
+            }
+            std::fprintf(fh, "{\"benchmark\": ");
+            writeString(fh, result->name);
+            std::fprintf(fh, ", \"median_ns\": ");
+            writeNs(fh, result->median);
+            double times = base ? speedup(*base, *result) : 0.0;
+            if (times > 0.0)
+                std::fprintf(fh, ", \"speedup\": %.6g", times);
+            else
+                std::fprintf(fh, ", \"speedup\": null");
+            std::fprintf(fh, ", \"significant\": %s}", base && significance(*base, *result) != 0 ? "true" : "false");
+        }
+        std::fprintf(fh, "]}");
+    }
+    std::fprintf(fh, "]}");
+}
+
+} // namespace
+
+bool writeJsonReport(const std::string &path, const std::vector<BenchmarkResult> &results,
+                     const std::vector<BenchmarkGroup> &groups) {
+    FILE *fh = std::fopen(path.c_str(), "w");
+    if (!fh) {
+        std::cerr << "Couldn't open '" << path << "' for writing\n";
+        return false;
+    }
+
+    std::fprintf(fh, "{\"benchmarks\": [");
+    for (size_t i = 0; i < results.size(); i++) {
+        std::fprintf(fh, "%s\n  ", i ? "," : "");
+        writeResult(fh, results[i]);
+    }
+    std::fprintf(fh, "],\n\"groups\": [");
+    for (size_t i = 0; i < groups.size(); i++) {
+        std::fprintf(fh, "%s\n  ", i ? "," : "");
+        writeGroup(fh, groups[i]);
+    }
+    std::fprintf(fh, "]}\n");
+
+    bool ok = std::ferror(fh) == 0;
+    ok = std::fclose(fh) == 0 && ok;
+    if (!ok)
+        std::cerr << "Couldn't write '" << path << "'\n";
+    return ok;
+}
+
+}} //namespaces
@@ -0,0 +1,98 @@
+#include <benchmark/detail/layout.h>
+#include <benchmark/detail/dataset.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace benchmark {
+namespace detail {
+
+namespace {
+
+const size_t LayoutStep = 16;
+const size_t LayoutSpan = 4096;
+
+// asymptotic standard error of the median of n normal samples: sqrt(pi / 2) * sigma / sqrt(n)
+const double MedianEfficiency = 1.2533;
+
+} // namespace
+
+std::string MemoryLayout::description() const {
+    std::string prefix = "layout " + std::to_string(index);
+    if (stack == 0 && heap == 0 && data == 0)
+        return prefix + " (default)";
+    return prefix + " (stack+" + std::to_string(stack) + ", heap+" + std::to_string(heap) + ", data+" +
+           std::to_string(data) + ")";
+}
+
+MemoryLayout memoryLayout(unsigned index) {
+    MemoryLayout layout{index, 0, 0, 0};
+    if (index == 0)
+        return layout;
+
+    // the same offsets for the same layout in every run; seeds further apart than consecutive numbers, whose first
+    // outputs share their top bits now and then
+    data::SplitMix64 random(0x9E3779B97F4A7C15ull * index);
+    layout.stack = (size_t)random.nextBelow(LayoutSpan / LayoutStep) * LayoutStep;
+    layout.heap = (size_t)random.nextBelow(LayoutSpan / LayoutStep) * LayoutStep;
+    layout.data = (size_t)random.nextBelow(LayoutSpan / LayoutStep) * LayoutStep;
+    return layout;
+}
+
+size_t OffsetResource::shift(size_t alignment) const {
+    size_t step = std::max(alignment, LayoutStep);
+    size_t span = std::max(LayoutSpan, step * 16);
+    return _offset / LayoutStep * step % span;
+}
+
+std::vector<int> layoutList(unsigned layouts) {
+    std::vector<int> result;
+    for (unsigned i = 0; i < layouts; i++)
+        result.push_back((int)i);
+    return result;
+}
+
+LayoutVariance layoutVariance(const std::vector<BenchmarkResult> &results) {
+    LayoutVariance variance{(unsigned)results.size(), 0, 0, 0, 0, 0, 0, 0};
+    if (results.empty())
+        return variance;
+
+    std::vector<double> medians;
+    double sampleVariance = 0, noiseVariance = 0;
+    for (auto &result : results) {
+        double median = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(result.median).count();
+        double stdDev = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(result.stdDev).count();
+        medians.push_back(median);
+        sampleVariance += stdDev * stdDev;
+        double error = MedianEfficiency * stdDev / std::sqrt((double)std::max(result.iterations, 1u));
+        noiseVariance += error * error;
+    }
+    sampleVariance /= results.size();
+    noiseVariance /= results.size();
+
+    std::sort(medians.begin(), medians.end());
+    size_t n = medians.size();
+    variance.median = n % 2 ? medians[n / 2] : (medians[n / 2 - 1] + medians[n / 2]) / 2;
+    variance.minimum = medians.front();
+    variance.maximum = medians.back();
+    variance.sampleStdDev = std::sqrt(sampleVariance);
+    variance.medianNoise = std::sqrt(noiseVariance);
+    if (n < 2)
+        return variance;
+
+    double mean = 0;
+    for (double median : medians)
+        mean += median;
+    mean /= n;
+    double mediansVariance = 0;
+    for (double median : medians)
+        mediansVariance += (median - mean) * (median - mean);
+    mediansVariance /= n - 1;
+
+    double fromLayouts = std::max(0.0, mediansVariance - noiseVariance);
+    variance.layoutStdDev = std::sqrt(fromLayouts);
+    variance.layoutShare = mediansVariance > 0 ? fromLayouts / mediansVariance : 0.0;
+    return variance;
+}
+
+}} //namespaces
@@ -0,0 +1,154 @@
+#include <benchmark/detail/numa.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <benchmark/detail/cpu_info.h>
+#include <benchmark/detail/topology.h>
+
+#ifndef WIN32
+#include <dirent.h>
+#endif
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace benchmark {
+namespace detail {
+
+std::vector<NumaNode> readNumaNodes() {
+    std::vector<NumaNode> result;
+#if defined(__linux__)
+    DIR *dir = opendir("/sys/devices/system/node");
+    if (dir) {
+        while (dirent *entry = readdir(dir)) {
+            if (std::strncmp(entry->d_name, "node", 4) != 0 || entry->d_name[4] < '0' || entry->d_name[4] > '9')
+                continue;
+
+            NumaNode node;
+            node.id = std::atoi(entry->d_name + 4);
+            std::string base = std::string("/sys/devices/system/node/") + entry->d_name;
+            node.cpus = parseCpuList(readSysfsLine(base + "/cpulist"));
+
+            // "Node 0 MemTotal:       16303040 kB"
+            std::string memInfo = readSysfsLine(base + "/meminfo");
+            size_t colon = memInfo.find("MemTotal:");
+            node.memTotal = colon == std::string::npos ? 0 : std::strtoull(memInfo.c_str() + colon + 9, nullptr, 10);
+            result.push_back(node);
+        }
+        closedir(dir);
+    }
+#endif
+    std::sort(result.begin(), result.end(), [](const NumaNode &a, const NumaNode &b) { return a.id < b.id; });
+    if (result.empty()) {
+        NumaNode node{0, {}, 0};
+        for (int cpu = 0; cpu < getCPUCoresNum(); cpu++)
+            node.cpus.push_back(cpu);
+        result.push_back(node);
+    }
+    return result;
+}
+
+int nodeOfCpu(const std::vector<NumaNode> &nodes, int cpu) {
+    for (auto &node : nodes) {
+        if (std::find(node.cpus.begin(), node.cpus.end(), cpu) != node.cpus.end())
+            return node.id;
+    }
+    return nodes.empty() ? 0 : nodes.front().id;
+}
+
+int parsePlacement(const std::string &text) {
+    if (text == "default")
+        return PlaceDefault;
+    if (text == "local")
+        return PlaceLocal;
+    if (text == "remote")
+        return PlaceRemote;
+    if (text == "interleave")
+        return PlaceInterleave;
+    if (text.compare(0, 11, "firsttouch:") == 0 && text.size() > 11)
+        return firstTouchOn(std::atoi(text.c_str() + 11));
+    return -1;
+}
+
+long mbind(void *addr, size_t len, int mode, const std::vector<int> &nodes) {
+#if defined(__linux__) && defined(SYS_mbind)
+    unsigned long mask[16] = {0};
+    for (int node : nodes) {
+        if (node >= 0 && node < (int)(sizeof(mask) * 8))
+            mask[node / (sizeof(unsigned long) * 8)] |= 1ul << (node % (sizeof(unsigned long) * 8));
+    }
+    return syscall(SYS_mbind, addr, len, mode, mask, sizeof(mask) * 8, 0);
+#else
+    (void)addr, (void)len, (void)mode, (void)nodes;
+    return -1;
+#endif
+}
+
+NumaPolicy::NumaPolicy(int placement_, const std::vector<NumaNode> &nodes)
+    : placement(placement_)
+    , mode(0)
+    , threadNode(nodeOfCpu(nodes, getCurrentCore()))
+    , touchCpu(-1) {
+    static const int MpolBind = 2, MpolInterleave = 3;
+
+    std::vector<int> withMemory;
+    for (auto &node : nodes) {
+        if (node.memTotal > 0 || nodes.size() == 1)
+            withMemory.push_back(node.id);
+    }
+
+    std::string name;
+    if (placement == PlaceLocal) {
+        name = "local";
+        mode = MpolBind;
+        memoryNodes = {threadNode};
+    } else if (placement == PlaceRemote) {
+        name = "remote";
+        mode = MpolBind;
+        for (int node : withMemory) {
+            if (node != threadNode) {
+                memoryNodes = {node};
+                break;
+            }
+        }
+        if (memoryNodes.empty()) {
+            name = "remote unavailable, local";
+            memoryNodes = {threadNode};
+        }
+    } else if (placement == PlaceInterleave) {
+        name = "interleave";
+        mode = MpolInterleave;
+        memoryNodes = withMemory;
+    } else if (placement >= PlaceFirstTouch) {
+        touchCpu = placement - PlaceFirstTouch;
+        name = "first touch on cpu " + std::to_string(touchCpu);
+        memoryNodes = {nodeOfCpu(nodes, touchCpu)};
+    } else {
+        name = "default";
+    }
+
+    description = name;
+    if (!memoryNodes.empty())
+        description += ", memory node" + std::string(memoryNodes.size() > 1 ? "s " : " ") +
+                       formatCpuList(memoryNodes);
+    description += ", thread node " + std::to_string(threadNode);
+}
+
+bool NumaPolicy::bind(void *p, size_t size) const {
+    return mode == 0 || mbind(p, size, mode, memoryNodes) == 0;
+}
+
+void NumaPolicy::touch(void *p, size_t size) const {
+    if (touchCpu < 0)
+        return;
+    int cpu = touchCpu;
+    std::thread toucher([p, size, cpu]() {
+        pinCurrentThread(cpu);
+        std::memset(p, 0, size);
+    });
+    toucher.join();
+}
+
+}} //namespaces
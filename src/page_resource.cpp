@@ -0,0 +1,180 @@
+#include <benchmark/detail/page_resource.h>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#ifndef WIN32
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace benchmark {
+namespace detail {
+
+int parseBacking(const std::string &text) {
+    static const char *names[] = {"default", "4k", "thp", "2m", "1g", "populate"};
+    for (int i = 0; i < (int)(sizeof(names) / sizeof(names[0])); i++) {
+        if (text == names[i])
+            return i;
+    }
+    return -1;
+}
+
+const char *backingName(int backing) {
+    switch (backing) {
+        case Backing4K: return "4K pages";
+        case BackingTHP: return "THP";
+        case BackingHuge2M: return "2M pages";
+        case BackingHuge1G: return "1G pages";
+        case BackingPopulate: return "populated";
+    }
+    return "default pages";
+}
+
+size_t PageResource::pageSize() const {
+    if (_backing == BackingHuge1G && !_fellBack)
+        return (size_t)1 << 30;
+    if (_backing == BackingHuge2M || _backing == BackingTHP)
+        return HugePage2M;
+#ifndef WIN32
+    return (size_t)sysconf(_SC_PAGESIZE);
+#else
+    return 4096;
+#endif
+}
+
+#ifndef WIN32
+void *PageResource::mapAligned(size_t size, size_t alignment, int flags) {
+    size_t mapped = size + alignment;
+    char *p = (char *)::mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | flags, -1, 0);
+    if (p == MAP_FAILED)
+        return nullptr;
+    char *aligned = (char *)(((uintptr_t)p + alignment - 1) / alignment * alignment);
+    if (aligned > p)
+        ::munmap(p, (size_t)(aligned - p));
+    if (aligned + size < p + mapped)
+        ::munmap(aligned + size, (size_t)(p + mapped - aligned - size));
+    return aligned;
+}
+
+void *PageResource::mapHuge(size_t wanted, size_t &size) {
+#if defined(MAP_HUGETLB)
+    if (!_fellBack) {
+        int flags = MAP_HUGETLB;
+#if defined(MAP_HUGE_SHIFT)
+        flags |= (_backing == BackingHuge1G ? 30 : 21) << MAP_HUGE_SHIFT;
+#endif
+        void *p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | flags, -1, 0);
+        if (p != MAP_FAILED)
+            return p;
+    }
+#endif
+    // not reserved (ENOMEM) or not supported, transparent huge pages are the next best thing
+    _fellBack = true;
+    size = (wanted + HugePage2M - 1) / HugePage2M * HugePage2M;
+    void *thp = mapAligned(size, HugePage2M, 0);
+#if defined(MADV_HUGEPAGE)
+    if (thp)
+        ::madvise(thp, size, MADV_HUGEPAGE);
+#endif
+    return thp;
+}
+#endif
+
+PageResource::Chunk PageResource::mapChunk(size_t size) {
+    size_t wanted = size;
+    size_t page = pageSize();
+    size = (wanted + page - 1) / page * page;
+
+    // pages faulted in by mmap are placed before mbind applies, with a policy they are touched afterwards
+    bool populate = _backing == BackingPopulate && _policy.touchCpu < 0;
+#ifndef WIN32
+    void *p = nullptr;
+    if (_backing == BackingHuge2M || _backing == BackingHuge1G) {
+        p = mapHuge(wanted, size);
+    } else if (_backing == BackingTHP) {
+        p = mapAligned(size, HugePage2M, 0);
+#if defined(MADV_HUGEPAGE)
+        if (p)
+            ::madvise(p, size, MADV_HUGEPAGE);
+#endif
+    } else {
+        int flags = 0;
+#if defined(MAP_POPULATE)
+        if (populate && _policy.mode == 0) {
+            flags = MAP_POPULATE;
+            populate = false;
+        }
+#endif
+        p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | flags, -1, 0);
+        if (p == MAP_FAILED)
+            p = nullptr;
+#if defined(MADV_NOHUGEPAGE)
+        if (p && _backing == Backing4K)
+            ::madvise(p, size, MADV_NOHUGEPAGE);
+#endif
+    }
+    if (!p)
+        throw std::bad_alloc();
+#else
+    void *p = std::malloc(size);
+    if (!p)
+        throw std::bad_alloc();
+#endif
+    if (!_policy.bind(p, size))
+        _bindFailed = true;
+
+    _policy.touch(p, size);
+    if (populate)
+        std::memset(p, 0, size);
+    return Chunk{(char *)p, size};
+}
+
+PageResource::PageResource(int placement, int backing, const std::vector<NumaNode> &nodes)
+    : _policy(placement, nodes)
+    , _backing(backing) {
+#if !defined(WIN32) && defined(MAP_HUGETLB)
+    // a single page tells whether any are reserved, so that the title says so before the first sample
+    if (backing == BackingHuge2M || backing == BackingHuge1G) {
+        size_t page = pageSize();
+        int flags = MAP_HUGETLB;
+#if defined(MAP_HUGE_SHIFT)
+        flags |= (backing == BackingHuge1G ? 30 : 21) << MAP_HUGE_SHIFT;
+#endif
+        void *p = ::mmap(nullptr, page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | flags, -1, 0);
+        if (p == MAP_FAILED)
+            _fellBack = true;
+        else
+            ::munmap(p, page);
+    }
+#else
+    if (backing == BackingHuge2M || backing == BackingHuge1G)
+        _fellBack = true;
+#endif
+}
+
+PageResource::~PageResource() {
+    for (auto &chunk : _chunks) {
+#ifndef WIN32
+        ::munmap(chunk.data, chunk.size);
+#else
+        std::free(chunk.data);
+#endif
+    }
+}
+
+std::string PageResource::description() const {
+    std::string result = _policy.description;
+    if (_bindFailed)
+        result += " (mbind failed, default policy)";
+    if (_backing != BackingDefault) {
+        result += ", ";
+        result += backingName(_backing);
+        if (_fellBack)
+            result += " not reserved, THP";
+    }
+    return result;
+}
+
+}} //namespaces
@@ -0,0 +1,123 @@
+#include <benchmark/detail/paired_comparison.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace benchmark {
+namespace detail {
+
+double medianOf(std::vector<double> values) {
+    if (values.empty())
+        return NAN;
+    size_t n = values.size();
+    std::nth_element(values.begin(), values.begin() + n / 2, values.end());
+    double upper = values[n / 2];
+    if (n % 2)
+        return upper;
+    return (*std::max_element(values.begin(), values.begin() + n / 2) + upper) / 2;
+}
+
+double wilcoxonSignedRank(const std::vector<double> &differences) {
+    std::vector<double> magnitudes;
+    for (double d : differences) {
+        if (d != 0)
+            magnitudes.push_back(d);
+    }
+    size_t n = magnitudes.size();
+    if (n == 0)
+        return 1.0;
+    std::sort(magnitudes.begin(), magnitudes.end(), [](double a, double b) { return std::fabs(a) < std::fabs(b); });
+
+    double positive = 0, ties = 0;
+    for (size_t i = 0; i < n;) {
+        size_t j = i;
+        while (j < n && std::fabs(magnitudes[j]) == std::fabs(magnitudes[i]))
+            j++;
+        double rank = (double)(i + j + 1) / 2; // ranks i+1..j
+        for (size_t k = i; k < j; k++) {
+            if (magnitudes[k] > 0)
+                positive += rank;
+        }
+        double t = (double)(j - i);
+        ties += t * t * t - t;
+        i = j;
+    }
+
+    double mean = (double)n * (n + 1) / 4;
+    double variance = (double)n * (n + 1) * (2 * n + 1) / 24 - ties / 48;
+    if (variance <= 0)
+        return 1.0;
+    double deviation = std::fabs(positive - mean) - 0.5; // continuity correction
+    double z = std::max(deviation, 0.0) / std::sqrt(variance);
+    return std::min(1.0, 2 * (1 - normalCdf(z)));
+}
+
+PairedComparison comparePaired(const std::vector<double> &a, const std::vector<double> &b,
+                               unsigned resamples, double confidence, uint64_t seed) {
+    PairedComparison result{std::min(a.size(), b.size()), NAN, ConfidenceInterval{0, 0, false}, 1.0};
+    if (result.pairs == 0)
+        return result;
+
+    std::vector<double> differences(result.pairs);
+    for (size_t i = 0; i < result.pairs; i++)
+        differences[i] = a[i] - b[i];
+    result.pValue = wilcoxonSignedRank(differences);
+
+    double medianB = medianOf(std::vector<double>(b.begin(), b.begin() + result.pairs));
+    result.ratio = medianOf(std::vector<double>(a.begin(), a.begin() + result.pairs)) / medianB;
+    if (result.pairs < 2 || resamples == 0)
+        return result;
+
+    FastRandom random(seed);
+    std::vector<double> ratios(resamples), sampleA(result.pairs), sampleB(result.pairs);
+    for (auto &ratio : ratios) {
+        for (size_t i = 0; i < result.pairs; i++) {
+            uint32_t pair = random.below((uint32_t)result.pairs);
+            sampleA[i] = a[pair];
+            sampleB[i] = b[pair];
+        }
+        ratio = medianOf(sampleA) / medianOf(sampleB);
+    }
+    std::sort(ratios.begin(), ratios.end());
+    double alpha = (1 - confidence) / 2;
+    size_t lower = (size_t)(alpha * (resamples - 1));
+    size_t upper = std::min((size_t)std::ceil((1 - alpha) * (resamples - 1)), ratios.size() - 1);
+    result.interval = ConfidenceInterval{ratios[lower], ratios[upper],
+                                         std::isfinite(ratios[lower]) && std::isfinite(ratios[upper])};
+    return result;
+}
+
+bool significant(const PairedComparison &comparison, double alpha) {
+    return comparison.pValue < alpha && comparison.interval.valid &&
+           (comparison.interval.lower > 1 || comparison.interval.upper < 1);
+}
+
+std::string comparisonVerdict(const std::string &a, const std::string &b, const PairedComparison &comparison) {
+    double factor = comparison.ratio, lower = comparison.interval.lower, upper = comparison.interval.upper;
+    bool faster = factor >= 1;
+    if (!faster) {
+        factor = 1 / comparison.ratio;
+        lower = 1 / comparison.interval.upper;
+        upper = 1 / comparison.interval.lower;
+    }
+    double spread = comparison.interval.valid ? std::max(upper - factor, factor - lower) : NAN;
+
+    char p[32];
+    if (comparison.pValue < 0.001)
+        std::snprintf(p, sizeof(p), "p < 0.001");
+    else
+        std::snprintf(p, sizeof(p), "p = %.3g", comparison.pValue);
+
+    char buf[256];
+    if (significant(comparison))
+        std::snprintf(buf, sizeof(buf), "%s is %.2fx %s ±%.2f (%s)", b.c_str(), factor, faster ? "faster" : "slower",
+                      spread, p);
+    else
+        std::snprintf(buf, sizeof(buf), "no significant difference between %s and %s (%.2fx ±%.2f, %s)", a.c_str(),
+                      b.c_str(), comparison.ratio,
+                      comparison.interval.valid ? std::max(comparison.interval.upper - comparison.ratio,
+                                                           comparison.ratio - comparison.interval.lower) : NAN, p);
+    return buf;
+}
+
+}} //namespaces
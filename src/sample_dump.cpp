@@ -0,0 +1,207 @@
+#include <benchmark/detail/sample_dump.h>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <benchmark/detail/cpu_info.h>
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace benchmark {
+namespace detail {
+
+SampleDump::SampleDump(const std::string &path, uint64_t capacity)
+    : _path(path)
+    , _origin(clock_t::now()) {
+#ifndef WIN32
+    static const struct {
+        const char *name;
+        uint32_t type;
+    } columns[DumpCounter0] = {
+        {"timestamp_ns", ColumnInt64}, {"duration_ns", ColumnInt64}, {"raw_duration_ns", ColumnInt64},
+        {"block", ColumnUInt32},       {"core", ColumnInt32},        {"frequency_khz", ColumnUInt32}};
+
+    if (capacity == 0)
+        capacity = 1;
+
+    size_t size = sizeof(SampleDumpHeader);
+    for (unsigned c = 0; c < DumpColumnCount; c++)
+        size += capacity * columnTypeSize(c < DumpCounter0 ? columns[c].type : ColumnDouble);
+
+    _fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (_fd < 0 || ::ftruncate(_fd, (off_t)size) != 0) {
+        std::cerr << "Couldn't create '" << path << "'\n";
+        close();
+        return;
+    }
+    void *mapped = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "Couldn't map '" << path << "'\n";
+        close();
+        return;
+    }
+    _mapped = (char *)mapped;
+    _mappedSize = size;
+
+    _header = (SampleDumpHeader *)_mapped;
+    std::memcpy(_header->magic, "BMSAMPL", 8);
+    _header->version = 1;
+    _header->columnCount = DumpColumnCount;
+    _header->capacity = capacity;
+    _header->startTime =
+        (int64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+
+    uint64_t offset = sizeof(SampleDumpHeader);
+    for (unsigned c = 0; c < DumpColumnCount; c++) {
+        if (c < DumpCounter0) {
+            setColumn(_header->columns[c], columns[c].name, columns[c].type, offset);
+        } else {
+            char name[16];
+            std::snprintf(name, sizeof(name), "counter%u", c - DumpCounter0);
+            setColumn(_header->columns[c], name, ColumnDouble, offset);
+        }
+        offset += capacity * columnTypeSize(_header->columns[c].type);
+    }
+
+    // the core may change between samples, every frequency file is opened in advance
+    int cores = getCPUCoresNum();
+    _freqFds.assign((size_t)cores, -1);
+    for (int core = 0; core < cores; core++) {
+        char freqPath[128];
+        std::snprintf(freqPath, sizeof(freqPath), "/sys/devices/system/cpu/cpu%d/cpufreq/scaling_cur_freq", core);
+        _freqFds[core] = ::open(freqPath, O_RDONLY);
+    }
+    _counters.reserve(MaxCounters);
+#else
+    (void)capacity;
+    std::cerr << "Sample dumps aren't supported on this platform\n";
+#endif
+}
+
+void SampleDump::setColumn(SampleDumpColumn &column, const char *name, uint32_t type, uint64_t offset) {
+    std::memset(&column, 0, sizeof(column));
+    std::strncpy(column.name, name, sizeof(column.name) - 1);
+    column.type = type;
+    column.offset = offset;
+}
+
+uint32_t SampleDump::readFrequency(int core) const {
+#ifndef WIN32
+    if (core < 0 || (size_t)core >= _freqFds.size() || _freqFds[core] < 0)
+        return 0;
+    char buf[32];
+    ssize_t n = ::pread(_freqFds[core], buf, sizeof(buf), 0);
+    uint32_t result = 0;
+    for (ssize_t i = 0; i < n && buf[i] >= '0' && buf[i] <= '9'; i++)
+        result = result * 10 + (uint32_t)(buf[i] - '0');
+    return result;
+#else
+    return 0;
+#endif
+}
+
+uint32_t SampleDump::beginBlock(const std::string &name) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (size_t i = 0; i < _blocks.size(); i++) {
+        if (_blocks[i] == name)
+            return (uint32_t)i;
+    }
+    _blocks.push_back(name);
+    return (uint32_t)(_blocks.size() - 1);
+}
+
+void SampleDump::record(uint32_t block, const RunState &state, duration_t sample) {
+    if (!_header)
+        return;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    uint64_t row = _header->rows;
+    if (row >= _header->capacity) {
+        _header->dropped++;
+        return;
+    }
+
+    column<int64_t>(DumpTimestamp)[row] =
+        (int64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(state.startTime() - _origin).count();
+    column<int64_t>(DumpDuration)[row] = (int64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(sample).count();
+    column<int64_t>(DumpRawDuration)[row] =
+        (int64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(state.rawDuration()).count();
+    column<uint32_t>(DumpBlock)[row] = block;
+    int core = getCurrentCore();
+    column<int32_t>(DumpCore)[row] = core;
+    column<uint32_t>(DumpFrequency)[row] = readFrequency(core);
+
+    for (unsigned c = 0; c < MaxCounters; c++)
+        column<double>(DumpCounter0 + c)[row] = NAN;
+    for (auto &counter : state.counters()) {
+        size_t slot = 0;
+        while (slot < _counters.size() && _counters[slot] != counter.first)
+            slot++;
+        if (slot == _counters.size()) {
+            if (slot == MaxCounters)
+                continue; // no column left for it
+            _counters.push_back(counter.first);
+        }
+        column<double>(DumpCounter0 + (unsigned)slot)[row] = counter.second;
+    }
+
+    _header->rows = row + 1;
+}
+
+void SampleDump::close() {
+#ifndef WIN32
+    for (int fd : _freqFds) {
+        if (fd >= 0)
+            ::close(fd);
+    }
+    _freqFds.clear();
+
+    if (_header) {
+        uint64_t rows = _header->rows;
+        uint64_t offset = sizeof(SampleDumpHeader);
+        for (unsigned c = 0; c < _header->columnCount; c++) {
+            SampleDumpColumn &col = _header->columns[c];
+            size_t bytes = rows * columnTypeSize(col.type);
+            std::memmove(_mapped + offset, _mapped + col.offset, bytes); // never moves forward
+            col.offset = offset;
+            offset += bytes;
+        }
+        for (size_t c = _counters.size(); c < MaxCounters; c++) {
+            _counters.push_back("");
+        }
+
+        std::string names;
+        for (auto &name : _blocks)
+            names.append(name.c_str(), name.size() + 1);
+        for (auto &name : _counters)
+            names.append(name.c_str(), name.size() + 1);
+
+        _header->namesOffset = offset;
+        _header->namesSize = (uint32_t)names.size();
+        _header->blockCount = (uint32_t)_blocks.size();
+        _header->counterCount = MaxCounters;
+        _header->closed = 1;
+
+        ::munmap(_mapped, _mappedSize);
+        _mapped = nullptr;
+        _header = nullptr;
+
+        bool ok = ::ftruncate(_fd, (off_t)offset) == 0 &&
+                  ::pwrite(_fd, names.data(), names.size(), (off_t)offset) == (ssize_t)names.size();
+        if (!ok)
+            std::cerr << "Couldn't write to '" << _path << "'\n";
+    }
+    if (_fd >= 0) {
+        ::close(_fd);
+        _fd = -1;
+    }
+#endif
+}
+
+}} //namespaces
@@ -0,0 +1,288 @@
+#include <benchmark/detail/statistics.h>
+#include <algorithm>
+#include <cmath>
+
+void TimeStatistics::calculateStats() {
+    _totalSum = benchmark::duration_t(0);
+    for (auto sample : _samples) {
+        _totalSum += sample;
+    }
+    _minimum = _samples.front();
+    _maximum = _samples.back();
+
+    // average and standard deviation without the severe outliers, which are at the ends of the sorted samples
+    size_t from = _outliers.lowSevere, to = _samples.size() - _outliers.highSevere;
+    _average = benchmark::duration_t(0);
+    for (size_t i = from; i < to; i++) {
+        _average += _samples[i];
+    }
+    _average /= (to - from);
+
+    auto averageNs = std::chrono::duration_cast<std::chrono::nanoseconds>(_average).count();
+    unsigned long long sumOfSquares = 0;
+    for (size_t i = from; i < to; i++) {
+        auto sampleNs = _samples[i].count();
+        auto d = (sampleNs > averageNs) ? (sampleNs - averageNs) : (averageNs - sampleNs);
+        sumOfSquares += d * d;
+    }
+    sumOfSquares /= (to - from);
+    long long stdDevNs = llround(sqrt((double)sumOfSquares));
+    _stdDev = std::chrono::nanoseconds(stdDevNs);
+
+    // median
+    if (_samples.size() % 2 == 1) {
+        _median = _samples[_samples.size() / 2];
+    } else {
+        auto j = _samples.size() / 2;
+        _median = _samples[j-1] / 2 + _samples[j] / 2;
+    }
+}
+
+double TimeStatistics::quantile(const std::vector<benchmark::duration_t> &sorted, double q) {
+    double pos = q * (double)(sorted.size() - 1);
+    size_t lo = (size_t)pos;
+    if (lo + 1 >= sorted.size())
+        return (double)sorted.back().count();
+    double frac = pos - (double)lo;
+    return (double)sorted[lo].count() * (1.0 - frac) + (double)sorted[lo + 1].count() * frac;
+}
+
+bool TimeStatistics::classifyOutliers() {
+    _outliers = OutlierCounts{0, 0, 0, 0};
+    if (_outlierMethod == OutliersNone || _samples.size() < 3)
+        return false;
+
+    double mildLow, mildHigh, severeLow, severeHigh;
+    if (_outlierMethod == OutliersTukey) {
+        double q1 = quantile(_samples, 0.25);
+        double q3 = quantile(_samples, 0.75);
+        double iqr = q3 - q1;
+        if (iqr <= 0.0) // more than a half of samples are equal, nothing to compare with
+            return false;
+
+        mildLow = q1 - 1.5 * iqr;
+        mildHigh = q3 + 1.5 * iqr;
+        severeLow = q1 - 3.0 * iqr;
+        severeHigh = q3 + 3.0 * iqr;
+    } else {
+        double median = quantile(_samples, 0.5);
+        std::vector<double> deviations;
+        deviations.reserve(_samples.size());
+        for (auto sample : _samples) {
+            deviations.push_back(std::fabs((double)sample.count() - median));
+        }
+        std::nth_element(deviations.begin(), deviations.begin() + deviations.size() / 2, deviations.end());
+        double mad = deviations[deviations.size() / 2] * 1.4826; // consistent with stddev for normal distribution
+        if (mad <= 0.0)
+            return false;
+
+        mildLow = median - 3.0 * mad;
+        mildHigh = median + 3.0 * mad;
+        severeLow = median - 5.0 * mad;
+        severeHigh = median + 5.0 * mad;
+    }
+
+    for (auto s : _samples) {
+        double sample = (double)s.count();
+        if (sample < severeLow) {
+            _outliers.lowSevere++;
+        } else if (sample < mildLow) {
+            _outliers.lowMild++;
+        } else if (sample > severeHigh) {
+            _outliers.highSevere++;
+        } else if (sample > mildHigh) {
+            _outliers.highMild++;
+        }
+    }
+    return _outliers.total() > 0;
+}
+
+void TimeStatistics::calculateIntervals() {
+    std::vector<double> sorted;
+    sorted.reserve(_samples.size());
+    for (auto sample : _samples) {
+        sorted.push_back((double)sample.count());
+    }
+
+    std::vector<double> quantiles{0.5};
+    for (int nth : _percentiles) {
+        quantiles.push_back((double)nth / 100.0);
+    }
+
+    auto intervals = benchmark::detail::Bootstrap(sorted, quantiles, _bootstrap).run();
+    _meanInterval = intervals[0];
+    _medianInterval = intervals[1];
+    _percentileIntervals.assign(intervals.begin() + 2, intervals.end());
+
+    // the mean is of the samples without the severe outliers, and so is its interval
+    if (_outliers.lowSevere + _outliers.highSevere > 0) {
+        std::vector<double> trimmed(sorted.begin() + _outliers.lowSevere, sorted.end() - _outliers.highSevere);
+        std::vector<double> none;
+        _meanInterval = benchmark::detail::Bootstrap(trimmed, none, _bootstrap).run()[0];
+    }
+}
+
+void TimeStatistics::detectModes() {
+    static const int Bins = 512;
+    static const double MinValleyRatio = 0.7; // valley must be lower than this part of the smaller peak
+    static const double MinModeShare = 0.05;
+    static const size_t MinModeSamples = 5;
+
+    _modes.clear();
+    size_t n = _samples.size();
+    if (n < MinSamplesForModes)
+        return;
+
+    double lo = (double)_samples.front().count();
+    double hi = (double)_samples.back().count();
+
+    double mean = 0.0;
+    for (auto sample : _samples) {
+        mean += (double)sample.count();
+    }
+    mean /= (double)n;
+    double variance = 0.0;
+    for (auto sample : _samples) {
+        double d = (double)sample.count() - mean;
+        variance += d * d;
+    }
+    double sigma = std::sqrt(variance / (double)n);
+    double iqr = quantile(_samples, 0.75) - quantile(_samples, 0.25);
+    double spread = (iqr > 0.0) ? std::min(sigma, iqr / 1.34) : sigma;
+    double bandwidth = 0.9 * spread * std::pow((double)n, -0.2);
+    if (bandwidth <= 0.0 || hi <= lo)
+        return;
+
+    double binWidth = (hi - lo) / (Bins - 1);
+    std::vector<double> counts(Bins, 0.0);
+    for (auto sample : _samples) {
+        counts[(size_t)(((double)sample.count() - lo) / binWidth + 0.5)] += 1.0;
+    }
+
+    int radius = std::min(Bins, (int)std::ceil(4.0 * bandwidth / binWidth));
+    std::vector<double> kernel((size_t)radius + 1);
+    for (int k = 0; k <= radius; k++) {
+        double u = k * binWidth / bandwidth;
+        kernel[k] = std::exp(-0.5 * u * u);
+    }
+
+    std::vector<double> density(Bins, 0.0);
+    for (int i = 0; i < Bins; i++) {
+        if (counts[i] == 0.0)
+            continue;
+        int from = std::max(0, i - radius), to = std::min(Bins - 1, i + radius);
+        for (int j = from; j <= to; j++) {
+            density[j] += counts[i] * kernel[std::abs(j - i)];
+        }
+    }
+
+    // local maxima, a plateau counts once
+    std::vector<int> peaks;
+    for (int i = 0; i < Bins; i++) {
+        bool risesFromLeft = i == 0 || density[i] > density[i - 1];
+        if (!risesFromLeft)
+            continue;
+        int j = i;
+        while (j + 1 < Bins && density[j + 1] == density[i])
+            j++;
+        if (j == Bins - 1 || density[j + 1] < density[i])
+            peaks.push_back((i + j) / 2);
+    }
+
+    auto valleyBetween = [&](int left, int right) {
+        int valley = left;
+        for (int k = left; k <= right; k++) {
+            if (density[k] < density[valley])
+                valley = k;
+        }
+        return valley;
+    };
+
+    bool merged = true;
+    while (merged && peaks.size() > 1) {
+        merged = false;
+        for (size_t p = 0; p + 1 < peaks.size(); p++) {
+            double smaller = std::min(density[peaks[p]], density[peaks[p + 1]]);
+            if (density[valleyBetween(peaks[p], peaks[p + 1])] > smaller * MinValleyRatio) {
+                peaks.erase(peaks.begin() + (density[peaks[p]] >= density[peaks[p + 1]] ? p + 1 : p));
+                merged = true;
+                break;
+            }
+        }
+    }
+
+    // attribute samples to the basins between valleys, then drop the tiny ones
+    while (true) {
+        std::vector<double> bounds; // upper bound of every basin but the last one
+        for (size_t p = 0; p + 1 < peaks.size(); p++) {
+            bounds.push_back(lo + valleyBetween(peaks[p], peaks[p + 1]) * binWidth);
+        }
+
+        _modes.clear();
+        size_t first = 0;
+        for (size_t p = 0; p < peaks.size(); p++) {
+            size_t last = first;
+            while (last < n && (p == bounds.size() || (double)_samples[last].count() <= bounds[p]))
+                last++;
+
+            Mode mode;
+            mode.location = benchmark::duration_t((long long)std::llround(lo + peaks[p] * binWidth));
+            mode.samples = last - first;
+            mode.share = (double)mode.samples / (double)n;
+            if (mode.samples > 0) {
+                mode.median = _samples[first + mode.samples / 2];
+                mode.low = _samples[first];
+                mode.high = _samples[last - 1];
+            }
+            _modes.push_back(mode);
+            first = last;
+        }
+
+        auto smallest = std::min_element(_modes.begin(), _modes.end(),
+            [](const Mode &a, const Mode &b) { return a.share < b.share; });
+        if (_modes.size() < 2 || (smallest->share >= MinModeShare && smallest->samples >= MinModeSamples))
+            break;
+        peaks.erase(peaks.begin() + (smallest - _modes.begin()));
+    }
+
+    if (_modes.size() < 2) {
+        _modes.clear();
+    }
+}
+
+void TimeStatistics::discardFirst(size_t count) {
+    _samples.erase(_samples.begin(), _samples.begin() + std::min(count, _samples.size()));
+}
+
+void TimeStatistics::clear() {
+    _samples.clear();
+    _modes.clear();
+    _outliers = OutlierCounts{0, 0, 0, 0};
+}
+
+bool TimeStatistics::calculate() {
+    if (_samples.empty())
+        return false;
+
+    // modes and quantiles are of the whole data set: a minor mode or a slow path is not an outlier
+    std::sort(_samples.begin(), _samples.end());
+    detectModes();
+
+    classifyOutliers();
+    calculateStats();
+    calculateIntervals();
+    return true;
+}
+
+benchmark::duration_t TimeStatistics::percentile(int nth) const {
+    // the estimator the bootstrap intervals are of
+    return benchmark::duration_t((long long)std::llround(quantile(_samples, (double)nth / 100.0)));
+}
+
+benchmark::detail::ConfidenceInterval TimeStatistics::percentileInterval(int nth) const {
+    for (size_t i = 0; i < _percentiles.size() && i < _percentileIntervals.size(); i++) {
+        if (_percentiles[i] == nth)
+            return _percentileIntervals[i];
+    }
+    return benchmark::detail::ConfidenceInterval{0.0, 0.0, false};
+}
@@ -0,0 +1,63 @@
+#include <benchmark/detail/steady_state.h>
+
+namespace benchmark {
+namespace detail {
+
+size_t SteadyStateDetector::truncationPoint() const {
+    size_t k = _batchMeans.size();
+    double sum = 0.0, sumOfSquares = 0.0;
+    double best = -1.0;
+    size_t bestD = 0;
+
+    // suffix sums, going from the end
+    std::vector<double> mser(k, 0.0);
+    for (size_t j = k; j-- > 0;) {
+        sum += _batchMeans[j];
+        sumOfSquares += _batchMeans[j] * _batchMeans[j];
+        double n = (double)(k - j);
+        double variance = sumOfSquares - sum * sum / n; // sum of squared deviations
+        mser[j] = variance / (n * n);
+    }
+    for (size_t d = 0; d <= k / 2; d++) {
+        if (best < 0.0 || mser[d] < best) {
+            best = mser[d];
+            bestD = d;
+        }
+    }
+    return bestD;
+}
+
+bool SteadyStateDetector::add(duration_t sample) {
+    _samples.push_back(sample);
+    if (_samples.size() % BatchSize != 0)
+        return _steady;
+
+    double batchSum = 0.0;
+    for (size_t i = _samples.size() - BatchSize; i < _samples.size(); i++) {
+        batchSum += (double)_samples[i].count();
+    }
+    _batchMeans.push_back(batchSum / BatchSize);
+
+    if (!_steady && _batchMeans.size() >= MinBatches && truncationPoint() < _batchMeans.size() / 2) {
+        _steady = true;
+        _steadySince = _samples.size();
+    }
+    return _steady;
+}
+
+size_t SteadyStateDetector::warmupSamples() const {
+    if (!_steady)
+        return 0;
+    return truncationPoint() * BatchSize;
+}
+
+duration_t SteadyStateDetector::warmupTime() const {
+    duration_t result{0};
+    size_t n = warmupSamples();
+    for (size_t i = 0; i < n; i++) {
+        result += _samples[i];
+    }
+    return result;
+}
+
+}} //namespaces
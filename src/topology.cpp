@@ -0,0 +1,185 @@
+#include <benchmark/detail/topology.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+#ifndef WIN32
+#include <sched.h>
+#endif
+
+namespace benchmark {
+namespace detail {
+
+std::vector<int> parseCpuList(const std::string &text) {
+    std::vector<int> result;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t end = text.find(',', pos);
+        if (end == std::string::npos)
+            end = text.size();
+        std::string item = text.substr(pos, end - pos);
+        size_t dash = item.find('-');
+        if (!item.empty() && item[0] >= '0' && item[0] <= '9') {
+            int from = std::atoi(item.c_str());
+            int to = dash == std::string::npos ? from : std::atoi(item.c_str() + dash + 1);
+            for (int cpu = from; cpu <= to; cpu++)
+                result.push_back(cpu);
+        }
+        pos = end + 1;
+    }
+    return result;
+}
+
+std::string formatCpuList(std::vector<int> cpus) {
+    std::sort(cpus.begin(), cpus.end());
+    std::string result;
+    for (size_t i = 0; i < cpus.size();) {
+        size_t j = i;
+        while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1)
+            j++;
+        result += (result.empty() ? "" : ",") + std::to_string(cpus[i]);
+        if (j > i)
+            result += "-" + std::to_string(cpus[j]);
+        i = j + 1;
+    }
+    return result;
+}
+
+std::string CorePartition::label() const {
+    return "P" + std::to_string(index) + " [cpus " + formatCpuList(cpus) + ", L3 " + std::to_string(l3) + ", node " +
+           std::to_string(node) + "]";
+}
+
+std::string readSysfsLine(const std::string &path) {
+    std::string result;
+    FILE *fh = std::fopen(path.c_str(), "r");
+    if (!fh)
+        return result;
+    char buf[1024];
+    if (std::fgets(buf, sizeof(buf), fh))
+        result = buf;
+    std::fclose(fh);
+    while (!result.empty() && (result.back() == '\n' || result.back() == ' '))
+        result.pop_back();
+    return result;
+}
+
+std::vector<LogicalCpu> readTopology() {
+    std::vector<LogicalCpu> result;
+#if defined(__linux__)
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    bool haveAffinity = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+
+    std::vector<int> online = parseCpuList(readSysfsLine("/sys/devices/system/cpu/online"));
+    std::vector<int> nodeOfCpu;
+    for (int node = 0; node < 1024; node++) {
+        std::string nodeCpus = readSysfsLine("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        if (nodeCpus.empty()) {
+            if (node > 0)
+                break;
+            continue;
+        }
+        for (int cpu : parseCpuList(nodeCpus)) {
+            if ((size_t)cpu >= nodeOfCpu.size())
+                nodeOfCpu.resize((size_t)cpu + 1, 0);
+            nodeOfCpu[(size_t)cpu] = node;
+        }
+    }
+
+    for (int cpu : online) {
+        if (haveAffinity && (cpu >= CPU_SETSIZE || !CPU_ISSET(cpu, &allowed)))
+            continue;
+
+        std::string base = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+        LogicalCpu info;
+        info.cpu = cpu;
+        info.package = std::atoi(readSysfsLine(base + "/topology/physical_package_id").c_str());
+
+        // the first sibling identifies the core, core_id alone repeats over packages and has gaps
+        std::vector<int> siblings = parseCpuList(readSysfsLine(base + "/topology/thread_siblings_list"));
+        info.core = siblings.empty() ? cpu : *std::min_element(siblings.begin(), siblings.end());
+
+        // the highest cache index is the last level one
+        info.l3 = -1;
+        for (int index = 3; index >= 2 && info.l3 < 0; index--) {
+            std::vector<int> shared =
+                parseCpuList(readSysfsLine(base + "/cache/index" + std::to_string(index) + "/shared_cpu_list"));
+            if (!shared.empty())
+                info.l3 = *std::min_element(shared.begin(), shared.end());
+        }
+        if (info.l3 < 0)
+            info.l3 = info.package;
+
+        info.node = (size_t)cpu < nodeOfCpu.size() ? nodeOfCpu[(size_t)cpu] : 0;
+        result.push_back(info);
+    }
+#endif
+    if (result.empty()) {
+        result.push_back(LogicalCpu{0, 0, 0, 0, 0});
+    }
+    return result;
+}
+
+std::vector<CorePartition> partitionCores(const std::vector<LogicalCpu> &cpus, PartitionGranularity granularity) {
+    std::vector<CorePartition> result;
+    std::vector<int> keys;
+    for (auto &cpu : cpus) {
+        int key = granularity == PartitionCore ? cpu.core : (granularity == PartitionL3 ? cpu.l3 : cpu.node);
+        size_t index = (size_t)(std::find(keys.begin(), keys.end(), key) - keys.begin());
+        if (index == keys.size()) {
+            keys.push_back(key);
+            result.push_back(CorePartition{(unsigned)index, {}, cpu.l3, cpu.node});
+        }
+        result[index].cpus.push_back(cpu.cpu);
+    }
+
+    for (auto &partition : result) {
+        std::sort(partition.cpus.begin(), partition.cpus.end());
+    }
+    return result;
+}
+
+bool pinCurrentThread(int cpu) {
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+bool pinCurrentThread(const std::vector<int> &cpus) {
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE)
+            CPU_SET(cpu, &set);
+    }
+    return CPU_COUNT(&set) > 0 && sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    (void)cpus;
+    return false;
+#endif
+}
+
+std::vector<int> currentAffinity() {
+    std::vector<int> result;
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) != 0)
+        return result;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &set))
+            result.push_back(cpu);
+    }
+#endif
+    return result;
+}
+
+}} //namespaces
@@ -0,0 +1,98 @@
+#include <benchmark/detail/trace_writer.h>
+
+#ifndef WIN32
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace benchmark {
+namespace detail {
+
+void TraceWriter::writeEscaped(FILE *fh, const std::string &text) {
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            std::fputc('\\', fh);
+            std::fputc(c, fh);
+        } else if ((unsigned char)c < 0x20) {
+            std::fprintf(fh, "\\u%04x", (unsigned)c);
+        } else {
+            std::fputc(c, fh);
+        }
+    }
+}
+
+long TraceWriter::currentThreadId() {
+#if defined(__linux__)
+    return (long)syscall(SYS_gettid);
+#else
+    return 0;
+#endif
+}
+
+void TraceWriter::nameThread(const std::string &name) {
+    long tid = currentThreadId();
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (auto &thread : _threadNames) {
+        if (thread.first == tid) {
+            thread.second = name;
+            return;
+        }
+    }
+    _threadNames.emplace_back(tid, name);
+}
+
+void TraceWriter::addSample(const std::string &name, time_point_t start, duration_t duration, unsigned index) {
+    double dur = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count() / 1000.0;
+    add(Event{'X', name, timestamp(start), dur, currentThreadId(), "sample", (double)index});
+}
+
+void TraceWriter::addCounter(const std::string &name, time_point_t time, const std::string &valueName, double value) {
+    add(Event{'C', name, timestamp(time), 0.0, currentThreadId(), valueName, value});
+}
+
+void TraceWriter::addMarker(const std::string &name, time_point_t time) {
+    add(Event{'i', name, timestamp(time), 0.0, currentThreadId(), "", 0.0});
+}
+
+bool TraceWriter::save() {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    FILE *fh = std::fopen(_path.c_str(), "w");
+    if (!fh) {
+        std::fprintf(stderr, "Couldn't write the trace to '%s'\n", _path.c_str());
+        return false;
+    }
+
+    std::fprintf(fh, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    std::fprintf(fh, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"benchmark\"}}");
+    for (auto &thread : _threadNames) {
+        std::fprintf(fh, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%ld,\"args\":{\"name\":\"",
+                     thread.first);
+        writeEscaped(fh, thread.second);
+        std::fprintf(fh, "\"}}");
+    }
+
+    for (auto &event : _events) {
+        std::fprintf(fh, ",\n{\"name\":\"");
+        writeEscaped(fh, event.name);
+        std::fprintf(fh, "\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%ld", event.phase, event.ts, event.tid);
+
+        if (event.phase == 'X') {
+            std::fprintf(fh, ",\"dur\":%.3f,\"cat\":\"sample\"", event.dur);
+        } else if (event.phase == 'i') {
+            std::fprintf(fh, ",\"s\":\"g\",\"cat\":\"argument\"");
+        }
+
+        if (!event.argName.empty()) {
+            std::fprintf(fh, ",\"args\":{\"");
+            writeEscaped(fh, event.argName);
+            std::fprintf(fh, "\":%.17g}", event.argValue);
+        }
+        std::fprintf(fh, "}");
+    }
+    std::fprintf(fh, "\n]}\n");
+    std::fclose(fh);
+    return true;
+}
+
+}} //namespaces
@@ -0,0 +1,87 @@
+#include <benchmark/compat.h>
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <numeric>
+#include <vector>
+
+static void BM_Sum(benchmark::State &state) {
+    std::vector<int> values((size_t)state.range(0), 1);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(std::accumulate(values.begin(), values.end(), 0));
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.counters["values"] = benchmark::Counter((double)state.range(0), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_Sum)->RangeMultiplier(4)->Range(8, 512)->Iterations(100);
+
+static void BM_Pairs(benchmark::State &state) {
+    while (state.KeepRunning())
+        benchmark::ClobberMemory();
+}
+BENCHMARK(BM_Pairs)->ArgNames({"x", "y"})->Ranges({{1, 8}, {2, 4}})->Iterations(10);
+
+static void BM_Fails(benchmark::State &state) {
+    state.SkipWithError("no device");
+    for (auto _ : state)
+        ;
+}
+BENCHMARK(BM_Fails);
+
+static void BM_Scaled(benchmark::State &state, int factor) {
+    for (auto _ : state)
+        benchmark::DoNotOptimize(factor * 2);
+}
+BENCHMARK_CAPTURE(BM_Scaled, twice, 2)->Iterations(10);
+
+TEST(Compat, Registration)
+{
+    ASSERT_EQ(benchmark::internal::rangeValues(8, 512, 4), (std::vector<int64_t>{8, 16, 64, 256, 512}));
+    ASSERT_EQ(benchmark::internal::rangeValues(1, 8, 8), (std::vector<int64_t>{1, 8}));
+
+    auto &registrations = benchmark::internal::registrations();
+    ASSERT_EQ(registrations.size(), 4u);
+    ASSERT_EQ(registrations[0]->name(), "BM_Sum");
+    ASSERT_EQ(registrations[0]->args().size(), 5u);
+    ASSERT_EQ(registrations[1]->args().size(), 4u);
+    ASSERT_EQ(registrations[1]->instanceName(registrations[1]->args()[3]), "BM_Pairs/x:8/y:4");
+    ASSERT_EQ(registrations[2]->instanceName(registrations[2]->args()[0]), "BM_Fails");
+    ASSERT_EQ(registrations[3]->name(), "BM_Scaled/twice");
+
+    benchmark::Counter rate(100, benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+    ASSERT_DOUBLE_EQ(rate.finalValue(10, 2.0), 0.02);
+}
+
+TEST(Compat, Run)
+{
+    BenchmarkSetup setup;
+    setup.outputStyle = BenchmarkSetup::Nothing;
+    setup.skipWarmup = true;
+
+    auto &registration = *benchmark::internal::registrations()[0];
+    benchmark::internal::CompatBenchmark sum("BM_Sum/64", registration.function(), {64}, 100);
+    sum.setSetup(setup);
+    sum.vrun();
+    ASSERT_EQ(sum.results().size(), 1u);
+    // the items, 64 per iteration
+    ASSERT_EQ(sum.results()[0].operations, 6400u);
+    ASSERT_GT(sum.results()[0].median.count(), 0);
+    auto &counters = sum.results()[0].counters;
+    auto values = std::find_if(counters.begin(), counters.end(),
+                               [](const std::pair<std::string, double> &c) { return c.first == "values"; });
+    ASSERT_NE(values, counters.end());
+    ASSERT_DOUBLE_EQ(values->second, 0.64); // 64 averaged over the 100 iterations
+    ASSERT_EQ(counters.back().first, "items_per_second");
+    ASSERT_GT(counters.back().second, 0.0);
+
+    // calibrated to about a millisecond a sample, which takes more than one iteration
+    benchmark::internal::CompatBenchmark calibrated("BM_Sum/8", registration.function(), {8}, 0);
+    calibrated.setSetup(setup);
+    calibrated.vrun();
+    ASSERT_EQ(calibrated.results().size(), 1u);
+    ASSERT_GT(calibrated.results()[0].operations, 1u);
+
+    auto &fails = *benchmark::internal::registrations()[2];
+    benchmark::internal::CompatBenchmark skipped("BM_Fails", fails.function(), {}, 0);
+    skipped.setSetup(setup);
+    skipped.vrun();
+    ASSERT_TRUE(skipped.results().empty());
+}
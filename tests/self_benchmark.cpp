@@ -0,0 +1,306 @@
+#include <benchmark/benchmark.h>
+#include <benchmark/detail/history.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+/*
+Measures the harness itself: what a sample costs on top of the benchmarked code, how fast the statistics and the
+reporter get through large runs, and how close the reported times are to workloads of a known duration.
+
+Every cost is the best of a few repetitions and is held to a tight relative bound of the baseline of this machine:
+the median of its first BaselineRuns runs, in iterations of spin() so that a core clocked up or down since cancels
+out, recorded in a history file (self_benchmark.history in the working directory, BENCHMARK_SELF_HISTORY to put it
+elsewhere, SELF_BENCHMARK_HISTORY of CMake sets it for ctest). Delete the file to record a new baseline after an
+intended change.
+
+The baseline is per machine fingerprint, so the gate is local: a fresh build directory, or a CI runner without a
+history file kept between builds, only records and checks the absolute bounds, which catch what is off by an order of
+magnitude.
+*/
+
+using benchmark::detail::RunState;
+using benchmark::detail::HistoryLog;
+using benchmark::detail::HistoryRecord;
+
+namespace {
+
+double nanoseconds(benchmark::duration_t d) {
+    return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+}
+
+// one dependent multiply-add per iteration, the compiler can neither vectorize it nor compute it in closed form
+__attribute__((noinline)) uint64_t spin(uint64_t iterations, uint64_t seed) {
+    uint64_t x = seed;
+    for (uint64_t i = 0; i < iterations; i++) {
+        x = x * 6364136223846793005ull + 1442695040888963407ull;
+        benchmark::DoNotOptimize(x);
+    }
+    return x;
+}
+
+// ns per iteration of spin(), the median of many short chunks timed with the raw clock, like the harness reports:
+// a chunk is over before the scheduler gets to preempt most of them, the preempted ones only move the tail
+double spinCost() {
+    static const uint64_t Iterations = 100000;
+    static const int Chunks = 201;
+    std::vector<double> chunks;
+    for (int chunk = 0; chunk < Chunks; chunk++) {
+        auto start = benchmark::clock_t::now();
+        uint64_t x = spin(Iterations, chunk);
+        auto end = benchmark::clock_t::now();
+        benchmark::DoNotOptimize(x);
+        chunks.push_back(nanoseconds(end - start) / Iterations);
+    }
+    std::sort(chunks.begin(), chunks.end());
+    return chunks[chunks.size() / 2];
+}
+
+// ns per read of the clock
+double clockCost() {
+    static const unsigned Calls = 1000000;
+    auto start = benchmark::clock_t::now();
+    for (unsigned i = 0; i < Calls; i++) {
+        auto now = benchmark::clock_t::now();
+        benchmark::DoNotOptimize(now);
+    }
+    return nanoseconds(benchmark::clock_t::now() - start) / Calls;
+}
+
+// the lowest of a few repetitions, the one least disturbed by the rest of the machine
+template<typename F>
+double bestOf(unsigned repetitions, F &&measure) {
+    double best = measure();
+    for (unsigned i = 1; i < repetitions; i++)
+        best = std::min(best, measure());
+    return best;
+}
+
+const unsigned BaselineRuns = 5;
+
+std::string historyPath() {
+    const char *env = std::getenv("BENCHMARK_SELF_HISTORY");
+    return env && *env ? env : "self_benchmark.history";
+}
+
+// fails if the cost is more than the tolerance above the baseline, records it while there are fewer than BaselineRuns;
+// the cost is in iterations of spin(), by default timed right after it: the clock of the core moves between the tests
+void expectBaseline(const std::string &metric, double ns, double tolerance, double iterationNs = spinCost()) {
+    double cost = ns / iterationNs;
+    HistoryLog history(historyPath());
+    uint64_t machine = benchmark::detail::machineFingerprint();
+    std::vector<double> recorded;
+    if (std::ifstream(historyPath()).good()) {
+        history.read([&](const HistoryRecord &record) {
+            if (record.machine == machine && metric == record.name)
+                recorded.push_back(record.median);
+        });
+    }
+
+    if (!recorded.empty()) {
+        std::sort(recorded.begin(), recorded.end());
+        double baseline = recorded[recorded.size() / 2];
+        std::cout << "    " << metric << ": " << ns << " ns, baseline " << baseline * iterationNs << " ns ("
+                  << HistoryLog::percent(cost / baseline - 1.0) << ")" << std::endl;
+        EXPECT_LE(cost, baseline * (1.0 + tolerance)) << metric << " regressed against the baseline in '"
+                                                      << historyPath() << "'";
+        if (cost > baseline * (1.0 + tolerance))
+            return;
+    }
+    else {
+        std::cout << "    " << metric << ": " << ns << " ns, no baseline for this machine in '" << historyPath()
+                  << "' yet, recording it" << std::endl;
+    }
+    if (recorded.size() >= BaselineRuns)
+        return;
+
+    benchmark::detail::BenchmarkResult result{};
+    result.name = metric;
+    HistoryRecord record = HistoryLog::makeRecord(result, benchmark::detail::currentRevision(), machine,
+                                                  (int64_t)std::time(nullptr));
+    record.median = record.average = record.minimum = record.maximum = cost; // below one iteration too
+    record.medianLower = record.medianUpper = cost;
+    history.append({record});
+}
+
+// what the harness prints on its own, the CPU usage block of the first Benchmark and the errors of reading sysfs,
+// goes to a discarded stream instead of the test log
+class Silenced {
+    std::ostringstream _discarded;
+    std::streambuf *_out;
+    std::streambuf *_err;
+
+public:
+    Silenced()
+        : _out(std::cout.rdbuf(_discarded.rdbuf()))
+        , _err(std::cerr.rdbuf(_discarded.rdbuf())) {
+    }
+
+    ~Silenced() {
+        std::cout.rdbuf(_out);
+        std::cerr.rdbuf(_err);
+    }
+};
+
+BenchmarkSetup quietSetup() {
+    BenchmarkSetup setup;
+    setup.outputStyle = BenchmarkSetup::Nothing;
+    setup.skipWarmup = true;
+    return setup;
+}
+
+} // namespace
+
+TEST(Self, StartStopOverhead)
+{
+    static const unsigned Pairs = 1000000;
+    benchmark::detail::BenchmarkState bs;
+    RunState state(bs, benchmark::duration_t(0));
+
+    double pair = bestOf(5, [&]() {
+        auto start = benchmark::clock_t::now();
+        for (unsigned i = 0; i < Pairs; i++) {
+            state.start();
+            state.stop();
+        }
+        return nanoseconds(benchmark::clock_t::now() - start) / Pairs;
+    });
+    double now = bestOf(5, clockCost);
+
+    std::cout << "start/stop " << pair << " ns, clock read " << now << " ns" << std::endl;
+    // two clock reads and some bookkeeping
+    ASSERT_LE(pair, 4 * now + 50.0);
+    expectBaseline("Self.StartStop", pair, 0.1);
+}
+
+TEST(Self, DoNotOptimizeCost)
+{
+    // long enough for a fraction of a nanosecond per call to be more than the noise of the clock and the scheduler
+    static const unsigned Calls = 100000000;
+    double perCall = bestOf(5, []() {
+        auto start = benchmark::clock_t::now();
+        for (unsigned i = 0; i < Calls; i++) {
+            benchmark::DoNotOptimize(i);
+        }
+        return nanoseconds(benchmark::clock_t::now() - start) / Calls;
+    });
+
+    std::cout << "DoNotOptimize " << perCall << " ns" << std::endl;
+    ASSERT_LE(perCall, 5.0);
+    expectBaseline("Self.DoNotOptimize", perCall, 0.15);
+}
+
+TEST(Self, StatisticsThroughput)
+{
+    // 10^8 samples would take 800 MB of durations alone, 10^7 is as far as the suite goes
+    for (size_t samples = 1000000; samples <= 10000000; samples *= 10) {
+        double addNs = 0, calculateNs = 0;
+        for (int repetition = 0; repetition < 3; repetition++) {
+            TimeStatistics stats;
+            stats.setBootstrap({benchmark::detail::BootstrapNone, 0, 0.95, 42});
+
+            uint64_t x = 42;
+            auto start = benchmark::clock_t::now();
+            for (size_t i = 0; i < samples; i++) {
+                x = x * 6364136223846793005ull + 1442695040888963407ull;
+                stats.addSample(std::chrono::nanoseconds(1000 + (x >> 54)));
+            }
+            auto added = benchmark::clock_t::now();
+            ASSERT_TRUE(stats.calculate());
+            auto calculated = benchmark::clock_t::now();
+
+            double add = nanoseconds(added - start) / samples, calculate = nanoseconds(calculated - added) / samples;
+            addNs = repetition ? std::min(addNs, add) : add;
+            calculateNs = repetition ? std::min(calculateNs, calculate) : calculate;
+        }
+
+        std::cout << samples << " samples: add " << addNs << " ns/sample, calculate " << calculateNs << " ns/sample"
+                  << std::endl;
+        ASSERT_LE(addNs, 100.0);
+        // sorting and the density estimate of the modes dominate, about a microsecond per sample here
+        ASSERT_LE(calculateNs, 5000.0);
+        expectBaseline("Self.StatisticsAdd/" + std::to_string(samples), addNs, 0.15);
+        expectBaseline("Self.StatisticsCalculate/" + std::to_string(samples), calculateNs, 0.15);
+    }
+}
+
+TEST(Self, ReporterThroughput)
+{
+    static const unsigned Samples = 1000000;
+    BenchmarkSetup setup;
+    setup.outputStyle = BenchmarkSetup::Full;
+    setup.bootstrap.method = benchmark::detail::BootstrapNone;
+
+    double ms = bestOf(3, [&]() {
+        Silenced silenced;
+        Benchmark b(setup, "Reporter");
+        std::ostringstream out;
+        b.setOutput(&out);
+        for (unsigned i = 0; i < Samples; i++) {
+            b.debugAddSample(std::chrono::nanoseconds(1000 + i % 97));
+        }
+
+        auto start = benchmark::clock_t::now();
+        EXPECT_TRUE(b.calculateTimings());
+        b.printResults();
+        double elapsed = nanoseconds(benchmark::clock_t::now() - start) / 1e6;
+        EXPECT_FALSE(out.str().empty());
+        return elapsed;
+    });
+
+    std::cout << "statistics and report of " << Samples << " samples " << ms << " ms" << std::endl;
+    ASSERT_LE(ms, 5000.0);
+    expectBaseline("Self.Reporter", ms * 1e6, 0.15);
+}
+
+TEST(Self, Accuracy)
+{
+    double cyclesPerNs = benchmark::detail::coreCyclesPerNanosecond();
+
+    // relative tolerances to the workload and to the baseline, looser for short workloads where the clock resolution
+    // and the calibrated overhead matter
+    struct Workload {
+        uint64_t iterations;
+        double tolerance;
+        double regression;
+    } workloads[] = {{1000, 1.0, 0.25}, {10000, 0.15, 0.1}, {100000, 0.1, 0.1}, {1000000, 0.1, 0.1}};
+
+    for (const Workload &w : workloads) {
+        // the reported time in iterations of spin(), the fastest of the repetitions against the fastest spin() timed
+        // right after them: the clock of the core moves between runs
+        double iterationNs = spinCost();
+        double reportedNs = bestOf(3, [&]() {
+            Silenced silenced;
+            Benchmark b(quietSetup(), "Spin");
+            uint64_t seed = 1;
+            b.run([&](RunState &) { seed = spin(w.iterations, seed); });
+            double ns = nanoseconds(b.statistics().medianTime());
+            iterationNs = std::min(iterationNs, spinCost());
+            return ns;
+        });
+        ASSERT_GT(iterationNs, 0.0);
+        double measured = reportedNs / iterationNs;
+
+        std::cout << w.iterations << " iterations: measured " << measured << " iterations, spin " << iterationNs
+                  << " ns/iteration";
+        if (cyclesPerNs > 0.0)
+            std::cout << ", " << iterationNs * cyclesPerNs << " cycles/iteration";
+        std::cout << std::endl;
+        ASSERT_NEAR(measured, (double)w.iterations, w.iterations * w.tolerance + 20.0 / iterationNs);
+        // overhead left after the calibration shows as a longer time for the same work
+        expectBaseline("Self.Spin/" + std::to_string(w.iterations), reportedNs, w.regression, iterationNs);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
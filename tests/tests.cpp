@@ -1,8 +1,30 @@
 #include <benchmark/benchmark.h>
+#include <benchmark/sample_dump_reader.h>
+#include <benchmark/zone.h>
+#include <benchmark/detail/antagonist.h>
+#include <benchmark/detail/core_latency.h>
+#include <benchmark/detail/energy.h>
+#include <benchmark/detail/file_io.h>
+#include <benchmark/detail/history.h>
+#include <benchmark/detail/json_report.h>
+#include <benchmark/detail/layout.h>
+#include <benchmark/detail/page_resource.h>
+#include <benchmark/detail/sample_dump.h>
+#include <benchmark/detail/trace_writer.h>
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <fstream>
 #include <gtest/gtest.h>
 #include <iostream>
+#include <iterator>
+#include <list>
+#include <map>
+#include <numeric>
+#include <set>
+#include <sstream>
 #include <thread>
+#include <unistd.h>
 
 static BenchmarkSetup bs;
 
@@ -48,6 +70,1189 @@ TEST(Main, CustomSamples)
     ASSERT_EQ(b.statistics().totalTimeRun(), std::chrono::milliseconds(10));
 }
 
+TEST(Main, Outliers)
+{
+    Benchmark b(bs);
+
+    for (int i = 0; i < 30; i++)
+        b.debugAddSample(std::chrono::nanoseconds(100 + i));
+    b.debugAddSample(std::chrono::nanoseconds(10));
+    b.debugAddSample(std::chrono::nanoseconds(1000));
+    b.debugAddSample(std::chrono::nanoseconds(5000));
+    b.calculateTimings();
+
+    ASSERT_EQ(b.statistics().outliers().lowSevere, 1u);
+    ASSERT_EQ(b.statistics().outliers().highSevere, 2u);
+    ASSERT_EQ(b.statistics().outliers().total(), 3u);
+    // counted, not dropped: only the average leaves the severe ones out
+    ASSERT_EQ(b.statistics().size(), 33u);
+    ASSERT_EQ(b.statistics().minimalTime(), std::chrono::nanoseconds(10));
+    ASSERT_EQ(b.statistics().maximalTime(), std::chrono::nanoseconds(5000));
+    ASSERT_LT(b.statistics().averageTime(), std::chrono::nanoseconds(130));
+    ASSERT_FALSE(b.statistics().multimodal());
+
+    // a slow path in 10% of the samples, just past the mild fence, stays in the tail and the average
+    Benchmark slow(bs);
+    for (int i = 0; i < 90; i++)
+        slow.debugAddSample(std::chrono::nanoseconds(100 + i % 20));
+    for (int i = 0; i < 10; i++)
+        slow.debugAddSample(std::chrono::nanoseconds(135));
+    slow.calculateTimings();
+
+    ASSERT_EQ(slow.statistics().outliers().highMild, 10u);
+    ASSERT_EQ(slow.statistics().outliers().highSevere, 0u);
+    ASSERT_EQ(slow.statistics().maximalTime(), std::chrono::nanoseconds(135));
+    ASSERT_EQ(slow.statistics().percentile(95), std::chrono::nanoseconds(135));
+    // interpolated like the bootstrap intervals: between sample 89 (119 ns) and 90 (135 ns), not nearest-rank 119
+    ASSERT_EQ(slow.statistics().percentile(90), std::chrono::nanoseconds(121));
+    ASSERT_GT(slow.statistics().averageTime(), std::chrono::nanoseconds(110)); // 108.9 without the slow path
+}
+
+TEST(Main, Bimodal)
+{
+    Benchmark b(bs);
+
+    for (int i = 0; i < 60; i++)
+        b.debugAddSample(std::chrono::nanoseconds(400 + (i * 7) % 20));
+    for (int i = 0; i < 40; i++)
+        b.debugAddSample(std::chrono::nanoseconds(1200 + (i * 11) % 40));
+    b.calculateTimings();
+
+    ASSERT_TRUE(b.statistics().multimodal());
+    ASSERT_EQ(b.statistics().modes().size(), 2u);
+    ASSERT_EQ(b.statistics().modes()[0].samples, 60u);
+    ASSERT_EQ(b.statistics().modes()[1].samples, 40u);
+    ASSERT_NEAR((double)b.statistics().modes()[1].median.count(), 1220.0, 20.0);
+}
+
+TEST(Main, ConfidenceIntervals)
+{
+    Benchmark b(bs);
+
+    for (int i = 1; i <= 100; i++)
+        b.debugAddSample(std::chrono::nanoseconds(1000 + i * 10));
+    b.calculateTimings();
+
+    auto mean = b.statistics().averageInterval();
+    ASSERT_TRUE(mean.valid);
+    ASSERT_LT(mean.lower, (double)b.statistics().averageTime().count());
+    ASSERT_GT(mean.upper, (double)b.statistics().averageTime().count());
+    ASSERT_NEAR(mean.upper - mean.lower, 2 * 1.96 * 290.0 / 10.0, 30.0); // ~ 2 * z * sigma / sqrt(n)
+
+    auto median = b.statistics().medianInterval();
+    ASSERT_TRUE(median.valid);
+    ASSERT_LE(median.lower, (double)b.statistics().medianTime().count());
+    ASSERT_GE(median.upper, (double)b.statistics().medianTime().count());
+
+    ASSERT_TRUE(b.statistics().percentileInterval(90).valid);
+    ASSERT_FALSE(b.statistics().percentileInterval(99).valid);
+}
+
+TEST(Main, Unroll)
+{
+    std::vector<unsigned> calls;
+    struct Step {
+        std::vector<unsigned> &calls;
+        void operator()(unsigned i) { calls.push_back(i); }
+    } step{calls};
+    benchmark::detail::Unroll<37>::run(step);
+
+    ASSERT_EQ(calls.size(), 37u);
+    for (unsigned i = 0; i < calls.size(); i++)
+        ASSERT_EQ(calls[i], i);
+}
+
+TEST(Main, Calibration)
+{
+    benchmark::detail::TimerCalibration calibration = benchmark::detail::calibrateTimer();
+
+    ASSERT_GT(calibration.resolution, benchmark::duration_t(0));
+    ASSERT_GE(calibration.overhead, benchmark::duration_t(0));
+    ASSERT_GE(calibration.overheadSpread, benchmark::duration_t(0));
+    ASSERT_LE(calibration.overheadMin, calibration.overhead);
+    ASSERT_LE(calibration.overhead, calibration.overheadMax);
+    // an empty sample is two clock reads, far from a millisecond even on a loaded machine
+    ASSERT_LT(calibration.overhead, std::chrono::milliseconds(1));
+
+    ASSERT_EQ(calibration.floor(), calibration.overhead + calibration.overheadSpread + calibration.resolution);
+    ASSERT_TRUE(calibration.nearFloor(benchmark::duration_t(0)));
+    ASSERT_TRUE(calibration.nearFloor(calibration.floor()));
+    ASSERT_TRUE(calibration.nearFloor(calibration.floor() * 4));
+    ASSERT_FALSE(calibration.nearFloor(std::chrono::seconds(1)));
+}
+
+TEST(Main, UnrollMeasure)
+{
+    benchmark::detail::BenchmarkState bs;
+
+    // latency: one chain, every copy takes the result of the one before
+    std::vector<uint64_t> seen;
+    {
+        benchmark::detail::RunState state(bs, benchmark::duration_t(0));
+        benchmark::measureLatency<16>(state, (uint64_t)1, [&seen](uint64_t x) {
+            seen.push_back(x);
+            return x + 1;
+        }, 3);
+        ASSERT_EQ(state.operations(), 48u);
+    }
+    ASSERT_EQ(seen.size(), 48u);
+    for (size_t i = 0; i < seen.size(); i++)
+        ASSERT_EQ(seen[i], i + 1);
+
+    // throughput: the copies go round the independent chains, each starting from init
+    seen.clear();
+    {
+        benchmark::detail::RunState state(bs, benchmark::duration_t(0));
+        benchmark::measureThroughput<16, 4>(state, (uint64_t)1, [&seen](uint64_t x) {
+            seen.push_back(x);
+            return x + 1;
+        }, 3);
+        ASSERT_EQ(state.operations(), 48u);
+    }
+    ASSERT_EQ(seen.size(), 48u);
+    for (size_t i = 0; i < seen.size(); i++)
+        ASSERT_EQ(seen[i], i / 4 + 1);
+
+    // floating point stays in a vector register, a struct has no register constraint and goes through memory
+    double sum = 0;
+    {
+        benchmark::detail::RunState state(bs, benchmark::duration_t(0));
+        benchmark::measureLatency<8>(state, 0.5, [&sum](double x) {
+            sum += x;
+            return x * 2;
+        }, 1);
+    }
+    ASSERT_EQ(sum, 127.5);
+
+    struct Fibonacci {
+        uint64_t previous;
+        uint64_t current;
+        uint64_t index; // wider than any register
+    };
+    uint64_t last = 0;
+    {
+        benchmark::detail::RunState state(bs, benchmark::duration_t(0));
+        benchmark::measureLatency<10>(state, Fibonacci{0, 1, 1}, [&last](Fibonacci f) {
+            last = f.current;
+            return Fibonacci{f.current, f.previous + f.current, f.index + 1};
+        }, 1);
+        ASSERT_EQ(state.operations(), 10u);
+    }
+    ASSERT_EQ(last, 55u);
+
+    // the core clock is measured once, a few GHz on anything this runs on (well below a GHz unoptimized)
+    double cyclesPerNs = benchmark::detail::coreCyclesPerNanosecond();
+    ASSERT_GT(cyclesPerNs, 0.01);
+    ASSERT_LT(cyclesPerNs, 10.0);
+    ASSERT_EQ(benchmark::detail::coreCyclesPerNanosecond(), cyclesPerNs);
+}
+
+TEST(Main, SteadyState)
+{
+    benchmark::detail::SteadyStateDetector detector;
+    for (int i = 0; i < 30; i++)
+        detector.add(std::chrono::nanoseconds(1000 - i * 30)); // cooling down to 130 ns
+    for (int i = 0; i < 100; i++)
+        detector.add(std::chrono::nanoseconds(100 + (i * 7) % 10));
+
+    ASSERT_TRUE(detector.steady());
+    ASSERT_GE(detector.warmupSamples(), 25u);
+    ASSERT_LE(detector.warmupSamples(), 40u);
+
+    detector.clear();
+    for (int i = 0; i < 100; i++)
+        detector.add(std::chrono::nanoseconds(100 + (i * 7) % 10));
+    ASSERT_TRUE(detector.steady());
+    ASSERT_LE(detector.warmupSamples(), 10u);
+
+    detector.clear();
+    for (int i = 0; i < 100; i++)
+        detector.add(std::chrono::nanoseconds(100 + i * 10)); // never settles
+    ASSERT_FALSE(detector.steady());
+}
+
+TEST(Main, History)
+{
+    std::string path = ::testing::TempDir() + "benchmark_history_test.bin";
+    std::remove(path.c_str());
+
+    benchmark::detail::HistoryLog history(path);
+    for (int run = 0; run < 12; run++) {
+        benchmark::detail::BenchmarkResult result{};
+        result.name = "Sort";
+        result.hasArg = true;
+        result.arg = 64;
+        result.iterations = 100;
+        result.median = std::chrono::nanoseconds(run < 8 ? 1000 + run % 2 * 10 : 1200 + run % 2 * 10);
+        result.medianInterval = {(double)result.median.count() - 5, (double)result.median.count() + 5, true};
+
+        benchmark::detail::BenchmarkResult other = result;
+        other.arg = 128;
+        // the same argument under a load and a layout is a series of its own
+        benchmark::detail::BenchmarkResult loaded = result;
+        loaded.antagonist = "llc on cpus 2-7";
+        loaded.layout = "layout 3 (stack+1536, heap+2272, data+48)";
+        std::string revision = "rev" + std::to_string(run);
+        ASSERT_TRUE(history.append({benchmark::detail::HistoryLog::makeRecord(result, revision, 1, run),
+                                    benchmark::detail::HistoryLog::makeRecord(other, revision, 1, run),
+                                    benchmark::detail::HistoryLog::makeRecord(loaded, revision, 1, run)}));
+    }
+
+    std::vector<benchmark::detail::HistoryRecord> records = history.records();
+    ASSERT_EQ(records.size(), 36u);
+    ASSERT_STREQ(records[3].revision, "rev1");
+    ASSERT_STREQ(records[2].labels, "llc on cpus 2-7; layout 3 (stack+1536, heap+2272, data+48)");
+
+    // read in place
+    benchmark::detail::HistoryMapping mapping;
+    ASSERT_TRUE(history.map(mapping));
+    ASSERT_EQ(mapping.size(), 36u);
+    auto series = benchmark::detail::HistoryLog::series(mapping.begin(), mapping.end(), "Sort");
+    ASSERT_EQ(series.size(), 3u);
+    ASSERT_EQ(series[0].runs.size(), 12u);
+    ASSERT_EQ(series[0].latest().args[0], 64);
+    ASSERT_EQ(series[0].latest().variant, 0u);
+    ASSERT_EQ(series[2].latest().args[0], 64);
+    ASSERT_NE(series[2].latest().variant, 0u);
+
+    auto step = benchmark::detail::HistoryLog::stepChange(series[0].runs);
+    ASSERT_TRUE(step.found);
+    ASSERT_EQ(step.index, 8u);
+    ASSERT_NEAR(step.relative, 0.2, 0.01);
+    ASSERT_GT(benchmark::detail::HistoryLog::trend(series[0].runs), 0.0);
+
+    // no change in noise
+    std::vector<const benchmark::detail::HistoryRecord *> flat(series[0].runs.begin(), series[0].runs.begin() + 8);
+    ASSERT_FALSE(benchmark::detail::HistoryLog::stepChange(flat).found);
+
+    ASSERT_TRUE(benchmark::detail::HistoryLog::series(records, "Search").empty());
+    std::remove(path.c_str());
+
+    // writers starting on a new file at the same time write a single header
+    std::vector<std::thread> writers;
+    for (int writer = 0; writer < 4; writer++) {
+        writers.emplace_back([&path, writer]() {
+            benchmark::detail::HistoryLog log(path);
+            benchmark::detail::BenchmarkResult result{};
+            result.name = "Concurrent";
+            for (int run = 0; run < 25; run++)
+                log.append({benchmark::detail::HistoryLog::makeRecord(result, "rev", 1, writer * 100 + run)});
+        });
+    }
+    for (auto &writer : writers) {
+        writer.join();
+    }
+    ASSERT_EQ(history.records().size(), 100u);
+    std::remove(path.c_str());
+}
+
+TEST(Main, SampleDump)
+{
+    std::string path = ::testing::TempDir() + "benchmark_dump_test.bin";
+    {
+        benchmark::detail::SampleDump dump(path, 8);
+        ASSERT_TRUE(dump.isOpen());
+
+        benchmark::detail::BenchmarkState bs;
+        uint32_t blocks[2] = {dump.beginBlock("A"), dump.beginBlock("B $1=2")};
+        for (int i = 0; i < 10; i++) {
+            benchmark::detail::RunState state(bs, std::chrono::nanoseconds(0));
+            state.start();
+            state.stop();
+            if (i % 2)
+                state.setCounter("bytes", i * 100.0);
+            dump.record(blocks[i / 5], state, std::chrono::nanoseconds(1000 + i));
+        }
+        ASSERT_EQ(dump.rows(), 8u);
+        ASSERT_EQ(dump.dropped(), 2u);
+    }
+
+    benchmark::SampleDumpReader reader(path);
+    ASSERT_TRUE(reader.valid());
+    ASSERT_TRUE(reader.complete());
+    ASSERT_EQ(reader.rows(), 8u);
+    ASSERT_EQ(reader.blockCount(), 2u);
+
+    const int64_t *durations = reader.column<int64_t>("duration_ns");
+    ASSERT_NE(durations, nullptr);
+    ASSERT_EQ(durations[7], 1007);
+    ASSERT_EQ(reader.blockName(reader.value(benchmark::detail::DumpBlock, 6)), "B $1=2");
+
+    const double *bytes = reader.column<double>("bytes");
+    ASSERT_NE(bytes, nullptr);
+    ASSERT_TRUE(std::isnan(bytes[0]));
+    ASSERT_EQ(bytes[3], 300.0);
+    ASSERT_EQ(reader.findColumn("counter1"), (int)benchmark::detail::DumpCounter0 + 1);
+    std::remove(path.c_str());
+}
+
+TEST(Main, Partitions)
+{
+    using benchmark::detail::LogicalCpu;
+    ASSERT_EQ(benchmark::detail::parseCpuList("0-3,8,10-11\n"), (std::vector<int>{0, 1, 2, 3, 8, 10, 11}));
+    ASSERT_EQ(benchmark::detail::formatCpuList({11, 0, 1, 2, 3, 8, 10}), "0-3,8,10-11");
+
+    // 2 packages, 2 cores each with 2 SMT threads, siblings numbered n and n + 4
+    std::vector<LogicalCpu> cpus;
+    for (int cpu = 0; cpu < 8; cpu++) {
+        int core = cpu % 4;
+        cpus.push_back(LogicalCpu{cpu, core / 2, core, core / 2 * 2, core / 2});
+    }
+
+    auto cores = benchmark::detail::partitionCores(cpus, benchmark::detail::PartitionCore);
+    ASSERT_EQ(cores.size(), 4u);
+    ASSERT_EQ(cores[1].cpus, (std::vector<int>{1, 5}));
+    ASSERT_EQ(cores[1].label(), "P1 [cpus 1,5, L3 0, node 0]");
+
+    auto l3 = benchmark::detail::partitionCores(cpus, benchmark::detail::PartitionL3);
+    ASSERT_EQ(l3.size(), 2u);
+    ASSERT_EQ(l3[1].cpus, (std::vector<int>{2, 3, 6, 7}));
+    ASSERT_EQ(l3[1].node, 1);
+
+    ASSERT_FALSE(benchmark::detail::readTopology().empty());
+}
+
+TEST(Main, ListDimensions)
+{
+    // what the run loop does: the body registers the dimensions on its first pass and restarts
+    benchmark::detail::BenchmarkState bs;
+    ASSERT_TRUE(bs.running());
+    ASSERT_TRUE(bs.addList(benchmark::detail::ListPlacement, {benchmark::PlaceLocal, benchmark::PlaceRemote}));
+    ASSERT_TRUE(bs.running());
+    bs.pickNextArgument();
+    ASSERT_TRUE(bs.addArgument(1, 4));
+
+    std::vector<std::pair<int, int>> combinations;
+    while (bs.running()) {
+        bs.pickNextArgument();
+        ASSERT_FALSE(bs.addList(benchmark::detail::ListPlacement, {benchmark::PlaceLocal, benchmark::PlaceRemote}));
+        ASSERT_FALSE(bs.addArgument(1, 4));
+        combinations.emplace_back(bs.listValue(benchmark::detail::ListPlacement, -1), bs.getArg());
+    }
+    std::vector<std::pair<int, int>> expected = {{benchmark::PlaceLocal, 1}, {benchmark::PlaceLocal, 2},
+                                                 {benchmark::PlaceLocal, 4}, {benchmark::PlaceRemote, 1},
+                                                 {benchmark::PlaceRemote, 2}, {benchmark::PlaceRemote, 4}};
+    ASSERT_EQ(combinations, expected);
+}
+
+TEST(Main, NumaMemory)
+{
+    std::vector<benchmark::detail::NumaNode> nodes = benchmark::detail::readNumaNodes();
+    ASSERT_FALSE(nodes.empty());
+
+    benchmark::detail::PageResource local(benchmark::PlaceLocal, benchmark::BackingDefault, nodes);
+    std::vector<int, benchmark::Allocator<int>> v{benchmark::Allocator<int>(&local)};
+    for (int i = 0; i < 100000; i++)
+        v.push_back(i);
+    ASSERT_EQ(v[99999], 99999);
+    ASSERT_EQ(local.description().find("local, memory node"), 0u);
+
+    void *aligned = local.allocate(100, 4096);
+    ASSERT_EQ((uintptr_t)aligned % 4096, 0u);
+
+    // a single node machine has nothing remote
+    benchmark::detail::PageResource remote(benchmark::PlaceRemote, benchmark::BackingDefault, nodes);
+    if (nodes.size() == 1) {
+        ASSERT_EQ(remote.description().find("remote unavailable"), 0u);
+    }
+
+    benchmark::detail::PageResource touched(benchmark::firstTouchOn(0), benchmark::BackingDefault, nodes);
+    int *p = (int *)touched.allocate(sizeof(int) * 1000, alignof(int));
+    ASSERT_EQ(p[999], 0);
+}
+
+TEST(Main, NumaPinning)
+{
+    std::vector<benchmark::detail::NumaNode> nodes = benchmark::detail::readNumaNodes();
+    std::vector<int> before = benchmark::detail::currentAffinity();
+
+    // the thread stays on the node local is relative to for the whole block, and is free again after the run
+    BenchmarkSetup setup;
+    setup.outputStyle = BenchmarkSetup::Nothing;
+    setup.skipWarmup = true;
+    setup.placement = benchmark::PlaceLocal;
+    Benchmark b(setup, "Pinned");
+    std::vector<int> during;
+    b.run([&](benchmark::detail::RunState &) { during = benchmark::detail::currentAffinity(); });
+
+    ASSERT_FALSE(during.empty());
+    for (int cpu : during) {
+        ASSERT_EQ(benchmark::detail::nodeOfCpu(nodes, cpu), benchmark::detail::nodeOfCpu(nodes, during.front()));
+    }
+    ASSERT_EQ(benchmark::detail::currentAffinity(), before);
+}
+
+TEST(Main, PageBacking)
+{
+    std::vector<benchmark::detail::NumaNode> nodes = benchmark::detail::readNumaNodes();
+    ASSERT_EQ(benchmark::detail::parseBacking("2m"), benchmark::BackingHuge2M);
+    ASSERT_EQ(benchmark::detail::parseBacking("huge"), -1);
+
+    benchmark::detail::PageResource thp(benchmark::PlaceDefault, benchmark::BackingTHP, nodes);
+    char *p = (char *)thp.allocate(3 << 20, 64);
+    ASSERT_EQ((uintptr_t)p % (2 << 20), 0u);
+    p[(3 << 20) - 1] = 1;
+    ASSERT_EQ(thp.description(), "default, thread node " + std::to_string(thp.policy().threadNode) + ", THP");
+
+    // explicit huge pages without any reserved are transparent ones, and say so
+    for (int backing : {benchmark::BackingHuge2M, benchmark::BackingHuge1G}) {
+        benchmark::detail::PageResource huge(benchmark::PlaceLocal, backing, nodes);
+        int *q = (int *)huge.allocate(sizeof(int) * 1000, alignof(int));
+        q[999] = 1;
+        if (huge.fellBack()) {
+            ASSERT_NE(huge.description().find("pages not reserved, THP"), std::string::npos);
+            // THP chunks are rounded to 2M pages, not to the 1G ones that weren't there: 3M leave no room for 3M more
+            char *first = (char *)huge.allocate(3 << 20, 64);
+            char *second = (char *)huge.allocate(3 << 20, 64);
+            ASSERT_NE(second, first + (3 << 20));
+        }
+    }
+
+    benchmark::detail::PageResource populated(benchmark::PlaceLocal, benchmark::BackingPopulate, nodes);
+    int *r = (int *)populated.allocate(sizeof(int) * 1000, alignof(int));
+    ASSERT_EQ(r[999], 0);
+    populated.reset();
+    ASSERT_EQ(populated.allocate(sizeof(int), alignof(int)), (void *)r);
+}
+
+TEST(Main, Arena)
+{
+    benchmark::SystemResource system;
+    benchmark::ArenaResource arena(&system, 256);
+
+    void *first = arena.allocate(100, 8);
+    void *aligned = arena.allocate(10, 64);
+    ASSERT_EQ((uintptr_t)aligned % 64, 0u);
+    ASSERT_GE((char *)aligned, (char *)first + 100);
+
+    // chunks grow as needed and are reused from the start
+    for (int i = 0; i < 100; i++)
+        arena.allocate(100, 8);
+    size_t capacity = arena.capacity();
+    arena.reset();
+    ASSERT_EQ(arena.allocate(100, 8), first);
+    ASSERT_EQ(arena.capacity(), capacity);
+    arena.release();
+    ASSERT_EQ(arena.capacity(), 0u);
+
+    benchmark::PoolResource pool(&arena);
+    void *a = pool.allocate(24, 8);
+    void *b = pool.allocate(32, 8);
+    ASSERT_NE(a, b);
+    ASSERT_EQ((uintptr_t)b % 32, 0u);
+    pool.deallocate(a, 24, 8);
+    ASSERT_EQ(pool.allocate(30, 8), a); // same size class
+    void *large = pool.allocate(10000, 8);
+    pool.deallocate(large, 10000, 8);
+
+    std::list<int, benchmark::Allocator<int>> list{benchmark::Allocator<int>(&pool)};
+    for (int i = 0; i < 1000; i++)
+        list.push_back(i);
+    ASSERT_EQ(list.back(), 999);
+    ASSERT_EQ(pool.description(), "pool over arena over system");
+}
+
+TEST(Main, AllocatorStrategies)
+{
+    ASSERT_EQ(benchmark::detail::parseAllocatorStrategy("pool"), benchmark::AllocatorPool);
+    ASSERT_EQ(benchmark::detail::parseAllocatorStrategy("malloc"), -1);
+
+    Benchmark build(bs, "Build");
+    build.run([](benchmark::detail::RunState &state) {
+        ALLOCATORS(benchmark::AllocatorSystem, benchmark::AllocatorArena, benchmark::AllocatorPool)
+        using Vector = std::vector<int, benchmark::Allocator<int>>;
+        MEASURE(
+            Vector v(state.allocator<int>());
+            for (int i = 0; i < 100; i++)
+                v.push_back(i);
+            benchmark::DoNotOptimize(v.back());
+        )
+    });
+
+    ASSERT_EQ(build.results().size(), 3u);
+    ASSERT_EQ(build.results()[0].memory, "system");
+    ASSERT_EQ(build.results()[1].memory.find("pool"), std::string::npos);
+    ASSERT_EQ(build.results()[2].memory.find("pool over"), 0u);
+}
+
+TEST(Main, Datasets)
+{
+    using namespace benchmark::data;
+
+    // the same description gives the same data
+    ASSERT_EQ(Uniform(100, 5, 10).generate(), Uniform(100, 5, 10).generate());
+    ASSERT_NE(Uniform(100, 5, 10, 1).generate(), Uniform(100, 5, 10, 2).generate());
+    for (uint64_t value : Uniform(1000, 5, 10).generate()) {
+        ASSERT_GE(value, 5u);
+        ASSERT_LE(value, 10u);
+    }
+
+    // the most popular key of Zipf(s=1) over 100 keys is drawn about 19% of the time
+    std::vector<uint64_t> zipf = Zipf(100000, 1.0, 100).generate();
+    std::map<uint64_t, int> counts;
+    for (uint64_t key : zipf)
+        counts[key]++;
+    int top = 0;
+    for (auto &count : counts)
+        top = std::max(top, count.second);
+    ASSERT_LE(counts.size(), 100u);
+    ASSERT_NEAR(top / 100000.0, 0.19, 0.01);
+
+    std::vector<uint64_t> reversed = Ordered(1000, OrderReversed).generate();
+    ASSERT_TRUE(std::is_sorted(reversed.rbegin(), reversed.rend()));
+    std::vector<uint64_t> nearly = Ordered(1000, OrderNearlySorted, 0.1).generate();
+    ASSERT_FALSE(std::is_sorted(nearly.begin(), nearly.end()));
+
+    for (auto &text : Strings(1000, 2, 20, LengthGeometric).generate()) {
+        ASSERT_GE(text.size(), 2u);
+        ASSERT_LE(text.size(), 20u);
+    }
+
+    KeySetData keys = KeySet(1000, 10000, 0.75).generate();
+    std::set<uint64_t> set(keys.keys.begin(), keys.keys.end());
+    ASSERT_EQ(set.size(), 1000u);
+    size_t hits = 0;
+    for (uint64_t key : keys.lookups)
+        hits += set.count(key);
+    ASSERT_NEAR(hits / 10000.0, 0.75, 0.02);
+
+    // generated once for all samples, recorded in the results
+    int generated = 0;
+    struct Counting: Uniform {
+        int *generated;
+        Counting(int *generated_) : Uniform(10), generated(generated_) {
+        }
+        result_type generate() const {
+            ++*generated;
+            return Uniform::generate();
+        }
+    };
+    Benchmark b(bs);
+    b.run([&generated](benchmark::detail::RunState &state) {
+        auto &data = state.dataset(Counting(&generated));
+        MEASURE(benchmark::DoNotOptimize(data[0]);)
+    });
+    ASSERT_EQ(generated, 1);
+    ASSERT_EQ(b.results().back().datasets, "uniform(n=10, min=0, max=18446744073709551615, seed=42)");
+}
+
+TEST(Main, FileIo)
+{
+    std::string path;
+    {
+        benchmark::TempFile file(1 << 20, benchmark::FileOnTmpfs);
+        ASSERT_TRUE(file.valid());
+        ASSERT_EQ(file.size(), 1u << 20);
+        ASSERT_NE(file.map(), nullptr);
+        path = file.path();
+        ASSERT_EQ(access(path.c_str(), F_OK), 0);
+
+        // every method and queue depth moves whole batches
+        for (int method : {benchmark::IoPread, benchmark::IoMmap}) {
+            for (unsigned depth : {1u, 4u}) {
+                benchmark::IoJob job(method, benchmark::IoRandom, 4096, 64, depth);
+                job.prepare(file);
+                ASSERT_EQ(job.run(file), 64u * 4096);
+            }
+        }
+        benchmark::IoJob writes(benchmark::IoPread, benchmark::IoSequential, 65536, 32, 1, benchmark::IoWriteSync);
+        ASSERT_EQ(writes.run(file), 32u * 65536);
+        // the pages of a file on tmpfs are the file, they can't be dropped
+        ASSERT_FALSE(file.dropCache());
+
+        // consecutive sequential batches continue through the file and wrap at its end
+        ASSERT_EQ(file.nextSequential(65536, 8), 0u);
+        ASSERT_EQ(file.nextSequential(65536, 8), 8u * 65536);
+        file.nextSequential(65536, 16);
+        ASSERT_EQ(file.nextSequential(65536, 8), 0u);
+    }
+    ASSERT_NE(access(path.c_str(), F_OK), 0);
+
+    // a file on disk is cold after dropCache(), its mapped pages included
+    {
+        benchmark::TempFile file(1 << 20, benchmark::FileOnDisk);
+        ASSERT_TRUE(file.valid());
+        volatile char sum = 0;
+        for (size_t i = 0; i < file.size(); i += 4096)
+            sum += file.map()[i];
+        ASSERT_GT(file.residentPages(), 0);
+        ASSERT_TRUE(file.dropCache());
+        ASSERT_EQ(file.residentPages(), 0);
+    }
+
+    ASSERT_EQ(benchmark::detail::formatRate(41200.0, "ops"), "41.2 kops/s");
+    ASSERT_EQ(benchmark::detail::formatRate(1.61e8, "B"), "161 MB/s");
+
+    // IOPS and bandwidth come with the results
+    Benchmark b(bs);
+    b.run([](benchmark::detail::RunState &state) {
+        auto &file = state.dataset(benchmark::data::File(1 << 20, benchmark::FileOnTmpfs));
+        benchmark::IoJob job(benchmark::IoPread, benchmark::IoRandom, 4096, 16);
+        MEASURE_IO(job, file)
+    });
+    ASSERT_EQ(b.results().back().operations, 16u);
+    ASSERT_EQ(b.results().back().bytes, 16u * 4096);
+    ASSERT_EQ(b.results().back().datasets, "file(size=1048576, location=tmpfs, seed=42)");
+}
+
+TEST(Main, Antagonists)
+{
+    using namespace benchmark::detail;
+
+    ASSERT_EQ(parseAntagonist("bandwidth"), benchmark::AntagonistBandwidth);
+    ASSERT_EQ(parseAntagonist("quiet"), -1);
+    ASSERT_EQ(withQuietBaseline({benchmark::AntagonistLLC, benchmark::AntagonistNone, benchmark::AntagonistSMT}),
+              std::vector<int>({benchmark::AntagonistNone, benchmark::AntagonistLLC, benchmark::AntagonistSMT}));
+
+    // cpus 0 and 1 are siblings, 2 and 3 another core of the same L3, 4 a core of another L3
+    std::vector<LogicalCpu> topology = {{0, 0, 0, 0, 0}, {1, 0, 0, 0, 0}, {2, 0, 1, 0, 0}, {3, 0, 1, 0, 0},
+                                        {4, 0, 2, 4, 0}};
+    ASSERT_EQ(antagonistCpus(benchmark::AntagonistSMT, 0, topology, {}), std::vector<int>({1}));
+    ASSERT_EQ(antagonistCpus(benchmark::AntagonistBranch, 4, topology, {}), std::vector<int>());
+    ASSERT_EQ(antagonistCpus(benchmark::AntagonistLLC, 0, topology, {}), std::vector<int>({2, 3}));
+    ASSERT_EQ(antagonistCpus(benchmark::AntagonistBandwidth, 0, topology, {}), std::vector<int>({2, 3, 4}));
+    ASSERT_EQ(antagonistCpus(benchmark::AntagonistLLC, 0, topology, {5}), std::vector<int>({5}));
+
+    {
+        Antagonists none(benchmark::AntagonistLLC, {});
+        ASSERT_FALSE(none.running());
+        ASSERT_EQ(none.description(), "llc (no cpu for it)");
+        for (int kind : {benchmark::AntagonistLLC, benchmark::AntagonistBandwidth, benchmark::AntagonistBranch,
+                         benchmark::AntagonistSMT}) {
+            Antagonists antagonists(kind, {0});
+            ASSERT_TRUE(antagonists.running());
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+    }
+
+    // the quiet baseline first, then a block under each antagonist
+    BenchmarkSetup setup = bs;
+    setup.antagonists = {benchmark::AntagonistSMT};
+    setup.antagonistCpus = {0};
+    Benchmark b(setup);
+    b.run([](benchmark::detail::RunState &state) {
+        MEASURE(REPEAT(1000) { benchmark::DoNotOptimize(state); })
+    });
+    ASSERT_EQ(b.results().size(), 2u);
+    ASSERT_EQ(b.results()[0].antagonist, "quiet");
+    ASSERT_EQ(b.results()[1].antagonist, "smt on cpus 0");
+
+    // without an SMT sibling there is nothing to compare with the baseline
+    setup.antagonistCpus.clear();
+    setup.outputStyle = BenchmarkSetup::OneLine;
+    Benchmark alone(setup);
+    std::ostringstream out;
+    alone.setOutput(&out);
+    alone.run([](benchmark::detail::RunState &state) {
+        MEASURE(REPEAT(1000) { benchmark::DoNotOptimize(state); })
+    });
+    ASSERT_EQ(alone.results().size(), 2u);
+    if (alone.results()[1].antagonist == "smt (no cpu for it)") {
+        ASSERT_NE(out.str().find("n/a"), std::string::npos);
+    }
+
+    // the thread is pinned only for the blocks of the run
+    std::vector<int> affinity = currentAffinity();
+    Benchmark pinned(setup);
+    std::vector<int> during;
+    pinned.run([&](benchmark::detail::RunState &state) {
+        during = currentAffinity();
+        MEASURE(REPEAT(1000) { benchmark::DoNotOptimize(state); })
+    });
+    ASSERT_EQ(during.size(), 1u);
+    ASSERT_EQ(currentAffinity(), affinity);
+
+    // the other cores of the parallel mode run benchmarks already, ANTAGONISTS() of the body is ignored there
+    Benchmark parallel(bs);
+    parallel.setPartition("P0");
+    parallel.run([](benchmark::detail::RunState &state) {
+        ANTAGONISTS(benchmark::AntagonistLLC)
+        MEASURE(REPEAT(1000) { benchmark::DoNotOptimize(state); })
+    });
+    ASSERT_EQ(parallel.results().size(), 1u);
+    ASSERT_EQ(parallel.results()[0].antagonist, "");
+}
+
+TEST(Main, Layouts)
+{
+    using namespace benchmark::detail;
+
+    ASSERT_EQ(memoryLayout(0).description(), "layout 0 (default)");
+    std::set<size_t> stacks;
+    for (unsigned i = 1; i < 8; i++) {
+        MemoryLayout layout = memoryLayout(i);
+        ASSERT_EQ(layout.description(), memoryLayout(i).description());
+        for (size_t offset : {layout.stack, layout.heap, layout.data}) {
+            ASSERT_EQ(offset % 16, 0u);
+            ASSERT_LT(offset, 4096u);
+        }
+        stacks.insert(layout.stack);
+    }
+    ASSERT_GT(stacks.size(), 4u);
+
+    // the callee's frame moves down by the offset
+    uintptr_t frames[2];
+    for (size_t i = 0; i < 2; i++) {
+        withStackOffset(i * 1024, [&]() {
+            char local = 0;
+            benchmark::DoNotOptimize(local);
+            frames[i] = (uintptr_t)&local;
+        });
+    }
+    ASSERT_GE(frames[0] - frames[1], 1024u);
+    ASSERT_LT(frames[0] - frames[1], 1024u + 256);
+
+    benchmark::SystemResource system;
+    OffsetResource offset(&system, 80);
+    void *p = offset.allocate(100, 16);
+    void *q = offset.allocate(100, 64);
+    ASSERT_EQ((uintptr_t)q % 64, 0u);
+    offset.deallocate(p, 100, 16);
+    offset.deallocate(q, 100, 64);
+
+    // from the start of a chunk of pages, 64-byte aligned blocks of different layouts land at different places in a
+    // page, page aligned ones on different pages
+    PageResource pages(benchmark::PlaceLocal, benchmark::BackingDefault, readNumaNodes());
+    uintptr_t base = (uintptr_t)pages.allocate(1, 64);
+    ASSERT_EQ(base % 4096, 0u);
+    std::set<uintptr_t> phases, pageNumbers;
+    for (unsigned i = 1; i < 16; i++) {
+        OffsetResource moved(&pages, memoryLayout(i).data);
+        pages.reset();
+        uintptr_t block = (uintptr_t)moved.allocate(100, 64);
+        ASSERT_EQ(block % 64, 0u);
+        ASSERT_LT(block - base, 4096u);
+        phases.insert(block % 4096);
+
+        pages.reset();
+        uintptr_t page = (uintptr_t)moved.allocate(100, 4096);
+        ASSERT_EQ(page % 4096, 0u);
+        pageNumbers.insert((page - base) / 4096);
+    }
+    ASSERT_GT(phases.size(), 10u);
+    ASSERT_GT(pageNumbers.size(), 6u);
+
+    auto result = [](int medianNs, int stdDevNs) {
+        BenchmarkResult r{};
+        r.iterations = 100;
+        r.median = std::chrono::nanoseconds(medianNs);
+        r.stdDev = std::chrono::nanoseconds(stdDevNs);
+        return r;
+    };
+    // 10% apart with 1% noise: the layouts
+    LayoutVariance apart = layoutVariance({result(100, 1), result(110, 1), result(90, 1), result(105, 1)});
+    ASSERT_EQ(apart.layouts, 4u);
+    ASSERT_EQ(apart.minimum, 90);
+    ASSERT_EQ(apart.maximum, 110);
+    ASSERT_EQ(apart.median, 102.5);
+    ASSERT_NEAR(apart.sampleStdDev, 1.0, 1e-9);
+    ASSERT_GT(apart.layoutStdDev, 8.0);
+    ASSERT_GT(apart.layoutShare, 0.99);
+    // 1% apart with 30% noise: the samples
+    LayoutVariance noise = layoutVariance({result(100, 30), result(101, 30), result(99, 30)});
+    ASSERT_EQ(noise.layoutStdDev, 0.0);
+    ASSERT_EQ(noise.layoutShare, 0.0);
+
+    BenchmarkSetup setup = bs;
+    setup.layouts = 3;
+    setup.outputStyle = BenchmarkSetup::OneLine;
+    Benchmark b(setup);
+    std::ostringstream out;
+    b.setOutput(&out);
+    b.run([](benchmark::detail::RunState &state) {
+        char *data = (char *)state.memory().allocate(64, 1);
+        MEASURE(REPEAT(1000) { benchmark::DoNotOptimize(data[0]); })
+    });
+    ASSERT_EQ(b.results().size(), 3u);
+    ASSERT_EQ(b.results()[0].layout, "layout 0 (default)");
+    ASSERT_EQ(b.results()[2].layout, memoryLayout(2).description());
+    // every block's title names its layout
+    ASSERT_NE(out.str().find(" | " + memoryLayout(2).description() + "]"), std::string::npos);
+}
+
+TEST(Main, TraceAllocations)
+{
+    std::string path = ::testing::TempDir() + "benchmark_trace_test.json";
+    benchmark::detail::TraceWriter trace(path);
+    Benchmark b(bs);
+    b.setTrace(&trace);
+    b.run([](benchmark::detail::RunState &state) {
+        MEASURE({
+            for (int i = 0; i < 3; i++)
+                benchmark::DoNotOptimize(state.memory().allocate(64));
+        })
+    });
+    ASSERT_TRUE(trace.save());
+
+    // a counter track of what every sample took from state.memory()
+    std::ifstream in(path);
+    std::string json((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    ASSERT_NE(json.find("{\"name\":\"Allocations\",\"ph\":\"C\""), std::string::npos);
+    ASSERT_NE(json.find("\"args\":{\"count\":3}"), std::string::npos);
+    ASSERT_NE(json.find("\"args\":{\"bytes\":192}"), std::string::npos);
+    std::remove(path.c_str());
+}
+
+TEST(Main, CoreLatency)
+{
+    // two sockets of two cores with two threads each
+    std::vector<benchmark::detail::LogicalCpu> cpus = {{0, 0, 0, 0, 0}, {1, 0, 0, 0, 0}, {2, 0, 2, 0, 0},
+                                                       {3, 0, 2, 0, 0}, {4, 1, 4, 4, 1}, {5, 1, 4, 4, 1},
+                                                       {6, 1, 6, 4, 1}, {7, 1, 6, 4, 1}};
+    benchmark::detail::CoreLatencyMatrix matrix;
+    matrix.cpus = cpus;
+    matrix.samples.assign(cpus.size(), std::vector<benchmark::detail::CoreLatencySample>(cpus.size()));
+    const double latencies[] = {8, 40, 0, 120};
+    for (size_t a = 0; a < cpus.size(); a++) {
+        for (size_t b = 0; b < cpus.size(); b++) {
+            double ns = a == b ? NAN : latencies[benchmark::detail::coreRelation(cpus[a], cpus[b])] + (a + b) % 3;
+            matrix.samples[a][b] = benchmark::detail::CoreLatencySample{ns, ns, ns, ns, 0};
+        }
+    }
+
+    std::vector<benchmark::detail::CoreLatencySample> relations = matrix.byRelation();
+    ASSERT_NEAR(relations[benchmark::detail::RelationSMT].median, 9, 1.5);
+    ASSERT_NEAR(relations[benchmark::detail::RelationL3].median, 41, 1.5);
+    ASSERT_TRUE(std::isnan(relations[benchmark::detail::RelationSocket].median));
+    ASSERT_NEAR(relations[benchmark::detail::RelationRemote].median, 121, 1.5);
+
+    // siblings, then sockets
+    std::vector<benchmark::detail::LatencyLevel> levels = matrix.levels();
+    ASSERT_EQ(levels.size(), 2u);
+    ASSERT_EQ(levels[0].clusters.size(), 4u);
+    ASSERT_EQ(levels[0].clusters[1], (std::vector<int>{2, 3}));
+    ASSERT_EQ(levels[1].clusters.size(), 2u);
+    ASSERT_EQ(levels[1].clusters[1], (std::vector<int>{4, 5, 6, 7}));
+
+    // a real pair, if there are two cpus to pin to
+    std::vector<benchmark::detail::LogicalCpu> topology = benchmark::detail::readTopology();
+    if (topology.size() >= 2) {
+        topology.resize(2);
+        benchmark::detail::CoreLatencyMatrix measured = benchmark::detail::measureCoreLatency(topology, 3, 100);
+        ASSERT_GT(measured.at(0, 1), 0);
+        ASSERT_EQ(measured.at(0, 1), measured.at(1, 0));
+    }
+}
+
+TEST(Main, Energy)
+{
+    using benchmark::detail::EnergyMeter;
+    ASSERT_EQ(EnergyMeter::difference(100, 250, 1000), 150u);
+    ASSERT_EQ(EnergyMeter::difference(900, 50, 1000), 150u); // wrapped
+
+    // a fake powercap tree: package 0 with a dram subzone, package 1 which can't be read
+    std::string root = "/tmp/benchmark_test_powercap";
+    auto write = [](const std::string &path, const std::string &text) {
+        FILE *fh = std::fopen(path.c_str(), "w");
+        ASSERT_NE(fh, nullptr);
+        std::fputs(text.c_str(), fh);
+        std::fclose(fh);
+    };
+    ASSERT_EQ(std::system(("rm -rf " + root + " && mkdir -p " + root + "/intel-rapl:0/intel-rapl:0:0 " + root +
+                           "/intel-rapl:1").c_str()), 0);
+    write(root + "/intel-rapl:0/name", "package-0\n");
+    write(root + "/intel-rapl:0/energy_uj", "999000000\n");
+    write(root + "/intel-rapl:0/max_energy_range_uj", "1000000000\n");
+    write(root + "/intel-rapl:0/intel-rapl:0:0/name", "dram\n");
+    write(root + "/intel-rapl:0/intel-rapl:0:0/energy_uj", "1000\n");
+    write(root + "/intel-rapl:0/intel-rapl:0:0/max_energy_range_uj", "1000000000\n");
+    write(root + "/intel-rapl:1/name", "package-1\n");
+
+    std::vector<benchmark::detail::RaplDomain> domains = benchmark::detail::readRaplDomains(root);
+    ASSERT_EQ(domains.size(), 2u);
+    ASSERT_EQ(domains[1].name, "package-0/dram");
+
+    EnergyMeter meter(domains);
+    meter.begin();
+    write(root + "/intel-rapl:0/energy_uj", "1000000\n"); // 2 J, over the wrap
+    write(root + "/intel-rapl:0/intel-rapl:0:0/energy_uj", "501000\n");
+    meter.end();
+    std::vector<benchmark::detail::EnergyUsage> usage = meter.usage();
+    ASSERT_EQ(usage.size(), 2u);
+    ASSERT_NEAR(usage[0].joules, 2.0, 1e-9);
+    ASSERT_NEAR(usage[1].joules, 0.5, 1e-9);
+    ASSERT_GT(usage[0].watts, 0);
+
+    // a counter that goes away drops out
+    std::remove((root + "/intel-rapl:0/intel-rapl:0:0/energy_uj").c_str());
+    meter.begin();
+    meter.end();
+    ASSERT_EQ(meter.usage().size(), 1u);
+    ASSERT_EQ(std::system(("rm -rf " + root).c_str()), 0);
+
+    ASSERT_FALSE(EnergyMeter(benchmark::detail::readRaplDomains(root)).available());
+}
+
+TEST(Zones, Collect)
+{
+    auto work = []() {
+        for (int i = 0; i < 100; i++) {
+            BENCHMARK_ZONE("test zone");
+            std::this_thread::sleep_for(std::chrono::microseconds(10));
+        }
+    };
+    std::thread t1(work), t2(work);
+    t1.join();
+    t2.join();
+
+    benchmark::zones::Collector collector;
+    collector.collect();
+
+    auto zone = std::find_if(collector.zones().begin(), collector.zones().end(),
+                             [](const benchmark::zones::ZoneReport &r) { return r.name == "test zone"; });
+    ASSERT_NE(zone, collector.zones().end());
+    ASSERT_EQ(zone->count, 200u);
+    ASSERT_GE(zone->stats.minimalTime(), std::chrono::microseconds(10));
+    ASSERT_GE(zone->minimum, std::chrono::microseconds(10));
+    ASSERT_EQ(zone->stats.size(), 200u);
+    ASSERT_EQ(collector.dropped(), 0u);
+
+    collector.reset();
+    collector.collect();
+    ASSERT_EQ(zone->count, 0u);
+
+    // threads finishing while the collector runs lose nothing, the last events of a thread are drained before its
+    // buffer goes
+    std::atomic<int> running{4};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; i++) {
+        threads.emplace_back([&running]() {
+            for (int j = 0; j < 1000; j++) {
+                BENCHMARK_ZONE("racing zone");
+            }
+            running--;
+        });
+    }
+    while (running > 0)
+        collector.collect();
+    for (auto &t : threads)
+        t.join();
+    collector.collect();
+    auto racing = std::find_if(collector.zones().begin(), collector.zones().end(),
+                               [](const benchmark::zones::ZoneReport &r) { return r.name == "racing zone"; });
+    ASSERT_NE(racing, collector.zones().end());
+    ASSERT_EQ(racing->count + collector.dropped(), 4000u);
+
+    // a long-running collector keeps every call in the count but only a reservoir of the durations
+    benchmark::zones::Collector longRunning;
+    for (int round = 0; round < 3; round++) {
+        for (int j = 0; j < 3000; j++) {
+            BENCHMARK_ZONE("busy zone");
+        }
+        longRunning.collect();
+    }
+    auto busy = std::find_if(longRunning.zones().begin(), longRunning.zones().end(),
+                             [](const benchmark::zones::ZoneReport &r) { return r.name == "busy zone"; });
+    ASSERT_NE(busy, longRunning.zones().end());
+    ASSERT_EQ(busy->count, 9000u);
+    ASSERT_EQ(busy->reservoir.size(), (size_t)BENCHMARK_ZONE_RESERVOIR_SIZE);
+    ASSERT_EQ(std::accumulate(busy->histogram.begin(), busy->histogram.end(), (uint64_t)0), 9000u);
+
+    // collectors on several threads take turns, no event is drained twice
+    std::atomic<bool> producing{true};
+    std::thread producer([&producing]() {
+        for (int j = 0; j < 20000; j++) {
+            BENCHMARK_ZONE("shared zone");
+            if (j % 1000 == 0)
+                std::this_thread::yield();
+        }
+        producing = false;
+    });
+    std::vector<benchmark::zones::Collector> collectors(3);
+    std::vector<std::thread> collecting;
+    for (auto &c : collectors) {
+        collecting.emplace_back([&c, &producing]() {
+            while (producing)
+                c.collect();
+            c.collect();
+        });
+    }
+    producer.join();
+    for (auto &t : collecting)
+        t.join();
+    uint64_t calls = 0;
+    for (auto &c : collectors) {
+        for (auto &report : c.zones()) {
+            if (report.name == "shared zone") {
+                calls += report.count;
+                // the percentiles are of a bounded reservoir, the count and the extremes of every call
+                ASSERT_LE(report.reservoir.size(), (size_t)BENCHMARK_ZONE_RESERVOIR_SIZE);
+                ASSERT_EQ(report.stats.size(), report.reservoir.size());
+                if (report.count > 0) {
+                    ASSERT_LE(report.minimum, report.stats.minimalTime());
+                    ASSERT_GE(report.maximum, report.stats.maximalTime());
+                }
+            }
+        }
+        calls += c.dropped();
+    }
+    ASSERT_EQ(calls, 20000u);
+}
+
+TEST(Main, PairedComparison)
+{
+    // every difference positive: the smallest p the normal approximation gives for 20 pairs
+    std::vector<double> a, b;
+    for (int i = 0; i < 20; i++) {
+        a.push_back(120 + i % 5);
+        b.push_back(100 + i % 7);
+    }
+    benchmark::detail::PairedComparison faster = benchmark::detail::comparePaired(a, b, 1000, 0.95, 42);
+    ASSERT_EQ(faster.pairs, 20u);
+    ASSERT_LT(faster.pValue, 0.001);
+    ASSERT_NEAR(faster.ratio, 122.0 / 103.0, 0.01);
+    ASSERT_TRUE(faster.interval.valid);
+    ASSERT_GT(faster.interval.lower, 1);
+    ASSERT_TRUE(benchmark::detail::significant(faster));
+    ASSERT_EQ(benchmark::detail::comparisonVerdict("A", "B", faster).find("B is 1.18x faster"), 0u);
+
+    benchmark::detail::PairedComparison slower = benchmark::detail::comparePaired(b, a, 1000, 0.95, 42);
+    ASSERT_EQ(benchmark::detail::comparisonVerdict("A", "B", slower).find("B is 1.18x slower"), 0u);
+
+    // alternating signs of the same magnitudes
+    std::vector<double> differences;
+    for (int i = 0; i < 20; i++)
+        differences.push_back(i % 2 ? i / 2 + 1 : -(i / 2 + 1));
+    ASSERT_GT(benchmark::detail::wilcoxonSignedRank(differences), 0.9);
+    ASSERT_EQ(benchmark::detail::wilcoxonSignedRank(std::vector<double>(10, 0.0)), 1.0);
+
+    benchmark::detail::PairedComparison same = benchmark::detail::comparePaired(a, a, 1000, 0.95, 42);
+    ASSERT_FALSE(benchmark::detail::significant(same));
+    ASSERT_EQ(benchmark::detail::comparisonVerdict("A", "B", same).find("no significant difference between A and B"), 0u);
+}
+
+BENCHMARK(CompareSlow)
+{
+    MEASURE(std::this_thread::sleep_for(std::chrono::microseconds(400));)
+}
+
+BENCHMARK(CompareFast)
+{
+    ADD_ARG_RANGE(1, 2);
+    MEASURE(std::this_thread::sleep_for(std::chrono::microseconds(50));)
+}
+
+TEST(Main, Compare)
+{
+    CompareBenchmark compare("CompareSlow, CompareFast");
+    ASSERT_EQ(compare.name(), "CompareSlow vs CompareFast");
+    ASSERT_TRUE(compare.compares("CompareFast"));
+    ASSERT_FALSE(compare.compares("Compare"));
+
+    Benchmark *slow = BenchmarkSilo::find("CompareSlow");
+    Benchmark *fast = BenchmarkSilo::find("CompareFast");
+    ASSERT_NE(slow, nullptr);
+    ASSERT_NE(fast, nullptr);
+    compare.setSetup(bs);
+    slow->setSetup(bs);
+    fast->setSetup(bs);
+    compare.vrun();
+
+    // the shorter sweep of the two, which is one combination
+    ASSERT_EQ(slow->results().size(), 1u);
+    ASSERT_EQ(fast->results().size(), 1u);
+    ASSERT_EQ(slow->results()[0].iterations, fast->results()[0].iterations);
+    ASSERT_TRUE(slow->results()[0].comparison.empty());
+    ASSERT_EQ(fast->results()[0].comparison.find("CompareFast is "), 0u);
+    ASSERT_NE(fast->results()[0].comparison.find("faster"), std::string::npos);
+}
+
+BENCHMARK_GROUP(Sleeps, CompareSlow, CompareFast)
+
+TEST(Main, Groups)
+{
+    auto groups = BenchmarkSilo::groups();
+    auto sleeps = std::find_if(groups.begin(), groups.end(),
+                               [](const benchmark::detail::BenchmarkGroup &g) { return g.name == "Sleeps"; });
+    ASSERT_NE(sleeps, groups.end());
+    ASSERT_EQ(sleeps->members.size(), 2u);
+    ASSERT_EQ(sleeps->members[0].label, "CompareSlow");
+    ASSERT_EQ(sleeps->members[1].name, "CompareFast");
+
+    auto result = [](const char *name, int arg, int ns) {
+        benchmark::detail::BenchmarkResult r{};
+        r.name = name;
+        r.hasArg = true;
+        r.arg = arg;
+        r.median = std::chrono::nanoseconds(ns);
+        r.medianInterval = {ns * 0.95, ns * 1.05, true};
+        return r;
+    };
+    benchmark::detail::BenchmarkGroup group{"Traversal", {}};
+    group.members.push_back(
+        {"list", "Traversal<list>", {result("Traversal<list>", 8, 120), result("Traversal<list>", 16, 230)}});
+    group.members.push_back(
+        {"vector", "Traversal<vector>", {result("Traversal<vector>", 8, 40), result("Traversal<vector>", 32, 50)}});
+    group.members.push_back({"deque", "Traversal<deque>", {result("Traversal<deque>", 8, 118)}});
+
+    ASSERT_EQ(group.rows(), (std::vector<std::string>{"$1=8", "$1=16", "$1=32"}));
+    ASSERT_EQ(group.find(1, "$1=16"), nullptr);
+    ASSERT_NEAR(benchmark::detail::speedup(*group.find(0, "$1=8"), *group.find(1, "$1=8")), 3.0, 1e-9);
+    ASSERT_EQ(benchmark::detail::significance(*group.find(0, "$1=8"), *group.find(1, "$1=8")), 1);
+    ASSERT_EQ(benchmark::detail::significance(*group.find(0, "$1=8"), *group.find(2, "$1=8")), 0);
+
+    std::ostringstream table;
+    benchmark::detail::groupTable(group).print(table);
+    ASSERT_NE(table.str().find("list (baseline)"), std::string::npos);
+    ASSERT_NE(table.str().find("(3.00x)"), std::string::npos);
+    ASSERT_NE(table.str().find("(1.02x)"), std::string::npos);
+
+    std::string path = ::testing::TempDir() + "benchmark_groups_test.json";
+    ASSERT_TRUE(benchmark::detail::writeJsonReport(path, group.members[0].results, {group}));
+    std::ifstream file(path);
+    std::string json((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    ASSERT_NE(json.find("\"name\": \"Traversal<list>\", \"arg\": 16"), std::string::npos);
+    ASSERT_NE(json.find("\"baseline\": \"list\""), std::string::npos);
+    ASSERT_NE(json.find("\"median_ns\": 40, \"speedup\": 3, \"significant\": true"), std::string::npos);
+    // the vector has no result for 16, the list none for 32
+    ASSERT_NE(json.find("\"row\": \"$1=16\", \"arg\": 16, \"antagonist\": \"\", \"layout\": \"\", \"cells\": [{"),
+              std::string::npos);
+    ASSERT_NE(json.find("\"row\": \"$1=32\", \"arg\": 32, \"antagonist\": \"\", \"layout\": \"\", \"cells\": [null, {"),
+              std::string::npos);
+    std::remove(path.c_str());
+}
+
+TEST(Main, SplitTypeList)
+{
+    using benchmark::detail::splitTypeList;
+    ASSERT_EQ(splitTypeList("std::map<int, int>, std::vector<int>"),
+              std::vector<std::string>({"std::map<int, int>", "std::vector<int>"}));
+    ASSERT_EQ(splitTypeList("int"), std::vector<std::string>({"int"}));
+    ASSERT_EQ(splitTypeList("  int ,  float  "), std::vector<std::string>({"int", "float"}));
+    // commas of template arguments, function types and array bounds don't split
+    ASSERT_EQ(splitTypeList("std::function<void(int, int)>, std::array<char, 4>, Matrix<int[2], 3>"),
+              std::vector<std::string>({"std::function<void(int, int)>", "std::array<char, 4>", "Matrix<int[2], 3>"}));
+}
+
+BENCHMARK_TEMPLATE(TemplateContainers, std::map<int, int>, std::vector<int>)
+{
+    T container;
+    MEASURE(benchmark::DoNotOptimize(container.size());)
+}
+
+TEST(Main, TemplateRegistrar)
+{
+    Benchmark *map = BenchmarkSilo::find("TemplateContainers<std::map<int, int>>");
+    Benchmark *vector = BenchmarkSilo::find("TemplateContainers<std::vector<int>>");
+    ASSERT_NE(map, nullptr);
+    ASSERT_NE(vector, nullptr);
+    ASSERT_EQ(map->group(), "TemplateContainers");
+    ASSERT_EQ(vector->group(), "TemplateContainers");
+    ASSERT_EQ(map->groupLabel(), "std::map<int, int>");
+    ASSERT_EQ(vector->groupLabel(), "std::vector<int>");
+    // the first type is the baseline of the table
+    ASSERT_TRUE(map->groupBaseline());
+    ASSERT_FALSE(vector->groupBaseline());
+
+    auto groups = BenchmarkSilo::groups();
+    auto containers = std::find_if(groups.begin(), groups.end(), [](const benchmark::detail::BenchmarkGroup &g) {
+        return g.name == "TemplateContainers";
+    });
+    ASSERT_NE(containers, groups.end());
+    ASSERT_EQ(containers->members.size(), 2u);
+    ASSERT_EQ(containers->members[0].label, "std::map<int, int>");
+}
+
 TEST(Main, StdDeviation)
 {
     Benchmark b(bs);
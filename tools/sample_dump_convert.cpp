@@ -0,0 +1,92 @@
+// Converts a raw sample dump written with --dump to CSV or JSON
+//
+// sample_dump_convert samples.bin [--csv|--json] > samples.csv
+
+#include <benchmark/sample_dump_reader.h>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+static void printValue(const benchmark::SampleDumpReader &dump, unsigned column, uint64_t row, const char *null) {
+    double value = dump.value(column, row);
+    if (std::isnan(value)) {
+        std::printf("%s", null);
+    } else if (dump.columnType(column) == benchmark::detail::ColumnDouble) {
+        std::printf("%.17g", value);
+    } else {
+        std::printf("%.0f", value);
+    }
+}
+
+static void printString(const std::string &text, bool json) {
+    std::putchar('"');
+    for (char c : text) {
+        if (c == '"')
+            std::printf(json ? "\\\"" : "\"\"");
+        else if (json && c == '\\')
+            std::printf("\\\\");
+        else
+            std::putchar(c);
+    }
+    std::putchar('"');
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "Usage: %s samples.bin [--csv|--json]\n", argv[0]);
+        return 1;
+    }
+    bool json = argc > 2 && std::strcmp(argv[2], "--json") == 0;
+
+    benchmark::SampleDumpReader dump(argv[1]);
+    if (!dump.valid())
+        return 1;
+    if (!dump.complete())
+        std::fprintf(stderr, "Warning: the dump wasn't closed, block and counter names are missing\n");
+    if (dump.dropped() > 0)
+        std::fprintf(stderr, "Warning: %llu samples didn't fit into the dump\n", (unsigned long long)dump.dropped());
+
+    // unused counter columns are left out
+    std::vector<unsigned> columns;
+    for (unsigned c = 0; c < dump.columnCount(); c++) {
+        if (c < benchmark::detail::DumpCounter0 || !dump.columnName(c).empty())
+            columns.push_back(c);
+    }
+    if (!dump.complete()) {
+        columns.resize(benchmark::detail::DumpCounter0);
+    }
+
+    if (json) {
+        std::printf("{\"startTime\":%lld,\"samples\":[", (long long)dump.startTime());
+    } else {
+        for (size_t i = 0; i < columns.size(); i++) {
+            std::printf(i ? "," : "");
+            printString(dump.columnName(columns[i]), false);
+        }
+        std::printf("\n");
+    }
+
+    for (uint64_t row = 0; row < dump.rows(); row++) {
+        std::printf(json ? (row ? ",\n{" : "\n{") : "");
+        for (size_t i = 0; i < columns.size(); i++) {
+            unsigned column = columns[i];
+            std::printf(i ? "," : "");
+            if (json) {
+                printString(dump.columnName(column), true);
+                std::printf(":");
+            }
+            if (column == benchmark::detail::DumpBlock) {
+                printString(dump.blockName(dump.value(column, row)), json);
+            } else {
+                printValue(dump, column, row, json ? "null" : "");
+            }
+        }
+        std::printf(json ? "}" : "\n");
+    }
+
+    if (json)
+        std::printf("\n]}\n");
+    return 0;
+}